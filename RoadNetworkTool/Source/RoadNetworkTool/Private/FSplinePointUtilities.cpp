@@ -189,6 +189,21 @@ namespace SplineUtilities
 
 
 	TArray<FVector> GetSplinePointsBetweenLocations(USplineComponent* SplineComponent, float DistanceBetweenPoints, const FVector& StartLocation, const FVector& EndLocation)
+	{
+		if (SplineComponent == nullptr)
+		{
+			return TArray<FVector>();
+		}
+
+		// Find the closest spline input keys to the start and end locations
+		float StartKey = SplineComponent->FindInputKeyClosestToWorldLocation(StartLocation);
+		float EndKey = SplineComponent->FindInputKeyClosestToWorldLocation(EndLocation);
+
+		return GetSplinePointsBetweenInputKeys(SplineComponent, DistanceBetweenPoints, StartKey, EndKey);
+	}
+
+
+	TArray<FVector> GetSplinePointsBetweenInputKeys(USplineComponent* SplineComponent, float DistanceBetweenPoints, float StartKey, float EndKey)
 	{
 		TArray<FVector> SplinePoints;
 
@@ -198,12 +213,6 @@ namespace SplineUtilities
 			return SplinePoints;
 		}
 
-		float SplineLength = SplineComponent->GetSplineLength();
-
-		// Find the closest spline input keys to the start and end locations
-		float StartKey = SplineComponent->FindInputKeyClosestToWorldLocation(StartLocation);
-		float EndKey = SplineComponent->FindInputKeyClosestToWorldLocation(EndLocation);
-
 		// Ensure start key is always less than end key for proper sampling
 		bool bReverseOrder = StartKey > EndKey;
 		if (bReverseOrder)
@@ -261,4 +270,4 @@ namespace SplineUtilities
 
 		return StraightPoints;
 	}
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,21 +1,193 @@
 #include "Quadtree.h"
+#include "SplineSpatialQueries.h"
+#include "DrawDebugHelpers.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include <cmath>
+
+using namespace SplineSpatialQueries;
+
+namespace
+{
+    // Number of floats in one packed block of four entry bounds
+    constexpr int32 PackedBlockSize = 16;
+
+    float RoundDownToFloat(double Value)
+    {
+        const float Result = static_cast<float>(FMath::Clamp(Value, -static_cast<double>(MAX_flt), static_cast<double>(MAX_flt)));
+        return static_cast<double>(Result) > Value ? std::nextafter(Result, -MAX_flt) : Result;
+    }
+
+    float RoundUpToFloat(double Value)
+    {
+        const float Result = static_cast<float>(FMath::Clamp(Value, -static_cast<double>(MAX_flt), static_cast<double>(MAX_flt)));
+        return static_cast<double>(Result) < Value ? std::nextafter(Result, MAX_flt) : Result;
+    }
+
+    void WritePackedLane(TArray<float>& PackedBounds, int32 Slot, float MinX, float MinY, float MaxX, float MaxY)
+    {
+        float* Block = PackedBounds.GetData() + (Slot / 4) * PackedBlockSize;
+        const int32 Lane = Slot % 4;
+        Block[Lane] = MinX;
+        Block[4 + Lane] = MinY;
+        Block[8 + Lane] = MaxX;
+        Block[12 + Lane] = MaxY;
+    }
+
+    // Empty lanes can never overlap a query box
+    void ClearPackedLane(TArray<float>& PackedBounds, int32 Slot)
+    {
+        WritePackedLane(PackedBounds, Slot, MAX_flt, MAX_flt, -MAX_flt, -MAX_flt);
+    }
+
+    // Float query box rounded outwards, broadcast to every lane, so the packed test never misses an exact hit
+    struct FPackedQueryBox
+    {
+        VectorRegister4Float MinX;
+        VectorRegister4Float MinY;
+        VectorRegister4Float MaxX;
+        VectorRegister4Float MaxY;
+
+        explicit FPackedQueryBox(const FBox2D& Box)
+            : MinX(VectorSetFloat1(RoundDownToFloat(Box.Min.X)))
+            , MinY(VectorSetFloat1(RoundDownToFloat(Box.Min.Y)))
+            , MaxX(VectorSetFloat1(RoundUpToFloat(Box.Max.X)))
+            , MaxY(VectorSetFloat1(RoundUpToFloat(Box.Max.Y))) {}
+
+        // Returns one bit per lane of the block whose box overlaps the query box
+        uint32 OverlapMask(const float* Block) const
+        {
+            const VectorRegister4Float OverlapX = VectorBitwiseAnd(
+                VectorCompareLE(VectorLoad(Block), MaxX),
+                VectorCompareGE(VectorLoad(Block + 8), MinX));
+            const VectorRegister4Float OverlapY = VectorBitwiseAnd(
+                VectorCompareLE(VectorLoad(Block + 4), MaxY),
+                VectorCompareGE(VectorLoad(Block + 12), MinY));
+            return static_cast<uint32>(VectorMaskBits(VectorBitwiseAnd(OverlapX, OverlapY)));
+        }
+    };
+
+    // Spreads the lower 16 bits of a value over the even bits of the result
+    uint32 SpreadBits16(uint32 Value)
+    {
+        Value &= 0x0000FFFF;
+        Value = (Value | (Value << 8)) & 0x00FF00FF;
+        Value = (Value | (Value << 4)) & 0x0F0F0F0F;
+        Value = (Value | (Value << 2)) & 0x33333333;
+        Value = (Value | (Value << 1)) & 0x55555555;
+        return Value;
+    }
+
+    // Z-order code of a point quantized to 16 bits per axis inside the given bounds
+    uint32 MortonCode2D(const FVector2D& Point, const FBox2D& Bounds)
+    {
+        const FVector2D Size = Bounds.GetSize();
+        const double NormalizedX = Size.X > 0.0 ? FMath::Clamp((Point.X - Bounds.Min.X) / Size.X, 0.0, 1.0) : 0.0;
+        const double NormalizedY = Size.Y > 0.0 ? FMath::Clamp((Point.Y - Bounds.Min.Y) / Size.Y, 0.0, 1.0) : 0.0;
+        const uint32 CellX = static_cast<uint32>(NormalizedX * 65535.0);
+        const uint32 CellY = static_cast<uint32>(NormalizedY * 65535.0);
+        return SpreadBits16(CellX) | (SpreadBits16(CellY) << 1);
+    }
+}
 
 // ---------- Constructor ---------
 FQuadtree::FQuadtree(const FBox2D& InWorldBounds, int32 InMaxSplinesPerNode, int32 InMaxDepth)
-    : MaxSplinesPerNode(InMaxSplinesPerNode), MaxDepth(InMaxDepth)
+    : QueryEpoch(0), MaxSplinesPerNode(FMath::Max(1, InMaxSplinesPerNode)), MaxDepth(InMaxDepth), bVisualizeQuadtree(false)
+    , bUseVectorLeafScan(PLATFORM_ENABLE_VECTORINTRINSICS != 0)
 {
-    RootNode = MakeShared<FQuadtreeNode>(InWorldBounds);
+    Nodes.Emplace(InWorldBounds, INDEX_NONE, 0);
 }
 
 // ---------- Public Methods ---------
 void FQuadtree::InsertSplineComponent(USplineComponent* SplineComponent)
 {
-    InsertSplineIntoNode(RootNode, SplineComponent, 0);
+    if (!SplineComponent)
+    {
+        return;
+    }
+
+    if (SplineToEntry.Contains(SplineComponent))
+    {
+        UpdateSplineComponent(SplineComponent);
+        return;
+    }
+
+    // Bounds are computed once here and cached, queries never touch the component again
+    int32 EntryId = AllocateEntry(SplineComponent, CalcSplineBounds(SplineComponent));
+    InsertEntryIntoNode(RootIndex, EntryId);
+}
+
+void FQuadtree::BulkLoad(const TArray<USplineComponent*>& SplineComponents)
+{
+    Clear();
+
+    TArray<USplineComponent*> ValidSplines;
+    ValidSplines.Reserve(SplineComponents.Num());
+    for (USplineComponent* SplineComponent : SplineComponents)
+    {
+        if (SplineComponent && !SplineToEntry.Contains(SplineComponent))
+        {
+            SplineToEntry.Add(SplineComponent, ValidSplines.Add(SplineComponent));
+        }
+    }
+
+    const int32 NumEntries = ValidSplines.Num();
+    if (NumEntries == 0)
+    {
+        return;
+    }
+
+    // Bounds and Morton codes of every spline are independent, compute them on worker threads
+    const FBox2D RootBounds = Nodes[RootIndex].Bounds;
+    TArray<FBox2D> Bounds;
+    TArray<FSplineZRange> ZRanges;
+    TArray<uint64> SortKeys;
+    Bounds.SetNumUninitialized(NumEntries);
+    ZRanges.SetNumUninitialized(NumEntries);
+    SortKeys.SetNumUninitialized(NumEntries);
+
+    ParallelFor(NumEntries, [&](int32 EntryId)
+        {
+            const FBox SplineBox = CalcSplineBounds(ValidSplines[EntryId]);
+            Bounds[EntryId] = FBox2D(FVector2D(SplineBox.Min.X, SplineBox.Min.Y), FVector2D(SplineBox.Max.X, SplineBox.Max.Y));
+            ZRanges[EntryId] = FSplineZRange(SplineBox.Min.Z, SplineBox.Max.Z);
+            SortKeys[EntryId] = (static_cast<uint64>(MortonCode2D(Bounds[EntryId].GetCenter(), RootBounds)) << 32) | static_cast<uint32>(EntryId);
+        });
+
+    EntrySplines = MoveTemp(ValidSplines);
+    EntryBounds = MoveTemp(Bounds);
+    EntryZRanges = MoveTemp(ZRanges);
+    EntryLeaves.SetNum(NumEntries);
+
+    // Sorting by Z-order keeps entries of the same subtree together in every leaf list
+    SortKeys.Sort();
+
+    TArray<int32> SortedEntries;
+    SortedEntries.SetNumUninitialized(NumEntries);
+    for (int32 i = 0; i < NumEntries; i++)
+    {
+        SortedEntries[i] = static_cast<int32>(SortKeys[i] & 0xFFFFFFFF);
+    }
+
+    int32 NumOverfullLeaves = 0;
+    BuildNode(RootIndex, SortedEntries, NumOverfullLeaves);
+
+    if (NumOverfullLeaves > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Maximum depth reached for quadtree without subdividing further in %d leaves."), NumOverfullLeaves);
+    }
 }
 
 void FQuadtree::RemoveSplineComponent(USplineComponent* SplineComponent)
 {
-    RemoveSplineFromNode(RootNode, SplineComponent);
+    int32 EntryId = INDEX_NONE;
+    if (!SplineToEntry.RemoveAndCopyValue(SplineComponent, EntryId))
+    {
+        return;
+    }
+
+    RemoveEntryFromNodes(EntryId);
+    ReleaseEntry(EntryId);
 }
 
 void FQuadtree::UpdateSplineComponent(USplineComponent* SplineComponent)
@@ -27,22 +199,125 @@ void FQuadtree::UpdateSplineComponent(USplineComponent* SplineComponent)
     }
 }
 
-void FQuadtree::QuerySplinesInArea(const FBox2D& Area, TArray<USplineComponent*>& OutSplines) const
+bool FQuadtree::VisitSplinesInArea(const FBox2D& Area, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange) const
 {
-    QueryNodeSplinesInArea(RootNode, Area, OutSplines);
+    return VisitSplinesInShape(FBoxQueryShape{ Area }, ZRange, Visitor);
 }
 
-void FQuadtree::Clear()
+bool FQuadtree::VisitSplinesInCircle(const FVector2D& Center, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange) const
 {
-    if (RootNode.IsValid())
+    return VisitSplinesInShape(FCircleQueryShape{ Center, Radius * Radius }, ZRange, Visitor);
+}
+
+bool FQuadtree::VisitSplinesInCapsule(const FVector2D& Start, const FVector2D& End, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange) const
+{
+    return VisitSplinesInShape(FCapsuleQueryShape(Start, End, Radius), ZRange, Visitor);
+}
+
+void FQuadtree::FindNearestSplines(const FVector2D& Point, int32 K, double MaxDistance, TArray<USplineComponent*>& OutSplines, FSplineDistanceSquaredFunction DistanceSquaredFn) const
+{
+    if (K <= 0)
+    {
+        return;
+    }
+
+    const double MaxDistanceSquared = MaxDistance < TNumericLimits<double>::Max() ? FMath::Square(MaxDistance) : TNumericLimits<double>::Max();
+    const int32 NumFound = OutSplines.Num();
+
+    // Nodes and entries are keyed by the distance to their bounds, exact items by the refined distance.
+    // An exact item reaching the top of the queue is closer than anything still waiting in it.
+    TArray<FNearestQueueItem, TInlineAllocator<64>> Queue;
+    TBitArray<> VisitedEntries(false, EntrySplines.Num());
+
+    Queue.HeapPush({ BoxDistanceSquared(Nodes[RootIndex].Bounds, Point), RootIndex, FNearestQueueItem::EType::Node });
+
+    while (Queue.Num() > 0)
     {
-        ClearNode(RootNode);
+        FNearestQueueItem Item;
+        Queue.HeapPop(Item, EAllowShrinking::No);
+
+        if (Item.DistanceSquared > MaxDistanceSquared)
+        {
+            break;
+        }
+
+        if (Item.Type == FNearestQueueItem::EType::Exact)
+        {
+            OutSplines.Add(EntrySplines[Item.Index]);
+            if (OutSplines.Num() - NumFound >= K)
+            {
+                break;
+            }
+        }
+        else if (Item.Type == FNearestQueueItem::EType::Entry)
+        {
+            const double ExactDistanceSquared = DistanceSquaredFn(EntrySplines[Item.Index]);
+            if (ExactDistanceSquared <= MaxDistanceSquared)
+            {
+                Queue.HeapPush({ FMath::Max(ExactDistanceSquared, Item.DistanceSquared), Item.Index, FNearestQueueItem::EType::Exact });
+            }
+        }
+        else
+        {
+            const FQuadtreeNode& Node = Nodes[Item.Index];
+            if (Node.IsLeafNode())
+            {
+                for (int32 i = 0; i < Node.EntryIds.Num(); i++)
+                {
+                    // A straddling spline is reached through several leaves but queued only once
+                    const int32 EntryId = Node.EntryIds[i];
+                    if (VisitedEntries[EntryId])
+                    {
+                        continue;
+                    }
+                    VisitedEntries[EntryId] = true;
+
+                    const double DistanceSquared = BoxDistanceSquared(Node.EntryBounds[i], Point);
+                    if (DistanceSquared <= MaxDistanceSquared)
+                    {
+                        Queue.HeapPush({ DistanceSquared, EntryId, FNearestQueueItem::EType::Entry });
+                    }
+                }
+            }
+            else
+            {
+                for (int32 i = 0; i < 4; i++)
+                {
+                    const double DistanceSquared = BoxDistanceSquared(Nodes[Node.FirstChild + i].Bounds, Point);
+                    if (DistanceSquared <= MaxDistanceSquared)
+                    {
+                        Queue.HeapPush({ DistanceSquared, Node.FirstChild + i, FNearestQueueItem::EType::Node });
+                    }
+                }
+            }
+        }
     }
 }
 
+void FQuadtree::Clear()
+{
+    FBox2D RootBounds = GetBounds();
+
+    Nodes.Reset();
+    FreeChildBlocks.Reset();
+    EntrySplines.Reset();
+    EntryBounds.Reset();
+    EntryZRanges.Reset();
+    EntryLeaves.Reset();
+    FreeEntries.Reset();
+    SplineToEntry.Reset();
+    EntryQueryStamps.Reset();
+
+    Nodes.Emplace(RootBounds, INDEX_NONE, 0);
+}
+
 void FQuadtree::GetAllSplines(TArray<USplineComponent*>& OutSplines) const
 {
-    CollectSplines(RootNode, OutSplines);
+    OutSplines.Reserve(OutSplines.Num() + SplineToEntry.Num());
+    for (const TPair<USplineComponent*, int32>& Pair : SplineToEntry)
+    {
+        OutSplines.Add(Pair.Key);
+    }
 }
 
 void FQuadtree::SetVisualizeQuadtree(bool bValue)
@@ -50,195 +325,532 @@ void FQuadtree::SetVisualizeQuadtree(bool bValue)
     bVisualizeQuadtree = bValue;
 }
 
+void FQuadtree::SetUseVectorLeafScan(bool bValue)
+{
+    bUseVectorLeafScan = bValue;
+}
+
 FBox2D FQuadtree::GetBounds() const
 {
-    return RootNode ? RootNode->Bounds : FBox2D();
+    return Nodes.Num() > 0 ? Nodes[RootIndex].Bounds : FBox2D();
+}
+
+int32 FQuadtree::GetNumNodes() const
+{
+    return Nodes.Num() - FreeChildBlocks.Num() * 4;
+}
+
+ESplineSpatialIndexType FQuadtree::GetType() const
+{
+    return ESplineSpatialIndexType::Quadtree;
+}
+
+int32 FQuadtree::GrowToContain(const FBox2D& Area)
+{
+    int32 NumLevelsGrown = 0;
+
+    // A root without extent cannot double, restart it around the area while nothing is stored yet
+    if (Nodes[RootIndex].Bounds.GetArea() <= 0.0 && SplineToEntry.Num() == 0)
+    {
+        const double Extent = FMath::Max(Area.GetExtent().GetMax(), 1.0);
+        Nodes[RootIndex].Bounds = FBox2D(Area.GetCenter() - FVector2D(Extent), Area.GetCenter() + FVector2D(Extent));
+        return NumLevelsGrown;
+    }
+
+    // Doubling 64 times covers any representable world, the cap only guards against invalid areas
+    const int32 MaxGrowLevels = 64;
+
+    while (!Nodes[RootIndex].Bounds.IsInside(Area) && NumLevelsGrown < MaxGrowLevels)
+    {
+        const FBox2D OldBounds = Nodes[RootIndex].Bounds;
+        const FVector2D Size = OldBounds.GetSize();
+
+        // Grow towards the side the area sticks out of, the old root ends up in the quadrant facing away from it.
+        // Containment is strict, so an area on the min edge also grows that way or the min would never move.
+        const bool bGrowNegativeX = Area.Min.X <= OldBounds.Min.X;
+        const bool bGrowNegativeY = Area.Min.Y <= OldBounds.Min.Y;
+        const int32 OldRootQuadrant = (bGrowNegativeX ? 1 : 0) | (bGrowNegativeY ? 2 : 0);
+
+        const FVector2D NewMin(bGrowNegativeX ? OldBounds.Min.X - Size.X : OldBounds.Min.X, bGrowNegativeY ? OldBounds.Min.Y - Size.Y : OldBounds.Min.Y);
+        const FBox2D NewBounds(NewMin, NewMin + Size * 2.0);
+
+        // Move the old root into a fresh child block, only its direct links need patching
+        const int32 FirstChild = AllocateChildBlock();
+        const int32 MovedRoot = FirstChild + OldRootQuadrant;
+        const int32 OldDepth = Nodes[RootIndex].Depth;
+
+        Nodes[MovedRoot] = MoveTemp(Nodes[RootIndex]);
+        Nodes[MovedRoot].Parent = RootIndex;
+
+        if (Nodes[MovedRoot].IsLeafNode())
+        {
+            for (int32 EntryId : Nodes[MovedRoot].EntryIds)
+            {
+                EntryLeaves[EntryId].RemoveSingleSwap(RootIndex, EAllowShrinking::No);
+                EntryLeaves[EntryId].Add(MovedRoot);
+            }
+        }
+        else
+        {
+            for (int32 i = 0; i < 4; i++)
+            {
+                Nodes[Nodes[MovedRoot].FirstChild + i].Parent = MovedRoot;
+            }
+        }
+
+        const FVector2D Center = NewBounds.GetCenter();
+        const FBox2D QuadrantBounds[4] =
+        {
+            FBox2D(NewBounds.Min, Center), // Bottom-Left
+            FBox2D(FVector2D(Center.X, NewBounds.Min.Y), FVector2D(NewBounds.Max.X, Center.Y)), // Bottom-Right
+            FBox2D(FVector2D(NewBounds.Min.X, Center.Y), FVector2D(Center.X, NewBounds.Max.Y)), // Top-Left
+            FBox2D(Center, NewBounds.Max) // Top-Right
+        };
+
+        for (int32 i = 0; i < 4; i++)
+        {
+            if (i != OldRootQuadrant)
+            {
+                Nodes[FirstChild + i] = FQuadtreeNode(QuadrantBounds[i], RootIndex, OldDepth);
+            }
+        }
+
+        Nodes[RootIndex] = FQuadtreeNode(NewBounds, INDEX_NONE, OldDepth - 1);
+        Nodes[RootIndex].FirstChild = FirstChild;
+
+        NumLevelsGrown++;
+    }
+
+    return NumLevelsGrown;
 }
 
 // ---------- Private Methods ---------
-void FQuadtree::InsertSplineIntoNode(TSharedPtr<FQuadtreeNode> Node, USplineComponent* SplineComponent, int32 CurrentDepth)
+uint32 FQuadtree::BeginQuery() const
+{
+    if (EntryQueryStamps.Num() < EntrySplines.Num())
+    {
+        EntryQueryStamps.SetNumZeroed(EntrySplines.Num());
+    }
+
+    // Stamps only need clearing when the epoch wraps around
+    if (++QueryEpoch == 0)
+    {
+        FMemory::Memzero(EntryQueryStamps.GetData(), EntryQueryStamps.Num() * sizeof(uint32));
+        QueryEpoch = 1;
+    }
+
+    return QueryEpoch;
+}
+
+template <typename ShapeType>
+bool FQuadtree::VisitSplinesInShape(const ShapeType& Shape, const FSplineZRange& ZRange, FSplineVisitorFunction Visitor) const
 {
-    // Calculate the bounds of the spline in world space
-    FBoxSphereBounds WorldBounds = SplineComponent->CalcBounds(SplineComponent->GetComponentTransform());
-    FVector SplineMin = WorldBounds.GetBox().Min;
-    FVector SplineMax = WorldBounds.GetBox().Max;
+    const uint32 Epoch = BeginQuery();
+    const FPackedQueryBox PackedQuery(Shape.GetBounds());
 
-    // Convert the bounding box to TBox2<double>
-    UE::Math::TBox2<double> SplineBounds(
-        FVector2d(SplineMin.X, SplineMin.Y),
-        FVector2d(SplineMax.X, SplineMax.Y)
-    );
+    TArray<int32, TInlineAllocator<64>> Stack;
+    Stack.Add(RootIndex);
+
+    while (Stack.Num() > 0)
+    {
+        const FQuadtreeNode& Node = Nodes[Stack.Pop(EAllowShrinking::No)];
+
+        // Check if the node's bounds intersect with the query shape
+        if (!Shape.Intersects(Node.Bounds))
+        {
+            continue;
+        }
+
+        if (Node.IsLeafNode())
+        {
+            const int32 NumEntries = Node.EntryIds.Num();
+            if (bUseVectorLeafScan)
+            {
+                // Test four packed float boxes at a time, only the lanes that pass get the exact test
+                for (int32 BlockStart = 0; BlockStart < NumEntries; BlockStart += 4)
+                {
+                    uint32 Mask = PackedQuery.OverlapMask(Node.PackedBounds.GetData() + BlockStart * 4);
+                    Mask &= NumEntries - BlockStart >= 4 ? 0xFu : (1u << (NumEntries - BlockStart)) - 1;
+
+                    while (Mask != 0)
+                    {
+                        const int32 Slot = BlockStart + static_cast<int32>(FMath::CountTrailingZeros(Mask));
+                        Mask &= Mask - 1;
+
+                        const int32 EntryId = Node.EntryIds[Slot];
+                        if (EntryQueryStamps[EntryId] == Epoch || !Shape.Intersects(Node.EntryBounds[Slot]))
+                        {
+                            continue;
+                        }
+
+                        // Stacked roads share the 2D footprint, drop the layers outside the vertical range
+                        EntryQueryStamps[EntryId] = Epoch;
+                        if (!EntryZRanges[EntryId].Overlaps(ZRange))
+                        {
+                            continue;
+                        }
+
+                        if (!Visitor(EntrySplines[EntryId]))
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                // Test the cached bounds of every entry in the leaf, skipping entries already reported from another leaf
+                for (int32 i = 0; i < NumEntries; i++)
+                {
+                    const int32 EntryId = Node.EntryIds[i];
+                    if (EntryQueryStamps[EntryId] == Epoch || !Shape.Intersects(Node.EntryBounds[i]))
+                    {
+                        continue;
+                    }
+
+                    EntryQueryStamps[EntryId] = Epoch;
+                    if (!EntryZRanges[EntryId].Overlaps(ZRange))
+                    {
+                        continue;
+                    }
+
+                    if (!Visitor(EntrySplines[EntryId]))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (int32 i = 0; i < 4; i++)
+            {
+                Stack.Add(Node.FirstChild + i);
+            }
+        }
+    }
+
+    return true;
+}
+
+int32 FQuadtree::AllocateEntry(USplineComponent* SplineComponent, const FBox& Bounds)
+{
+    const FBox2D Bounds2D(FVector2D(Bounds.Min.X, Bounds.Min.Y), FVector2D(Bounds.Max.X, Bounds.Max.Y));
+    const FSplineZRange ZRange(Bounds.Min.Z, Bounds.Max.Z);
+
+    int32 EntryId;
+    if (FreeEntries.Num() > 0)
+    {
+        EntryId = FreeEntries.Pop(EAllowShrinking::No);
+        EntrySplines[EntryId] = SplineComponent;
+        EntryBounds[EntryId] = Bounds2D;
+        EntryZRanges[EntryId] = ZRange;
+    }
+    else
+    {
+        EntryId = EntrySplines.Add(SplineComponent);
+        EntryBounds.Add(Bounds2D);
+        EntryZRanges.Add(ZRange);
+        EntryLeaves.AddDefaulted();
+    }
+
+    SplineToEntry.Add(SplineComponent, EntryId);
+    return EntryId;
+}
+
+void FQuadtree::ReleaseEntry(int32 EntryId)
+{
+    EntrySplines[EntryId] = nullptr;
+    EntryBounds[EntryId] = FBox2D(ForceInit);
+    EntryLeaves[EntryId].Reset();
+    FreeEntries.Add(EntryId);
+}
+
+bool FQuadtree::IsNodeInUse(int32 NodeIndex) const
+{
+    // Released nodes are reset and lose their parent, only the root legitimately has none
+    return NodeIndex == RootIndex || Nodes[NodeIndex].Parent != INDEX_NONE;
+}
+
+int32 FQuadtree::AllocateChildBlock()
+{
+    if (FreeChildBlocks.Num() > 0)
+    {
+        return FreeChildBlocks.Pop(EAllowShrinking::No);
+    }
+
+    int32 FirstChild = Nodes.Num();
+    Nodes.AddDefaulted(4);
+    return FirstChild;
+}
+
+void FQuadtree::ReleaseChildBlock(int32 FirstChild)
+{
+    for (int32 i = 0; i < 4; i++)
+    {
+        Nodes[FirstChild + i] = FQuadtreeNode();
+    }
+
+    FreeChildBlocks.Add(FirstChild);
+}
+
+void FQuadtree::InsertEntryIntoNode(int32 NodeIndex, int32 EntryId)
+{
+    const FBox2D& SplineBounds = EntryBounds[EntryId];
 
     // If the node is a leaf node and hasn't exceeded the max splines per node, add the spline here
-    if (Node->IsLeafNode())
+    if (Nodes[NodeIndex].IsLeafNode())
     {
-        if (Node->SplineComponents.Num() < MaxSplinesPerNode)
+        FQuadtreeNode& Node = Nodes[NodeIndex];
+        if (Node.EntryIds.Num() < MaxSplinesPerNode)
         {
-            Node->SplineComponents.Add(SplineComponent);
+            AddEntryToLeaf(NodeIndex, EntryId);
             return;
         }
-        else if (CurrentDepth < MaxDepth)
+        else if (Node.Depth < MaxDepth)
         {
-            SubdivideNode(Node, CurrentDepth);
+            SubdivideNode(NodeIndex);
         }
         else
         {
             UE_LOG(LogTemp, Warning, TEXT("Maximum depth reached for quadtree without subdividing further."));
-            Node->SplineComponents.Add(SplineComponent);
+            AddEntryToLeaf(NodeIndex, EntryId);
             return;
         }
     }
 
     // Insert the spline into the appropriate child node(s)
+    const int32 FirstChild = Nodes[NodeIndex].FirstChild;
     for (int32 i = 0; i < 4; i++)
     {
-        if (Node->Children[i]->Bounds.Intersect(SplineBounds))
+        if (Nodes[FirstChild + i].Bounds.Intersect(SplineBounds))
         {
-            InsertSplineIntoNode(Node->Children[i], SplineComponent, CurrentDepth + 1);
+            InsertEntryIntoNode(FirstChild + i, EntryId);
         }
     }
 }
 
-void FQuadtree::RemoveSplineFromNode(TSharedPtr<FQuadtreeNode> Node, USplineComponent* SplineComponent)
+void FQuadtree::AddEntryToLeaf(int32 NodeIndex, int32 EntryId)
 {
-    if (!Node.IsValid())
-    {
-        return;
-    }
+    FQuadtreeNode& Node = Nodes[NodeIndex];
+    const int32 Slot = Node.EntryIds.Add(EntryId);
+    const FBox2D& Bounds = Node.EntryBounds.Add_GetRef(EntryBounds[EntryId]);
 
-    // Check if the spline is in this node
-    if (Node->SplineComponents.Remove(SplineComponent) > 0)
+    if (Slot % 4 == 0)
     {
-        // Spline found and removed from this node
-        return;
+        Node.PackedBounds.AddUninitialized(PackedBlockSize);
+        for (int32 Lane = 0; Lane < 4; Lane++)
+        {
+            ClearPackedLane(Node.PackedBounds, Slot + Lane);
+        }
     }
+    WritePackedLane(Node.PackedBounds, Slot, RoundDownToFloat(Bounds.Min.X), RoundDownToFloat(Bounds.Min.Y),
+        RoundUpToFloat(Bounds.Max.X), RoundUpToFloat(Bounds.Max.Y));
+
+    EntryLeaves[EntryId].Add(NodeIndex);
+}
 
-    // If it's not a leaf node, check child nodes
-    if (!Node->IsLeafNode())
+void FQuadtree::RemoveEntryFromLeaf(int32 NodeIndex, int32 EntryId)
+{
+    FQuadtreeNode& Node = Nodes[NodeIndex];
+    int32 Slot = Node.EntryIds.Find(EntryId);
+    if (Slot != INDEX_NONE)
     {
-        for (int32 i = 0; i < 4; i++)
+        // Mirror the swap in the packed lanes, dropping the last block once it is empty
+        const int32 LastSlot = Node.EntryIds.Num() - 1;
+        if (Slot != LastSlot)
+        {
+            const float* LastBlock = Node.PackedBounds.GetData() + (LastSlot / 4) * PackedBlockSize;
+            const int32 LastLane = LastSlot % 4;
+            WritePackedLane(Node.PackedBounds, Slot, LastBlock[LastLane], LastBlock[4 + LastLane], LastBlock[8 + LastLane], LastBlock[12 + LastLane]);
+        }
+        ClearPackedLane(Node.PackedBounds, LastSlot);
+        if (LastSlot % 4 == 0)
         {
-            RemoveSplineFromNode(Node->Children[i], SplineComponent);
+            Node.PackedBounds.SetNum(LastSlot * 4, EAllowShrinking::No);
         }
+
+        Node.EntryIds.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+        Node.EntryBounds.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
     }
+    EntryLeaves[EntryId].RemoveSingleSwap(NodeIndex, EAllowShrinking::No);
 }
 
-void FQuadtree::SubdivideNode(TSharedPtr<FQuadtreeNode> Node, int32 CurrentDepth)
+void FQuadtree::RemoveEntryFromNodes(int32 EntryId)
 {
-    FVector2D Min = Node->Bounds.Min;
-    FVector2D Max = Node->Bounds.Max;
-    FVector2D Center = (Min + Max) / 2;
-
-    // Create child nodes by splitting the bounds into four quadrants
-    Node->Children[0] = MakeShared<FQuadtreeNode>(FBox2D(Center, Max)); // Top-Right
-    Node->Children[1] = MakeShared<FQuadtreeNode>(FBox2D(FVector2D(Min.X, Center.Y), FVector2D(Center.X, Max.Y))); // Top-Left
-    Node->Children[2] = MakeShared<FQuadtreeNode>(FBox2D(Min, Center)); // Bottom-Left
-    Node->Children[3] = MakeShared<FQuadtreeNode>(FBox2D(FVector2D(Center.X, Min.Y), FVector2D(Max.X, Center.Y))); // Bottom-Right
+    // The reverse index lists every leaf a straddling spline was inserted into
+    TArray<int32, TInlineAllocator<4>> Leaves = EntryLeaves[EntryId];
 
-    // Move existing splines into the appropriate child nodes
-    for (USplineComponent* SplineComponent : Node->SplineComponents)
+    TArray<int32, TInlineAllocator<4>> Parents;
+    for (int32 LeafIndex : Leaves)
     {
-        InsertSplineIntoNode(Node, SplineComponent, CurrentDepth + 1);
+        RemoveEntryFromLeaf(LeafIndex, EntryId);
 
-        if (bVisualizeQuadtree)
+        if (Nodes[LeafIndex].Parent != INDEX_NONE)
         {
-            for (int32 i = 0; i < 4; i++)
-            {
-                DrawDebugBoxForNode(Node->Children[i], SplineComponent->GetWorld());
-            }
+            Parents.AddUnique(Nodes[LeafIndex].Parent);
         }
     }
 
-    Node->SplineComponents.Empty(); // Clear splines from the parent node
+    // Merge the deepest parents first so a collapse can cascade towards the root
+    Parents.Sort([this](int32 A, int32 B) { return Nodes[A].Depth > Nodes[B].Depth; });
+    for (int32 ParentIndex : Parents)
+    {
+        int32 NodeIndex = ParentIndex;
+        while (NodeIndex != INDEX_NONE && IsNodeInUse(NodeIndex) && TryMergeChildren(NodeIndex))
+        {
+            NodeIndex = Nodes[NodeIndex].Parent;
+        }
+    }
 }
 
-void FQuadtree::QueryNodeSplinesInArea(TSharedPtr<FQuadtreeNode> Node, const FBox2D& Area, TArray<USplineComponent*>& OutSplines) const
+bool FQuadtree::TryMergeChildren(int32 NodeIndex)
 {
-    // Check if the node's bounds intersect with the query area
-    if (!Node->Bounds.Intersect(Area))
+    const int32 FirstChild = Nodes[NodeIndex].FirstChild;
+    if (FirstChild == INDEX_NONE)
     {
-        return; // No intersection, return early
+        return false;
     }
 
-    // If the node is a leaf node, check each spline component within it
-    if (Node->IsLeafNode())
+    // Only a node whose children are all leaves can collapse, and only if the union still fits
+    TArray<int32, TInlineAllocator<16>> MergedEntries;
+    for (int32 i = 0; i < 4; i++)
     {
-        for (USplineComponent* SplineComponent : Node->SplineComponents)
+        const FQuadtreeNode& Child = Nodes[FirstChild + i];
+        if (!Child.IsLeafNode())
         {
-            // Calculate the bounds of the spline in world space
-            FBoxSphereBounds WorldBounds = SplineComponent->CalcBounds(SplineComponent->GetComponentTransform());
-            FVector SplineMin = WorldBounds.GetBox().Min;
-            FVector SplineMax = WorldBounds.GetBox().Max;
+            return false;
+        }
 
-            // Convert the bounding box to TBox2<double>
-            UE::Math::TBox2<double> SplineBounds(
-                FVector2d(SplineMin.X, SplineMin.Y),
-                FVector2d(SplineMax.X, SplineMax.Y)
-            );
+        for (int32 EntryId : Child.EntryIds)
+        {
+            MergedEntries.AddUnique(EntryId);
+        }
 
-            // Check if the spline bounds intersect with the query area
-            if (Area.Intersect(SplineBounds))
-            {
-                OutSplines.Add(SplineComponent);
-            }
+        if (MergedEntries.Num() > MaxSplinesPerNode)
+        {
+            return false;
         }
     }
-    else
+
+    for (int32 i = 0; i < 4; i++)
     {
-        // Recursively query the child nodes
-        for (int32 i = 0; i < 4; i++)
+        for (int32 EntryId : Nodes[FirstChild + i].EntryIds)
         {
-            QueryNodeSplinesInArea(Node->Children[i], Area, OutSplines);
+            EntryLeaves[EntryId].RemoveSingleSwap(FirstChild + i, EAllowShrinking::No);
         }
     }
+
+    ReleaseChildBlock(FirstChild);
+    Nodes[NodeIndex].FirstChild = INDEX_NONE;
+
+    for (int32 EntryId : MergedEntries)
+    {
+        AddEntryToLeaf(NodeIndex, EntryId);
+    }
+
+    return true;
 }
 
-void FQuadtree::ClearNode(TSharedPtr<FQuadtreeNode> Node)
+void FQuadtree::BuildNode(int32 NodeIndex, const TArray<int32>& NodeEntries, int32& OutNumOverfullLeaves)
 {
-    if (!Node.IsValid())
+    // Same split rule as incremental insertion, applied top-down to the whole set at once
+    if (NodeEntries.Num() <= MaxSplinesPerNode || Nodes[NodeIndex].Depth >= MaxDepth)
     {
+        for (int32 EntryId : NodeEntries)
+        {
+            AddEntryToLeaf(NodeIndex, EntryId);
+        }
+
+        if (NodeEntries.Num() > MaxSplinesPerNode)
+        {
+            OutNumOverfullLeaves++;
+        }
         return;
     }
 
-    // Clear any spline components in the current node
-    Node->SplineComponents.Empty();
+    const int32 FirstChild = AllocateChildBlock();
+    InitializeChildBlock(NodeIndex, FirstChild);
 
-    // If the node has children (i.e., it's not a leaf node), clear the children as well
-    if (!Node->IsLeafNode())
+    TArray<int32> ChildEntries;
+    for (int32 i = 0; i < 4; i++)
     {
-        for (int32 i = 0; i < 4; i++)
+        ChildEntries.Reset();
+        const FBox2D ChildBounds = Nodes[FirstChild + i].Bounds;
+        for (int32 EntryId : NodeEntries)
         {
-            if (Node->Children[i].IsValid())
+            if (ChildBounds.Intersect(EntryBounds[EntryId]))
             {
-                ClearNode(Node->Children[i]);
-                Node->Children[i].Reset(); // Reset the child node pointer to release the memory
+                ChildEntries.Add(EntryId);
             }
         }
+
+        BuildNode(FirstChild + i, ChildEntries, OutNumOverfullLeaves);
     }
-}
 
-void FQuadtree::CollectSplines(const TSharedPtr<FQuadtreeNode>& Node, TArray<USplineComponent*>& OutSplines) const
-{
-    if (Node.IsValid())
+    if (bVisualizeQuadtree && NodeEntries.Num() > 0)
     {
-        if (Node->IsLeafNode())
+        UWorld* World = EntrySplines[NodeEntries[0]]->GetWorld();
+        for (int32 i = 0; i < 4; i++)
         {
-            OutSplines.Append(Node->SplineComponents);
+            DrawDebugBoxForNode(FirstChild + i, World);
         }
-        else
+    }
+}
+
+void FQuadtree::InitializeChildBlock(int32 NodeIndex, int32 FirstChild)
+{
+    FQuadtreeNode& Node = Nodes[NodeIndex];
+    const FVector2D Min = Node.Bounds.Min;
+    const FVector2D Max = Node.Bounds.Max;
+    const FVector2D Center = (Min + Max) / 2;
+    const int32 ChildDepth = Node.Depth + 1;
+
+    // Create child nodes in Z-order: bit 0 selects the upper X half, bit 1 the upper Y half
+    Nodes[FirstChild + 0] = FQuadtreeNode(FBox2D(Min, Center), NodeIndex, ChildDepth); // Bottom-Left
+    Nodes[FirstChild + 1] = FQuadtreeNode(FBox2D(FVector2D(Center.X, Min.Y), FVector2D(Max.X, Center.Y)), NodeIndex, ChildDepth); // Bottom-Right
+    Nodes[FirstChild + 2] = FQuadtreeNode(FBox2D(FVector2D(Min.X, Center.Y), FVector2D(Center.X, Max.Y)), NodeIndex, ChildDepth); // Top-Left
+    Nodes[FirstChild + 3] = FQuadtreeNode(FBox2D(Center, Max), NodeIndex, ChildDepth); // Top-Right
+
+    Node.FirstChild = FirstChild;
+}
+
+void FQuadtree::SubdivideNode(int32 NodeIndex)
+{
+    // Allocating may grow the pool, so the node is re-fetched by index afterwards
+    const int32 FirstChild = AllocateChildBlock();
+    InitializeChildBlock(NodeIndex, FirstChild);
+
+    TArray<int32> MovedEntries = MoveTemp(Nodes[NodeIndex].EntryIds);
+    Nodes[NodeIndex].EntryIds.Reset();
+    Nodes[NodeIndex].EntryBounds.Empty();
+    Nodes[NodeIndex].PackedBounds.Empty();
+
+    for (int32 EntryId : MovedEntries)
+    {
+        EntryLeaves[EntryId].RemoveSingleSwap(NodeIndex, EAllowShrinking::No);
+    }
+
+    // Move existing splines into the appropriate child nodes
+    for (int32 EntryId : MovedEntries)
+    {
+        InsertEntryIntoNode(NodeIndex, EntryId);
+    }
+
+    if (bVisualizeQuadtree && MovedEntries.Num() > 0)
+    {
+        UWorld* World = EntrySplines[MovedEntries[0]]->GetWorld();
+        for (int32 i = 0; i < 4; i++)
         {
-            for (int32 i = 0; i < 4; i++)
-            {
-                CollectSplines(Node->Children[i], OutSplines);
-            }
+            DrawDebugBoxForNode(FirstChild + i, World);
         }
     }
 }
 
-void FQuadtree::DrawDebugBoxForNode(TSharedPtr<FQuadtreeNode> Node, UWorld* World)
+void FQuadtree::DrawDebugBoxForNode(int32 NodeIndex, UWorld* World) const
 {
-    FVector2D Center2D = Node->Bounds.GetCenter();
-    FVector2D Extent2D = Node->Bounds.GetExtent();
+    FVector2D Center2D = Nodes[NodeIndex].Bounds.GetCenter();
+    FVector2D Extent2D = Nodes[NodeIndex].Bounds.GetExtent();
 
     // Create a 3D center and extent for the debug box (z = 0, but can be adjusted)
     FVector Center3D(Center2D.X, Center2D.Y, 500.0f);
@@ -5,9 +5,51 @@
 #include "DrawDebugHelpers.h"
 #include "Materials/MaterialInterface.h"
 #include "FSplinePointUtilities.h"
+#include "Async/ParallelFor.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/Async.h"
+#include <atomic>
 
 using namespace SplineUtilities;
 
+// State of one asynchronous path request, shared by the actor and the search running on the thread pool
+struct FRoadAsyncPathRequest
+{
+	FRoadPathRequest Request;
+	FRoadPathRequestCallback OnCompleted;
+
+	// Set on the game thread, searches that haven't started yet are skipped
+	std::atomic<bool> bCancelled{ false };
+
+	// Captured on the game thread when the search is started
+	FRoadPathSearchSnapshot Snapshot;
+	uint32 NetworkVersion = 0;
+	FSplineSegmentHit StartHit;
+	FSplineSegmentHit EndHit;
+	int32 StartNodeId = INDEX_NONE;
+	int32 EndNodeId = INDEX_NONE;
+	FRoadPathCacheKey CacheKey;
+
+	// Times the request started over because the network changed while it was in flight
+	int32 NumRestarts = 0;
+
+	// Written by the search, or by the cache lookup when bCached is set
+	TArray<FVector> Path;
+	bool bCached = false;
+	bool bFound = false;
+};
+
+// Requests that keep getting overtaken by spline edits, e.g. while a spline is dragged, complete on the
+// network they last ran on instead of starting over forever
+static constexpr int32 MaxPathRequestRestarts = 4;
+
+// Paths with a right offset follow the single lane the road graph samples
+static int32 GetRoadLane(bool bRightOffset)
+{
+	return bRightOffset ? 0 : INDEX_NONE;
+}
+
+
 bool ARoadActor::bIsInRoadNetworkMode = false;
 bool ARoadActor::EnableRoadDebugLine = false;
 float ARoadActor::DebugWidth = 500.0f;
@@ -42,6 +84,13 @@ void ARoadActor::BeginPlay()
 	InitializeQuadtree();
 }
 
+void ARoadActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelAllPathRequests();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void ARoadActor::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
@@ -84,27 +133,123 @@ void ARoadActor::AddOrUpdateSplineComponent(USplineComponent* SplineComponent, b
 {
 	if (!SplineComponent) return;
 
+	NetworkVersion++;
+
 	if (!bIsUpdate) { SplineComponents.AddUnique(SplineComponent); }
 	UpdateComponentTransforms();
 
+	if (SplineSegmentBVH.IsValid())
+	{
+		SplineSegmentBVH->AddOrUpdateSpline(SplineComponent);
+
+		// Only the cells around the old and new shape are re-baked, on the next lookup
+		if (NearestRoadRaster.IsValid())
+		{
+			NearestRoadRaster->MarkSplineDirty(SplineSegmentBVH->GetSplineId(SplineComponent));
+		}
+	}
+
 	FBox SplineBounds3D = SplineComponent->Bounds.GetBox();
 	FBox2D SplineBounds(FVector2D(SplineBounds3D.Min.X, SplineBounds3D.Min.Y), FVector2D(SplineBounds3D.Max.X, SplineBounds3D.Max.Y));
 
-	if (!SplineQuadtree.IsValid() || !SplineQuadtree->GetBounds().IsInside(SplineBounds))
+	if (!SplineSpatialIndex.IsValid())
 	{
-		// Reinitialize the quadtree with the updated bounds if the spline is outside the current quadtree bounds
 		InitializeQuadtree();
 		return;
 	}
 
+	// Grow the index outwards if the spline is outside the current bounds, existing contents are kept
+	if (!SplineSpatialIndex->GetBounds().IsInside(SplineBounds))
+	{
+		SplineSpatialIndex->GrowToContain(SplineBounds);
+	}
+
 	if (bIsUpdate)
 	{
-		SplineQuadtree->UpdateSplineComponent(SplineComponent);
+		SplineSpatialIndex->UpdateSplineComponent(SplineComponent);
 	}
 	else
 	{
-		SplineQuadtree->InsertSplineComponent(SplineComponent);
+		SplineSpatialIndex->InsertSplineComponent(SplineComponent);
 	}
+
+	// Only the nodes at the ends of this spline change, the ids of all other nodes stay the same
+	EditRoadGraph([SplineComponent](FRoadGraph& Graph, FRoadGraphEdit& Edit)
+		{
+			return Graph.FindSplineIndex(SplineComponent) != INDEX_NONE ? Graph.UpdateSpline(SplineComponent, &Edit) : Graph.AddSpline(SplineComponent, &Edit);
+		});
+}
+
+void ARoadActor::RemoveSplineComponent(USplineComponent* SplineComponent)
+{
+	if (!SplineComponent || SplineComponents.Remove(SplineComponent) == 0) return;
+
+	NetworkVersion++;
+
+	if (SplineSegmentBVH.IsValid())
+	{
+		// The raster has to see the old samples to know which cells to re-bake
+		if (NearestRoadRaster.IsValid())
+		{
+			NearestRoadRaster->MarkSplineDirty(SplineSegmentBVH->GetSplineId(SplineComponent));
+		}
+		SplineSegmentBVH->RemoveSpline(SplineComponent);
+	}
+
+	if (SplineSpatialIndex.IsValid())
+	{
+		SplineSpatialIndex->RemoveSplineComponent(SplineComponent);
+	}
+
+	EditRoadGraph([SplineComponent](FRoadGraph& Graph, FRoadGraphEdit& Edit)
+		{
+			return Graph.RemoveSpline(SplineComponent, &Edit);
+		});
+}
+
+void ARoadActor::EditRoadGraph(TFunctionRef<bool(FRoadGraph&, FRoadGraphEdit&)> Edit)
+{
+	if (!RoadGraph.IsValid())
+	{
+		return;
+	}
+
+	// Snapshots of searches in flight and background builds hold their own reference, while there are none the
+	// edit only patches the edges of the touched nodes. Otherwise it goes to a copy so they keep a consistent graph.
+	const double StartTime = FPlatformTime::Seconds();
+	const uint32 PreviousRevision = RoadGraph->GetRevision();
+	TSharedPtr<FRoadGraph> NewRoadGraph = RoadGraph.IsUnique() ? ConstCastSharedPtr<FRoadGraph>(RoadGraph) : MakeShared<FRoadGraph>(*RoadGraph);
+	FRoadGraphEdit GraphEdit;
+	if (!Edit(*NewRoadGraph, GraphEdit))
+	{
+		return;
+	}
+	RoadGraph = NewRoadGraph;
+
+	UE_LOG(LogTemp, Verbose, TEXT("Updated road graph to %d nodes and %d edges in %.2f ms."),
+		RoadGraph->GetNumNodes(), RoadGraph->GetNumActiveEdges(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	PathfindingComponent->OnRoadGraphEdited(RoadGraph, PreviousRevision, GraphEdit);
+}
+
+TArray<float> ARoadActor::GetRoadLaneOffsets() const
+{
+	return { RoadWidth / 4.0f };
+}
+
+void ARoadActor::UpdateRoadLanes()
+{
+	const TArray<float> LaneOffsets = GetRoadLaneOffsets();
+	if (!RoadGraph.IsValid() || RoadGraph->GetLaneOffsets() == LaneOffsets)
+	{
+		return;
+	}
+
+	// Lanes don't change the topology, the landmarks and the contraction hierarchy stay valid for the copy
+	TSharedPtr<FRoadGraph> NewRoadGraph = MakeShared<FRoadGraph>(*RoadGraph);
+	NewRoadGraph->SetLaneOffsets(LaneOffsets);
+	RoadGraph = NewRoadGraph;
+	PathCache.Empty();
 }
 
 const TArray<USplineComponent*>& ARoadActor::GetSplineComponents() const
@@ -145,325 +290,703 @@ FBox2D ARoadActor::CalculateSquareBounds(float PaddingPercentage)
 
 void ARoadActor::InitializeQuadtree()
 {
+	NetworkVersion++;
+	PathCache.SetCapacity(PathCacheSize);
+
 	const float PaddingPercentage = 0.30f;
 	FBox2D SquareWorldBounds = CalculateSquareBounds(PaddingPercentage);
 
-	if (SplineQuadtree.IsValid())
+	// Pick the index backend from the spline distribution, or use the hand-tuned settings
+	FSplineSpatialIndexConfig IndexConfig;
+	if (SpatialIndexType == ESplineSpatialIndexType::Auto)
+	{
+		IndexConfig = ISplineSpatialIndex::ChooseConfig(SplineComponents, PathfindingComponent->DefaultSearchRadius);
+	}
+	else
 	{
-		SplineQuadtree->Clear();
+		IndexConfig.Type = SpatialIndexType;
+		IndexConfig.MaxSplinesPerNode = MaxSplinesPerNode;
+		IndexConfig.MaxDepth = MaxDepth;
+		IndexConfig.CellSize = HashGridCellSize;
 	}
 
-	// If quadtree doesn't exist or the bounds have changed, re-create it
-	if (!SplineQuadtree.IsValid() || !SplineQuadtree->GetBounds().IsInside(SquareWorldBounds))
+	SplineSpatialIndex = ISplineSpatialIndex::Create(IndexConfig, SquareWorldBounds);
+	if (IndexConfig.Type == ESplineSpatialIndexType::Quadtree)
 	{
-		SplineQuadtree = MakeShared<FQuadtree>(SquareWorldBounds, MaxSplinesPerNode, MaxDepth);
+		StaticCastSharedPtr<FQuadtree>(SplineSpatialIndex)->SetVisualizeQuadtree(VisualizeQuadtree);
 	}
 
-	SplineQuadtree->SetVisualizeQuadtree(VisualizeQuadtree);
+	// Bulk-load all spline components into the index in one pass
+	const double BuildStartTime = FPlatformTime::Seconds();
+	SplineSpatialIndex->BulkLoad(SplineComponents);
+	const double BuildTime = FPlatformTime::Seconds() - BuildStartTime;
 
-	// Get the 2D bounds from the quadtree
-	FBox2D QuadtreeBounds2D = SplineQuadtree->GetBounds();
+	UE_LOG(LogTemp, Log, TEXT("Built spline spatial index %s for %d splines in %.2f ms (%d nodes)."),
+		*IndexConfig.ToString(), SplineComponents.Num(), BuildTime * 1000.0, SplineSpatialIndex->GetNumNodes());
 
-	// Add all spline components to the quadtree
-	for (USplineComponent* SplineComponent : SplineComponents)
-	{
-		if (SplineComponent)
-		{
-			SplineQuadtree->InsertSplineComponent(SplineComponent);
-		}
-	}
 	if (VisulaizeSplineQuadtree)
 	{
 		DrawAllSplineDebugLines();
 	}
 
-	AllPathNodes = PathfindingComponent->FindAllNodes(SplineComponents);
-}
+	if (!SplineSegmentBVH.IsValid())
+	{
+		SplineSegmentBVH = MakeShared<FSplineSegmentBVH>();
+	}
+	SplineSegmentBVH->Build(SplineComponents);
 
+	if (bUseNearestRoadRaster)
+	{
+		const double RasterStartTime = FPlatformTime::Seconds();
+		NearestRoadRaster = MakeShared<FSplineNearestRaster>(NearestRoadRasterCellSize, NearestRoadRasterMaxDistance);
+		NearestRoadRaster->Build(*SplineSegmentBVH, SquareWorldBounds);
+		const double RasterTime = FPlatformTime::Seconds() - RasterStartTime;
+
+		const FIntPoint NumRasterCells = NearestRoadRaster->GetNumCells();
+		UE_LOG(LogTemp, Log, TEXT("Baked nearest road raster of %d x %d cells (cell size %.0f) in %.2f ms."),
+			NumRasterCells.X, NumRasterCells.Y, NearestRoadRaster->GetCellSize(), RasterTime * 1000.0);
+	}
+	else
+	{
+		NearestRoadRaster.Reset();
+	}
 
-// ---------- Pathfinding Functions ---------
-TArray<FVector> ARoadActor::FindPathRoadNetwork(FVector StartLocation, FVector TargetLocation, bool bRightOffset)
-{
-	TArray<FVector> Path;
+	const double GraphStartTime = FPlatformTime::Seconds();
+	TSharedPtr<FRoadGraph> NewRoadGraph = MakeShared<FRoadGraph>();
+	NewRoadGraph->SetLaneOffsets(GetRoadLaneOffsets());
+	NewRoadGraph->Build(GetRoadTopology());
+	RoadGraph = NewRoadGraph;
 
-	// Find the closest nodes for the start and end
-	TSharedPtr<FPathNode> StartNode = FindNearestNodeWithSpline(StartLocation);
-	TSharedPtr<FPathNode> EndNode = FindNearestNodeWithSpline(TargetLocation);
+	UE_LOG(LogTemp, Log, TEXT("Built road graph with %d nodes and %d edges in %.2f ms."),
+		RoadGraph->GetNumNodes(), RoadGraph->GetNumActiveEdges(), (FPlatformTime::Seconds() - GraphStartTime) * 1000.0);
 
-	// Perform pathfinding
-	TArray<TSharedPtr<FPathNode>> PathNodes = PathfindingComponent->AStarPathfinding(StartNode, EndNode, AllPathNodes);
+	PathfindingComponent->BuildLandmarks(*RoadGraph);
+	PathfindingComponent->BuildClusterHierarchy(*RoadGraph);
+	PathfindingComponent->BuildContractionHierarchy(RoadGraph);
+}
 
-	if (PathNodes.Num() == 0)
+void ARoadActor::BakeContractionHierarchy()
+{
+	if (!RoadGraph.IsValid())
 	{
-		UE_LOG(LogTemp, Error, TEXT("No path found between the given start and target locations."));
-		return Path;
+		InitializeQuadtree();
 	}
 
-	// Create a deep copy of path nodes
-	TArray<TSharedPtr<FPathNode>> CopiedPathNodes = CreateDeepCopyOfPathNodes(PathNodes);
-
-	if (CopiedPathNodes[0]->Location != StartNode->Location)
+	if (!PathfindingComponent->bUseContractionHierarchy)
 	{
-		CopiedPathNodes.Insert(StartNode, 0);
+		UE_LOG(LogTemp, Warning, TEXT("Enable bUseContractionHierarchy on the pathfinding component to bake a contraction hierarchy."));
+		return;
 	}
-	if (CopiedPathNodes.Last()->Location != EndNode->Location)
+
+	PathfindingComponent->BuildContractionHierarchy(RoadGraph, true);
+}
+
+const FRoadNetworkTopology& ARoadActor::GetRoadTopology()
+{
+	if (!RoadTopology.IsValid() || RoadTopologyVersion != NetworkVersion)
 	{
-		CopiedPathNodes.Add(EndNode);
+		const double StartTime = FPlatformTime::Seconds();
+		if (!RoadTopology.IsValid())
+		{
+			RoadTopology = MakeShared<FRoadNetworkTopology>();
+		}
+		RoadTopology->Build(SplineComponents);
+		RoadTopologyVersion = NetworkVersion;
+
+		UE_LOG(LogTemp, Log, TEXT("Built road topology with %d nodes for %d splines in %.2f ms."),
+			RoadTopology->GetNumNodes(), RoadTopology->GetNumSplines(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 	}
 
-	// Adjust spline nodes if valid
-	USplineComponent* StartSpline = nullptr;
-	USplineComponent* EndSpline = nullptr;
-	AdjustSplineNodes(CopiedPathNodes, StartLocation, TargetLocation, StartSpline, EndSpline);
+	return *RoadTopology;
+}
+
 
-	// Refine the path using spline points
-	Path = RefinePathWithSplinePoints(CopiedPathNodes, StartSpline, EndSpline);
-	if (bRightOffset)
+// ---------- Pathfinding Functions ---------
+TArray<FVector> ARoadActor::FindPathRoadNetwork(FVector StartLocation, FVector TargetLocation, bool bRightOffset, ERoadPathSearchMode SearchMode)
+{
+	TArray<FVector> Path;
+
+	if (!RoadGraph.IsValid() || RoadGraph->GetNumNodes() == 0)
 	{
-		ApplyRightOffsetToPathNodes(Path, RoadWidth);
+		UE_LOG(LogTemp, Error, TEXT("The road graph has not been built."));
+		return Path;
 	}
 
-	// Add start and end points if path is not empty
-	if (Path.Num() > 0)
+	UpdateRoadLanes();
+
+	// The nearest spline query also returns the closest point on it
+	FSplineSegmentHit StartHit = PathfindingComponent->FindNearestSplineHit(StartLocation);
+	FSplineSegmentHit EndHit = PathfindingComponent->FindNearestSplineHit(TargetLocation);
+
+	// Repeated routes skip the search and the refinement, the end points are still added per request.
+	// The size is applied on every use, so edits to PathCacheSize take effect without a rebuild.
+	PathCache.SetCapacity(PathCacheSize);
+	const int32 Lane = GetRoadLane(bRightOffset);
+	const bool bUsePathCache = StartHit.IsValid() && EndHit.IsValid();
+
+	// The search picks its end nodes from the raw locations, so the key carries them next to the snapped keys
+	const int32 StartNodeId = FindNearestNodeWithSpline(*RoadGraph, StartLocation, StartHit);
+	const int32 EndNodeId = FindNearestNodeWithSpline(*RoadGraph, TargetLocation, EndHit);
+	const FRoadPathCacheKey CacheKey(StartHit, EndHit, StartNodeId, EndNodeId, Lane);
+	if (!bUsePathCache || !PathCache.Find(CacheKey, NetworkVersion, Path))
 	{
-		Path = AddPathWithStartAndEndPoints(Path, StartLocation, TargetLocation);
+		if (!ComputeRoadPath(PathfindingComponent->CreateSearchSnapshot(RoadGraph), StartNodeId, EndNodeId, StartHit, EndHit, SearchMode, Lane,
+			PathfindingComponent->GetSearchContext(), Path))
+		{
+			UE_LOG(LogTemp, Error, TEXT("No path found between the given start and target locations."));
+			return Path;
+		}
+
+		if (bUsePathCache)
+		{
+			PathCache.Add(CacheKey, NetworkVersion, Path);
+		}
 	}
 
+	FinishRoadPath(Path, StartLocation, TargetLocation);
 	return Path;
 }
 
 
-TArray<FVector> ARoadActor::RefinePathWithSplinePoints(TArray<TSharedPtr<FPathNode>>& PathNodes, USplineComponent* StartSpline, USplineComponent* EndSpline)
+TArray<FRoadPathResult> ARoadActor::FindPathsRoadNetworkBatch(const TArray<FRoadPathRequest>& Requests)
 {
-	TArray<FVector> PathLocations;
+	const int32 NumRequests = Requests.Num();
+	TArray<FRoadPathResult> Results;
+	Results.SetNum(NumRequests);
 
-	if (PathNodes.Num() < 2)
+	// The segment BVH is built together with the graph, so the nearest spline lookups below never take the quadtree fallback
+	if (!RoadGraph.IsValid() || RoadGraph->GetNumNodes() == 0 || !SplineSegmentBVH.IsValid())
 	{
-		return PathLocations;
+		UE_LOG(LogTemp, Error, TEXT("The road graph has not been built."));
+		return Results;
 	}
 
-	// Iterate through each node in the PathNodes array, processing node pairs
-	for (int32 i = 0; i < PathNodes.Num() - 1; ++i)
+	// Apply pending spline edits here, the workers must only read the lookup structures
+	PathfindingComponent->UpdateDirtySpatialData();
+	UpdateRoadLanes();
+	PathCache.SetCapacity(PathCacheSize);
+
+	// The end nodes are looked up once here, the cache key and the search both use them
+	TArray<FSplineSegmentHit> StartHits;
+	TArray<FSplineSegmentHit> EndHits;
+	TArray<int32> StartNodes;
+	TArray<int32> EndNodes;
+	StartHits.SetNum(NumRequests);
+	EndHits.SetNum(NumRequests);
+	StartNodes.SetNumUninitialized(NumRequests);
+	EndNodes.SetNumUninitialized(NumRequests);
+	ParallelFor(NumRequests, [&](int32 RequestIndex)
+		{
+			const FRoadPathRequest& Request = Requests[RequestIndex];
+			StartHits[RequestIndex] = PathfindingComponent->FindNearestSplineHit(Request.StartLocation);
+			EndHits[RequestIndex] = PathfindingComponent->FindNearestSplineHit(Request.TargetLocation);
+			StartNodes[RequestIndex] = FindNearestNodeWithSpline(*RoadGraph, Request.StartLocation, StartHits[RequestIndex]);
+			EndNodes[RequestIndex] = FindNearestNodeWithSpline(*RoadGraph, Request.TargetLocation, EndHits[RequestIndex]);
+		});
+
+	// The cache is only touched on the game thread. Requests between the same spots within the batch are searched once,
+	// SourceRequests points the duplicates at the request that does the search.
+	TArray<int32> PendingRequests;
+	TArray<int32> SourceRequests;
+	SourceRequests.Init(INDEX_NONE, NumRequests);
+	TMap<FRoadPathCacheKey, int32> PendingByKey;
+	TArray<FRoadPathCacheKey> CacheKeys;
+	CacheKeys.SetNum(NumRequests);
+
+	for (int32 RequestIndex = 0; RequestIndex < NumRequests; RequestIndex++)
 	{
-		TSharedPtr<FPathNode> CurrentNode = PathNodes[i];
-		TSharedPtr<FPathNode> NextNode = PathNodes[i + 1];
-
-		// Determine the appropriate spline for the current segment
-		USplineComponent* SplineComponent = nullptr;
+		if (!StartHits[RequestIndex].IsValid() || !EndHits[RequestIndex].IsValid())
+		{
+			PendingRequests.Add(RequestIndex);
+			continue;
+		}
 
-		// Choose based on the node index (StartSpline, EndSpline, or dynamically found spline)
-		if (i == 0)
+		CacheKeys[RequestIndex] = FRoadPathCacheKey(StartHits[RequestIndex], EndHits[RequestIndex], StartNodes[RequestIndex], EndNodes[RequestIndex],
+			GetRoadLane(Requests[RequestIndex].bRightOffset));
+		const FRoadPathCacheKey& CacheKey = CacheKeys[RequestIndex];
+		if (PathCache.Find(CacheKey, NetworkVersion, Results[RequestIndex].Path))
 		{
-			SplineComponent = StartSpline;
+			Results[RequestIndex].bFound = true;
 		}
-		else if (i == PathNodes.Num() - 2)
+		else if (const int32* SourceRequest = PendingByKey.Find(CacheKey))
 		{
-			SplineComponent = EndSpline;
+			SourceRequests[RequestIndex] = *SourceRequest;
 		}
-
-		// If the predefined splines (StartSpline/EndSpline) are not available, find a spline containing the nodes
-		if (!SplineComponent)
+		else
 		{
-			SplineComponent = PathfindingComponent->FindSplineContainingNodes(CurrentNode, NextNode);
+			PendingByKey.Add(CacheKey, RequestIndex);
+			PendingRequests.Add(RequestIndex);
 		}
+	}
+
+	// One task per worker thread pulls requests from a shared counter, so long searches don't hold up a fixed share
+	// of the batch. Every task reuses its own search context across batches.
+	const int32 NumTasks = FMath::Min(PendingRequests.Num(), FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+	if (BatchSearchContexts.Num() < NumTasks)
+	{
+		BatchSearchContexts.SetNum(NumTasks);
+	}
 
-		// If no spline is found, use the nearest spline based on the midpoint of the segment
-		if (!SplineComponent)
+	const FRoadPathSearchSnapshot Snapshot = PathfindingComponent->CreateSearchSnapshot(RoadGraph);
+	FThreadSafeCounter NextPendingRequest;
+	ParallelFor(NumTasks, [&](int32 TaskIndex)
 		{
-			FVector MidPoint = (CurrentNode->Location + NextNode->Location) * 0.5f;
-			SplineComponent = PathfindingComponent->FindNearestSplineComponent(MidPoint);
+			FRoadPathSearchContext& SearchContext = BatchSearchContexts[TaskIndex];
+			for (int32 PendingIndex = NextPendingRequest.Increment() - 1; PendingIndex < PendingRequests.Num(); PendingIndex = NextPendingRequest.Increment() - 1)
+			{
+				const int32 RequestIndex = PendingRequests[PendingIndex];
+				const FRoadPathRequest& Request = Requests[RequestIndex];
+				Results[RequestIndex].bFound = ComputeRoadPath(Snapshot, StartNodes[RequestIndex], EndNodes[RequestIndex], StartHits[RequestIndex], EndHits[RequestIndex],
+					Request.SearchMode, GetRoadLane(Request.bRightOffset), SearchContext, Results[RequestIndex].Path);
+			}
+		});
+
+	int32 NumFailed = 0;
+	for (const int32 RequestIndex : PendingRequests)
+	{
+		if (!Results[RequestIndex].bFound)
+		{
+			NumFailed++;
 		}
+		else if (StartHits[RequestIndex].IsValid() && EndHits[RequestIndex].IsValid())
+		{
+			PathCache.Add(CacheKeys[RequestIndex], NetworkVersion, Results[RequestIndex].Path);
+		}
+	}
 
-		// If a valid spline is found, sample points along it and add to the path
-		if (SplineComponent)
+	for (int32 RequestIndex = 0; RequestIndex < NumRequests; RequestIndex++)
+	{
+		if (SourceRequests[RequestIndex] != INDEX_NONE)
 		{
-			TArray<FVector> SplinePoints = GetSplinePointsBetweenLocations(SplineComponent, 400.0f, CurrentNode->Location, NextNode->Location);
-			PathLocations.Append(SplinePoints);
+			Results[RequestIndex] = Results[SourceRequests[RequestIndex]];
+			NumFailed += Results[RequestIndex].bFound ? 0 : 1;
 		}
 	}
 
-	return PathLocations;
+	// End points belong to each request, the duplicates have copied the path of the same lane above
+	ParallelFor(NumRequests, [&](int32 RequestIndex)
+		{
+			const FRoadPathRequest& Request = Requests[RequestIndex];
+			FinishRoadPath(Results[RequestIndex].Path, Request.StartLocation, Request.TargetLocation);
+		});
+
+	if (NumFailed > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No path found for %d of %d batched requests."), NumFailed, NumRequests);
+	}
+
+	return Results;
 }
 
 
-TArray<FVector> ARoadActor::AddPathWithStartAndEndPoints(TArray<FVector>& PathLocations, FVector StartLocation, FVector TargetLocation)
+TArray<FVector> ARoadActor::FindPathToSharedDestination(FVector StartLocation, FVector TargetLocation, bool bRightOffset)
 {
-	TArray<FVector> RefinedPathLocations;
+	TArray<FVector> Path;
 
-	TArray<FVector> StartToFirstPointArray = GetPointsBetweenLocations(StartLocation, PathLocations[0], 400.0f);
-	TArray<FVector> LastPointToEndArray = GetPointsBetweenLocations(PathLocations[PathLocations.Num() - 1], TargetLocation, 400.0f);
+	if (!RoadGraph.IsValid() || RoadGraph->GetNumNodes() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("The road graph has not been built."));
+		return Path;
+	}
 
-	RefinedPathLocations.Append(StartToFirstPointArray);
-	RefinedPathLocations.Append(PathLocations);
-	RefinedPathLocations.Append(LastPointToEndArray);
+	UpdateRoadLanes();
 
-	return RefinedPathLocations;
+	FSplineSegmentHit StartHit = PathfindingComponent->FindNearestSplineHit(StartLocation);
+	FSplineSegmentHit EndHit = PathfindingComponent->FindNearestSplineHit(TargetLocation);
+
+	// The goal node is picked the same way as for a search, so the route matches FindPathRoadNetwork
+	const int32 GoalNodeId = FindNearestNodeWithSpline(*RoadGraph, TargetLocation, EndHit);
+	const TSharedPtr<const FRoadFlowField> FlowField = PathfindingComponent->GetFlowField(RoadGraph, GoalNodeId);
+
+	FRoadGraphPath GraphPath;
+	if (!FlowField.IsValid() || !FlowField->ExtractPath(*RoadGraph, FindNearestNodeWithSpline(*RoadGraph, StartLocation, StartHit), GraphPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("No path found between the given start and target locations."));
+		return Path;
+	}
+
+	TArray<FRoadPathSpan> Spans;
+	AdjustPathEnds(*RoadGraph, GraphPath, StartHit, EndHit, Spans);
+	Path = RefinePathWithSplinePoints(*RoadGraph, Spans, GetRoadLane(bRightOffset));
+
+	FinishRoadPath(Path, StartLocation, TargetLocation);
+	return Path;
 }
 
 
-void ARoadActor::AdjustSplineNodes(TArray<TSharedPtr<FPathNode>>& PathNodes, FVector StartLocation, FVector TargetLocation, USplineComponent*& OutStartSpline, USplineComponent*& OutEndSpline)
+TSharedPtr<const FRoadFlowField> ARoadActor::GetDestinationFlowField(const FVector& TargetLocation)
 {
-	// Early return if there are not enough nodes to adjust
-	if (PathNodes.Num() < 1)
+	if (!RoadGraph.IsValid() || RoadGraph->GetNumNodes() == 0)
 	{
-		return;
+		return nullptr;
 	}
 
-	// Variables to hold spline components
-	USplineComponent* StartSpline = nullptr;
-	USplineComponent* EndSpline = nullptr;
+	const FSplineSegmentHit EndHit = PathfindingComponent->FindNearestSplineHit(TargetLocation);
+	return PathfindingComponent->GetFlowField(RoadGraph, FindNearestNodeWithSpline(*RoadGraph, TargetLocation, EndHit));
+}
+
+
+FRoadPathRequestHandle ARoadActor::RequestPathAsync(const FRoadPathRequest& Request, FRoadPathRequestCompleted OnCompleted)
+{
+	return RequestPathAsyncWithCallback(Request, [OnCompleted](FRoadPathRequestHandle Handle, const FRoadPathResult& Result)
+		{
+			OnCompleted.ExecuteIfBound(Handle, Result);
+		});
+}
+
+
+FRoadPathRequestHandle ARoadActor::RequestPathAsyncWithCallback(const FRoadPathRequest& Request, FRoadPathRequestCallback OnCompleted)
+{
+	TSharedRef<FRoadAsyncPathRequest> AsyncRequest = MakeShared<FRoadAsyncPathRequest>();
+	AsyncRequest->Request = Request;
+	AsyncRequest->OnCompleted = MoveTemp(OnCompleted);
 
-	if (PathNodes.Num() > 1)
+	FRoadPathRequestHandle Handle;
+	Handle.Id = ++LastPathRequestId;
+	PendingPathRequests.Add(Handle.Id, AsyncRequest);
+
+	StartPathRequest(Handle.Id, AsyncRequest);
+	return Handle;
+}
+
+
+bool ARoadActor::CancelPathRequest(FRoadPathRequestHandle Handle)
+{
+	const TSharedRef<FRoadAsyncPathRequest>* AsyncRequest = PendingPathRequests.Find(Handle.Id);
+	if (!AsyncRequest)
 	{
-		StartSpline = PathfindingComponent->FindSplineContainingNodes(PathNodes[0], PathNodes[1]);
-		EndSpline = PathfindingComponent->FindSplineContainingNodes(PathNodes[PathNodes.Num() - 2], PathNodes[PathNodes.Num() - 1]);
+		return false;
 	}
 
-	USplineComponent* StartNearSpline = PathfindingComponent->FindNearestSplineComponent(StartLocation);
-	USplineComponent* EndNearSpline = PathfindingComponent->FindNearestSplineComponent(TargetLocation);
+	(*AsyncRequest)->bCancelled = true;
+	PendingPathRequests.Remove(Handle.Id);
+	return true;
+}
 
-	// Check if both the start and end are near the same spline
-	if (StartNearSpline == EndNearSpline && StartNearSpline != nullptr && EndNearSpline != nullptr)
+
+bool ARoadActor::IsPathRequestPending(FRoadPathRequestHandle Handle) const
+{
+	return PendingPathRequests.Contains(Handle.Id);
+}
+
+
+void ARoadActor::CancelAllPathRequests()
+{
+	for (const TPair<int32, TSharedRef<FRoadAsyncPathRequest>>& PendingRequest : PendingPathRequests)
 	{
-		FVector StartSplineLocation = StartNearSpline->FindLocationClosestToWorldLocation(StartLocation, ESplineCoordinateSpace::World);
-		FVector TargetSplineLocation = EndNearSpline->FindLocationClosestToWorldLocation(TargetLocation, ESplineCoordinateSpace::World);
+		PendingRequest.Value->bCancelled = true;
+	}
+	PendingPathRequests.Empty();
+}
 
-		if (PathNodes.Num() > 1)
-		{
-			// Adjust the start and end locations for path nodes
-			PathNodes[0]->Location = StartSplineLocation;
-			PathNodes[PathNodes.Num() - 1]->Location = TargetSplineLocation;
-		}
-		else
+
+void ARoadActor::StartPathRequest(int32 RequestId, const TSharedRef<FRoadAsyncPathRequest>& AsyncRequest)
+{
+	const FRoadPathRequest& Request = AsyncRequest->Request;
+	TWeakObjectPtr<ARoadActor> WeakThis(this);
+
+	// The spatial lookups and the cache are game thread data, the graph search and the refinement are left to the worker
+	UpdateRoadLanes();
+	PathCache.SetCapacity(PathCacheSize);
+	AsyncRequest->NetworkVersion = NetworkVersion;
+	AsyncRequest->StartHit = PathfindingComponent->FindNearestSplineHit(Request.StartLocation);
+	AsyncRequest->EndHit = PathfindingComponent->FindNearestSplineHit(Request.TargetLocation);
+	AsyncRequest->Snapshot = PathfindingComponent->CreateSearchSnapshot(RoadGraph);
+	AsyncRequest->StartNodeId = RoadGraph.IsValid() ? FindNearestNodeWithSpline(*RoadGraph, Request.StartLocation, AsyncRequest->StartHit) : INDEX_NONE;
+	AsyncRequest->EndNodeId = RoadGraph.IsValid() ? FindNearestNodeWithSpline(*RoadGraph, Request.TargetLocation, AsyncRequest->EndHit) : INDEX_NONE;
+	AsyncRequest->CacheKey = FRoadPathCacheKey(AsyncRequest->StartHit, AsyncRequest->EndHit, AsyncRequest->StartNodeId, AsyncRequest->EndNodeId,
+		GetRoadLane(Request.bRightOffset));
+	AsyncRequest->Path.Reset();
+	AsyncRequest->bFound = false;
+
+	// Cached routes still complete on a later tick, so callers see the same order of events for every request
+	AsyncRequest->bCached = AsyncRequest->StartHit.IsValid() && AsyncRequest->EndHit.IsValid()
+		&& PathCache.Find(AsyncRequest->CacheKey, NetworkVersion, AsyncRequest->Path);
+	if (AsyncRequest->bCached)
+	{
+		AsyncRequest->bFound = true;
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, RequestId, AsyncRequest]()
+			{
+				if (ARoadActor* RoadActor = WeakThis.Get())
+				{
+					RoadActor->CompletePathRequest(RequestId, AsyncRequest);
+				}
+			});
+		return;
+	}
+
+	TSharedRef<FRoadPathSearchContextPool> ContextPool = AsyncSearchContexts;
+	Async(EAsyncExecution::ThreadPool, [WeakThis, RequestId, AsyncRequest, ContextPool]()
 		{
-			// Replace the single node with two nodes representing start and end points
-			PathNodes.Empty();
-			PathNodes.Add(MakeShared<FPathNode>(StartSplineLocation));
-			PathNodes.Add(MakeShared<FPathNode>(TargetSplineLocation));
-		}
+			if (AsyncRequest->bCancelled)
+			{
+				return;
+			}
+
+			const FRoadPathRequest& Request = AsyncRequest->Request;
+			TUniquePtr<FRoadPathSearchContext> SearchContext = ContextPool->Acquire();
+			AsyncRequest->bFound = ComputeRoadPath(AsyncRequest->Snapshot, AsyncRequest->StartNodeId, AsyncRequest->EndNodeId, AsyncRequest->StartHit, AsyncRequest->EndHit,
+				Request.SearchMode, GetRoadLane(Request.bRightOffset), *SearchContext, AsyncRequest->Path);
+			ContextPool->Release(MoveTemp(SearchContext));
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, RequestId, AsyncRequest]()
+				{
+					if (ARoadActor* RoadActor = WeakThis.Get())
+					{
+						RoadActor->CompletePathRequest(RequestId, AsyncRequest);
+					}
+				});
+		});
+}
+
 
-		OutStartSpline = StartNearSpline;
-		OutEndSpline = EndNearSpline;
+void ARoadActor::CompletePathRequest(int32 RequestId, const TSharedRef<FRoadAsyncPathRequest>& AsyncRequest)
+{
+	// Cancelled requests are no longer pending, their results are dropped
+	if (!PendingPathRequests.Contains(RequestId))
+	{
+		return;
 	}
-	else
+
+	// The splines changed while the request was in flight and the path may run along removed ones, start over on the current network
+	const bool bOutdated = AsyncRequest->NetworkVersion != NetworkVersion;
+	if (bOutdated && AsyncRequest->NumRestarts < MaxPathRequestRestarts)
 	{
-		// Handle the start node adjustment
-		if (StartSpline == StartNearSpline && StartSpline != nullptr)
-		{
-			PathNodes[0]->Location = StartSpline->FindLocationClosestToWorldLocation(StartLocation, ESplineCoordinateSpace::World);
+		AsyncRequest->NumRestarts++;
+		StartPathRequest(RequestId, AsyncRequest);
+		return;
+	}
 
-			OutStartSpline = StartSpline;
-		}
-		else if (StartNearSpline)
-		{
-			FVector StartSplineLocation = StartNearSpline->FindLocationClosestToWorldLocation(StartLocation, ESplineCoordinateSpace::World);
-			PathNodes.Insert(MakeShared<FPathNode>(StartSplineLocation), 0);
+	PendingPathRequests.Remove(RequestId);
 
-			OutStartSpline = StartNearSpline;
-		}
+	const FRoadPathRequest& Request = AsyncRequest->Request;
+	FRoadPathResult Result;
+	Result.bFound = AsyncRequest->bFound;
+	Result.Path = MoveTemp(AsyncRequest->Path);
+	if (!AsyncRequest->bFound)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No path found for asynchronous request %d."), RequestId);
+	}
+	else if (!bOutdated && !AsyncRequest->bCached && AsyncRequest->StartHit.IsValid() && AsyncRequest->EndHit.IsValid())
+	{
+		// An outdated path was found on an older network, it must not be cached for the current one
+		PathCache.Add(AsyncRequest->CacheKey, NetworkVersion, Result.Path);
+	}
 
-		// Handle the end node adjustment
-		if ((EndSpline == EndNearSpline) && (EndSpline != nullptr) && (PathNodes.Num() > 1))
-		{
-			PathNodes[PathNodes.Num() - 1]->Location = EndSpline->FindLocationClosestToWorldLocation(TargetLocation, ESplineCoordinateSpace::World);
+	FinishRoadPath(Result.Path, Request.StartLocation, Request.TargetLocation);
 
-			OutEndSpline = EndSpline;
-		}
-		else if (EndNearSpline)
-		{
-			FVector TargetSplineLocation = EndNearSpline->FindLocationClosestToWorldLocation(TargetLocation, ESplineCoordinateSpace::World);
-			PathNodes.Add(MakeShared<FPathNode>(TargetSplineLocation));
+	// Release the graph snapshot before the callback, which may queue the next request
+	AsyncRequest->Snapshot = FRoadPathSearchSnapshot();
 
-			OutEndSpline = EndNearSpline;
-		}
+	if (AsyncRequest->OnCompleted)
+	{
+		FRoadPathRequestHandle Handle;
+		Handle.Id = RequestId;
+		AsyncRequest->OnCompleted(Handle, Result);
 	}
 }
 
 
-void ARoadActor::ApplyRightOffsetToPathNodes(TArray<FVector>& Path, float Width)
+bool ARoadActor::FindRoadPathSpans(const FRoadPathSearchSnapshot& Snapshot, int32 StartNodeId, int32 EndNodeId, const FSplineSegmentHit& StartHit,
+	const FSplineSegmentHit& EndHit, ERoadPathSearchMode SearchMode, FRoadPathSearchContext& SearchContext, TArray<FRoadPathSpan>& OutSpans)
 {
-	for (int32 i = 0; i < Path.Num(); i++)
+	OutSpans.Reset();
+
+	if (!Snapshot.Graph.IsValid() || Snapshot.Graph->GetNumNodes() == 0)
 	{
-		FVector& CurrentLocation = Path[i];
-		FVector* NextLocation = (i + 1 < Path.Num()) ? &Path[i + 1] : nullptr;
-		FVector* PreviousLocation = (i > 0) ? &Path[i - 1] : nullptr;
+		return false;
+	}
 
-		FVector RightVector;
+	const FRoadGraph& Graph = *Snapshot.Graph;
 
-		// Adjust location if there is either a NextLocation or PreviousLocation
-		if (NextLocation && PreviousLocation)
-		{
-			FVector ForwardVector1 = (*NextLocation - CurrentLocation).GetSafeNormal();
-			FVector ForwardVector2 = (CurrentLocation - *PreviousLocation).GetSafeNormal();
+	// Perform pathfinding
+	FRoadGraphPath GraphPath;
+	if (!URoadPathfindingComponent::FindGraphPath(Snapshot, StartNodeId, EndNodeId, GraphPath, SearchMode, SearchContext))
+	{
+		return false;
+	}
 
-			RightVector = FVector::CrossProduct(FVector::UpVector, (ForwardVector1 + ForwardVector2).GetSafeNormal()).GetSafeNormal();
+	// Clip or extend the path onto the splines nearest to the start and target
+	AdjustPathEnds(Graph, GraphPath, StartHit, EndHit, OutSpans);
+	return true;
+}
 
-			CurrentLocation += RightVector * Width / 4.0f;
-		}
-		else if (NextLocation || PreviousLocation)
-		{
-			FVector ForwardVector = NextLocation
-				? (*NextLocation - CurrentLocation).GetSafeNormal()
-				: (CurrentLocation - *PreviousLocation).GetSafeNormal();
 
-			RightVector = FVector::CrossProduct(FVector::UpVector, ForwardVector).GetSafeNormal();
+bool ARoadActor::ComputeRoadPath(const FRoadPathSearchSnapshot& Snapshot, int32 StartNodeId, int32 EndNodeId, const FSplineSegmentHit& StartHit,
+	const FSplineSegmentHit& EndHit, ERoadPathSearchMode SearchMode, int32 Lane, FRoadPathSearchContext& SearchContext, TArray<FVector>& OutPath)
+{
+	OutPath.Reset();
 
-			// Apply the right offset to the current location
-			CurrentLocation += RightVector * Width / 4.0f;
-		}
+	TArray<FRoadPathSpan> Spans;
+	if (!FindRoadPathSpans(Snapshot, StartNodeId, EndNodeId, StartHit, EndHit, SearchMode, SearchContext, Spans))
+	{
+		return false;
+	}
+
+	// Refine the path using the sampled lanes
+	OutPath = RefinePathWithSplinePoints(*Snapshot.Graph, Spans, Lane);
+	return true;
+}
+
+
+void ARoadActor::FinishRoadPath(TArray<FVector>& Path, const FVector& StartLocation, const FVector& TargetLocation)
+{
+	// Add start and end points if path is not empty
+	if (Path.Num() > 0)
+	{
+		Path = AddPathWithStartAndEndPoints(Path, StartLocation, TargetLocation);
 	}
 }
 
 
-// ---------- Node management functions ---------
-TArray<TSharedPtr<FPathNode>> ARoadActor::CreateDeepCopyOfPathNodes(const TArray<TSharedPtr<FPathNode>>& OriginalPathNodes)
+TArray<FVector> ARoadActor::RefinePathWithSplinePoints(const FRoadGraph& Graph, const TArray<FRoadPathSpan>& Spans, int32 Lane)
 {
-	TArray<TSharedPtr<FPathNode>> DeepCopy;
-	for (const TSharedPtr<FPathNode>& Node : OriginalPathNodes)
+	TArray<FVector> PathLocations;
+
+	// Every span already knows its spline and key range, copy that stretch of the lane sampled with the graph
+	for (const FRoadPathSpan& Span : Spans)
 	{
-		// Create a new shared pointer to a new FPathNode with copied location and properties
-		TSharedPtr<FPathNode> NewNode = MakeShared<FPathNode>(*Node);
-		DeepCopy.Add(NewNode);
+		if (const FRoadSplineLanes* SplineLanes = Graph.GetSplineLanes(Span.SplineIndex))
+		{
+			SplineLanes->AppendPoints(Span.StartKey, Span.EndKey, Lane, PathLocations);
+		}
 	}
-	return DeepCopy;
+
+	return PathLocations;
+}
+
+
+TArray<FVector> ARoadActor::AddPathWithStartAndEndPoints(TArray<FVector>& PathLocations, FVector StartLocation, FVector TargetLocation)
+{
+	TArray<FVector> RefinedPathLocations;
+
+	TArray<FVector> StartToFirstPointArray = GetPointsBetweenLocations(StartLocation, PathLocations[0], 400.0f);
+	TArray<FVector> LastPointToEndArray = GetPointsBetweenLocations(PathLocations[PathLocations.Num() - 1], TargetLocation, 400.0f);
+
+	RefinedPathLocations.Append(StartToFirstPointArray);
+	RefinedPathLocations.Append(PathLocations);
+	RefinedPathLocations.Append(LastPointToEndArray);
+
+	return RefinedPathLocations;
+}
+
+
+int64 ARoadActor::GetPathCacheHits() const
+{
+	return PathCache.GetNumHits();
+}
+
+
+int64 ARoadActor::GetPathCacheMisses() const
+{
+	return PathCache.GetNumMisses();
+}
+
+
+void ARoadActor::ResetPathCacheStats()
+{
+	PathCache.ResetStats();
 }
 
 
-TSharedPtr<FPathNode> ARoadActor::FindNearestNodeWithSpline(const FVector& Location)
+void ARoadActor::AdjustPathEnds(const FRoadGraph& Graph, const FRoadGraphPath& GraphPath, const FSplineSegmentHit& StartHit, const FSplineSegmentHit& EndHit, TArray<FRoadPathSpan>& OutSpans)
 {
-	// Find the nearest spline to the TargetLocation
-	USplineComponent* NearSpline = PathfindingComponent->FindNearestSplineComponent(Location);
+	OutSpans.Reset();
+
+	const int32 StartSplineIndex = Graph.FindSplineIndex(StartHit.SplineComponent);
+	const int32 EndSplineIndex = Graph.FindSplineIndex(EndHit.SplineComponent);
+
+	// Check if both the start and end are near the same spline
+	if (StartSplineIndex != INDEX_NONE && StartSplineIndex == EndSplineIndex)
+	{
+		OutSpans.Add({ StartSplineIndex, StartHit.InputKey, EndHit.InputKey });
+		return;
+	}
+
+	for (int32 EdgeId : GraphPath.Edges)
+	{
+		OutSpans.Add({ Graph.GetEdgeSpline(EdgeId), Graph.GetEdgeStartKey(EdgeId), Graph.GetEdgeEndKey(EdgeId) });
+	}
 
+	// Handle the start adjustment, clip the first span if it runs along the start spline, otherwise lead into the first node
+	if (StartSplineIndex != INDEX_NONE)
+	{
+		if (OutSpans.Num() > 0 && OutSpans[0].SplineIndex == StartSplineIndex)
+		{
+			OutSpans[0].StartKey = StartHit.InputKey;
+		}
+		else
+		{
+			const float NodeKey = Graph.GetSplineKeyAtNode(StartSplineIndex, GraphPath.Nodes[0]);
+			OutSpans.Insert({ StartSplineIndex, StartHit.InputKey, NodeKey }, 0);
+		}
+	}
+
+	// Handle the end adjustment the same way
+	if (EndSplineIndex != INDEX_NONE)
+	{
+		if (OutSpans.Num() > 0 && OutSpans.Last().SplineIndex == EndSplineIndex)
+		{
+			OutSpans.Last().EndKey = EndHit.InputKey;
+		}
+		else
+		{
+			const float NodeKey = Graph.GetSplineKeyAtNode(EndSplineIndex, GraphPath.Nodes.Last());
+			OutSpans.Add({ EndSplineIndex, NodeKey, EndHit.InputKey });
+		}
+	}
+}
+
+
+// ---------- Node management functions ---------
+int32 ARoadActor::FindNearestNodeWithSpline(const FRoadGraph& Graph, const FVector& Location, const FSplineSegmentHit& NearestHit)
+{
 	// Check if a spline was found
-	if (NearSpline)
+	const int32 SplineIndex = Graph.FindSplineIndex(NearestHit.SplineComponent);
+	if (SplineIndex != INDEX_NONE)
 	{
-		// Calculate start and end points of the nearest spline
-		FVector SplineStartLocation = NearSpline->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World);
-		FVector SplineEndLocation = NearSpline->GetLocationAtSplinePoint(NearSpline->GetNumberOfSplinePoints() - 1, ESplineCoordinateSpace::World);
+		// Determine which end node of the nearest spline is closest to the location
+		const int32 StartNodeId = Graph.GetSplineStartNode(SplineIndex);
+		const int32 EndNodeId = Graph.GetSplineEndNode(SplineIndex);
 
-		// Determine which endpoint is closest to the TargetLocation
-		FVector NearestLocation = (FVector::Dist(Location, SplineStartLocation) < FVector::Dist(Location, SplineEndLocation))
-			? SplineStartLocation
-			: SplineEndLocation;
+		return FVector::Dist(Location, Graph.GetNodeLocation(StartNodeId)) < FVector::Dist(Location, Graph.GetNodeLocation(EndNodeId))
+			? StartNodeId
+			: EndNodeId;
+	}
+
+	// No spline found, use the nearest node to the location
+	return Graph.FindNearestNode(Location);
+}
 
-		// Find and return the nearest node in AllPathNodes to the closest spline endpoint
-		return PathfindingComponent->FindNearestNodeByLocation(NearestLocation, AllPathNodes);
+TArray<FVector> ARoadActor::SnapToRoadNodes(const TArray<FVector>& Locations) const
+{
+	TArray<FVector> SnappedLocations = Locations;
+	if (!RoadGraph.IsValid())
+	{
+		return SnappedLocations;
 	}
-	else
+
+	TArray<int32> NodeIds;
+	RoadGraph->FindNearestNodesBatch(Locations, NodeIds);
+	for (int32 Index = 0; Index < NodeIds.Num(); Index++)
 	{
-		// No spline found, use the nearest node to the TargetLocation
-		return PathfindingComponent->FindNearestNodeByLocation(Location, AllPathNodes);
+		if (NodeIds[Index] != INDEX_NONE)
+		{
+			SnappedLocations[Index] = RoadGraph->GetNodeLocation(NodeIds[Index]);
+		}
 	}
+
+	return SnappedLocations;
 }
 
 
 // ---------- Debug functions ---------
 void ARoadActor::DrawAllSplineDebugLines()
 {
-	if (SplineQuadtree.IsValid())
+	if (SplineSpatialIndex.IsValid())
 	{
 		TArray<USplineComponent*> AllSplines;
-		SplineQuadtree->GetAllSplines(AllSplines);
+		SplineSpatialIndex->GetAllSplines(AllSplines);
 
 		// Draw debug lines for each spline
 		for (USplineComponent* SplineComponent : AllSplines)
@@ -0,0 +1,517 @@
+#include "RoadClusterHierarchy.h"
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Keeps cluster coordinates within int32
+    constexpr double MaxCellCoord = static_cast<double>(1 << 29);
+}
+
+// ---------- Constructor ---------
+FRoadClusterHierarchy::FRoadClusterHierarchy()
+    : ClusterSize(0.0), NumNodes(0), GraphRevision(0)
+{
+}
+
+// ---------- Building ---------
+double FRoadClusterHierarchy::ChooseClusterSize(const FRoadGraph& Graph, int32 NodesPerCluster)
+{
+    FBox2D NodeBounds(ForceInit);
+    int32 NumActiveNodes = 0;
+    for (int32 NodeId = 0; NodeId < Graph.GetNumNodes(); NodeId++)
+    {
+        if (Graph.IsNodeActive(NodeId))
+        {
+            const FVector Location = Graph.GetNodeLocation(NodeId);
+            NodeBounds += FVector2D(Location.X, Location.Y);
+            NumActiveNodes++;
+        }
+    }
+
+    if (NumActiveNodes == 0)
+    {
+        return 10000.0;
+    }
+
+    const FVector2D Size = NodeBounds.GetSize();
+    const double Area = FMath::Max(Size.X, 1.0) * FMath::Max(Size.Y, 1.0);
+    return FMath::Max(FMath::Sqrt(Area * FMath::Max(NodesPerCluster, 1) / NumActiveNodes), 100.0);
+}
+
+void FRoadClusterHierarchy::Build(const FRoadGraph& Graph, double InClusterSize)
+{
+    ClusterSize = FMath::Max(InClusterSize, 1.0);
+    NumNodes = Graph.GetNumNodes();
+    GraphRevision = Graph.GetRevision();
+    Clusters.Reset();
+    ClusterIndices.Reset();
+    NodeClusters.Init(INDEX_NONE, NumNodes);
+    NodeLocalIndices.Init(INDEX_NONE, NumNodes);
+    NodeBorderIndices.Init(INDEX_NONE, NumNodes);
+    NodeHashes.Init(0, NumNodes);
+
+    for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+    {
+        if (Graph.IsNodeActive(NodeId))
+        {
+            AddNode(NodeId, FindOrAddCluster(Graph.GetNodeLocation(NodeId)));
+            NodeHashes[NodeId] = HashNode(Graph, NodeId);
+        }
+    }
+
+    // Clusters only write the border indices of their own nodes, so they can be built side by side
+    ParallelFor(Clusters.Num(), [&](int32 ClusterIndex)
+        {
+            BuildCluster(Graph, ClusterIndex);
+        });
+}
+
+int32 FRoadClusterHierarchy::Update(const FRoadGraph& Graph)
+{
+    // Node ids are only ever added by edits, fewer nodes means the graph was built again
+    if (ClusterSize <= 0.0 || Graph.GetNumNodes() < NumNodes)
+    {
+        Build(Graph, ClusterSize > 0.0 ? ClusterSize : ChooseClusterSize(Graph));
+        return Clusters.Num();
+    }
+
+    TArray<int32> NodeIds;
+    NodeIds.SetNumUninitialized(Graph.GetNumNodes());
+    for (int32 NodeId = 0; NodeId < NodeIds.Num(); NodeId++)
+    {
+        NodeIds[NodeId] = NodeId;
+    }
+    return UpdateNodes(Graph, NodeIds);
+}
+
+int32 FRoadClusterHierarchy::Update(const FRoadGraph& Graph, const FRoadGraphEdit& Edit)
+{
+    if (ClusterSize <= 0.0 || Graph.GetNumNodes() < NumNodes)
+    {
+        Build(Graph, ClusterSize > 0.0 ? ClusterSize : ChooseClusterSize(Graph));
+        return Clusters.Num();
+    }
+
+    // Only the ends of the edited splines got other edges, were freed or were handed out again
+    return UpdateNodes(Graph, Edit.Nodes);
+}
+
+bool FRoadClusterHierarchy::IsBuiltFor(const FRoadGraph& Graph) const
+{
+    return ClusterSize > 0.0 && GraphRevision == Graph.GetRevision();
+}
+
+uint32 FRoadClusterHierarchy::GetGraphRevision() const
+{
+    return GraphRevision;
+}
+
+// ---------- Queries ---------
+bool FRoadClusterHierarchy::FindPath(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadPathSearchContext& Context, FRoadGraphPath& OutPath) const
+{
+    FPathSearchScratch& Scratch = Context.ForwardScratch;
+    OutPath.Reset();
+    Scratch.BeginSearch(Graph.GetNumNodes());
+
+    if (!NodeClusters.IsValidIndex(StartNodeId) || !NodeClusters.IsValidIndex(GoalNodeId)
+        || NodeClusters[StartNodeId] == INDEX_NONE || NodeClusters[GoalNodeId] == INDEX_NONE)
+    {
+        return false;
+    }
+
+    if (StartNodeId == GoalNodeId)
+    {
+        OutPath.Nodes.Add(StartNodeId);
+        return true;
+    }
+
+    // The start and the goal join the abstract graph through their distances to the border nodes of their clusters
+    const int32 StartCluster = NodeClusters[StartNodeId];
+    const int32 GoalCluster = NodeClusters[GoalNodeId];
+    FPathSearchScratch& StartSearch = Context.StartClusterScratch;
+    FPathSearchScratch& GoalSearch = Context.GoalClusterScratch;
+    SearchCluster(Graph, StartNodeId, INDEX_NONE, StartSearch);
+    SearchCluster(Graph, GoalNodeId, INDEX_NONE, GoalSearch);
+
+    // Every abstract hop is at least as long as the straight line, so the heuristic stays consistent
+    const FVector GoalLocation = Graph.GetNodeLocation(GoalNodeId);
+    auto Relax = [&](int32 FromNodeId, int32 ToNodeId, float Cost)
+        {
+            if (Cost == TNumericLimits<float>::Max() || Scratch.IsClosed(ToNodeId))
+            {
+                return;
+            }
+
+            const float GScore = Scratch.GetGScore(FromNodeId) + Cost;
+            if (GScore < Scratch.GetGScore(ToNodeId))
+            {
+                Scratch.SetPath(ToNodeId, GScore, FromNodeId, GScore + static_cast<float>(FVector::Distance(Graph.GetNodeLocation(ToNodeId), GoalLocation)));
+            }
+        };
+
+    Scratch.SetPath(StartNodeId, 0.0f, INDEX_NONE, static_cast<float>(FVector::Distance(Graph.GetNodeLocation(StartNodeId), GoalLocation)));
+
+    bool bFound = false;
+    while (Scratch.HasOpenNodes())
+    {
+        const int32 CurrentId = Scratch.PopAndClose();
+        if (CurrentId == GoalNodeId)
+        {
+            bFound = true;
+            break;
+        }
+
+        const int32 ClusterIndex = NodeClusters[CurrentId];
+        const FCluster& Cluster = Clusters[ClusterIndex];
+        const int32 BorderIndex = NodeBorderIndices[CurrentId];
+        const int32 NumBorderNodes = Cluster.BorderNodes.Num();
+
+        // Hops to the other border nodes of the cluster, the start reaches them through its own search
+        if (BorderIndex != INDEX_NONE)
+        {
+            const float* Distances = &Cluster.BorderDistances[BorderIndex * NumBorderNodes];
+            for (int32 ToIndex = 0; ToIndex < NumBorderNodes; ToIndex++)
+            {
+                if (ToIndex != BorderIndex)
+                {
+                    Relax(CurrentId, Cluster.BorderNodes[ToIndex], Distances[ToIndex]);
+                }
+            }
+        }
+        else if (CurrentId == StartNodeId)
+        {
+            for (const int32 BorderNodeId : Cluster.BorderNodes)
+            {
+                Relax(CurrentId, BorderNodeId, StartSearch.GetGScore(NodeLocalIndices[BorderNodeId]));
+            }
+        }
+
+        // Edges are as long both ways, so the search from the goal holds the distances to it
+        if (ClusterIndex == GoalCluster)
+        {
+            Relax(CurrentId, GoalNodeId, GoalSearch.GetGScore(NodeLocalIndices[CurrentId]));
+        }
+
+        // Hops into the neighbouring clusters
+        if (BorderIndex != INDEX_NONE)
+        {
+            for (int32 EdgeId = Graph.GetFirstEdge(CurrentId); EdgeId < Graph.GetEndEdge(CurrentId); EdgeId++)
+            {
+                const int32 NeighborId = Graph.GetEdgeTarget(EdgeId);
+                if (NodeClusters[NeighborId] != ClusterIndex)
+                {
+                    Relax(CurrentId, NeighborId, Graph.GetEdgeLength(EdgeId));
+                }
+            }
+        }
+    }
+
+    if (!bFound)
+    {
+        return false;
+    }
+
+    // Abstract nodes from the goal back to the start, each hop is then refined on the graph
+    TArray<int32> AbstractNodes;
+    for (int32 NodeId = GoalNodeId; NodeId != INDEX_NONE; NodeId = Scratch.GetParent(NodeId))
+    {
+        AbstractNodes.Add(NodeId);
+    }
+    Algo::Reverse(AbstractNodes);
+
+    // The start search is no longer needed, the hops reuse its buffers
+    for (int32 HopIndex = 0; HopIndex + 1 < AbstractNodes.Num(); HopIndex++)
+    {
+        if (!RefineHop(Graph, AbstractNodes[HopIndex], AbstractNodes[HopIndex + 1], StartSearch, OutPath.Edges))
+        {
+            OutPath.Reset();
+            return false;
+        }
+    }
+
+    OutPath.Length = Scratch.GetGScore(GoalNodeId);
+    OutPath.Nodes.Reserve(OutPath.Edges.Num() + 1);
+    OutPath.Nodes.Add(StartNodeId);
+    for (const int32 EdgeId : OutPath.Edges)
+    {
+        OutPath.Nodes.Add(Graph.GetEdgeTarget(EdgeId));
+    }
+
+    return true;
+}
+
+double FRoadClusterHierarchy::GetClusterSize() const
+{
+    return ClusterSize;
+}
+
+int32 FRoadClusterHierarchy::GetNumClusters() const
+{
+    return Clusters.Num();
+}
+
+int32 FRoadClusterHierarchy::GetNumBorderNodes() const
+{
+    int32 NumBorderNodes = 0;
+    for (const FCluster& Cluster : Clusters)
+    {
+        NumBorderNodes += Cluster.BorderNodes.Num();
+    }
+    return NumBorderNodes;
+}
+
+SIZE_T FRoadClusterHierarchy::GetAllocatedSize() const
+{
+    SIZE_T Size = Clusters.GetAllocatedSize() + ClusterIndices.GetAllocatedSize() + NodeClusters.GetAllocatedSize()
+        + NodeLocalIndices.GetAllocatedSize() + NodeBorderIndices.GetAllocatedSize() + NodeHashes.GetAllocatedSize();
+    for (const FCluster& Cluster : Clusters)
+    {
+        Size += Cluster.Nodes.GetAllocatedSize() + Cluster.BorderNodes.GetAllocatedSize() + Cluster.BorderDistances.GetAllocatedSize();
+    }
+    return Size;
+}
+
+// ---------- Private Methods ---------
+FIntPoint FRoadClusterHierarchy::GetCell(const FVector& Location) const
+{
+    return FIntPoint(
+        FMath::FloorToInt32(FMath::Clamp(Location.X / ClusterSize, -MaxCellCoord, MaxCellCoord)),
+        FMath::FloorToInt32(FMath::Clamp(Location.Y / ClusterSize, -MaxCellCoord, MaxCellCoord)));
+}
+
+int32 FRoadClusterHierarchy::FindOrAddCluster(const FVector& Location)
+{
+    const FIntPoint Cell = GetCell(Location);
+    if (const int32* ClusterIndex = ClusterIndices.Find(Cell))
+    {
+        return *ClusterIndex;
+    }
+
+    const int32 ClusterIndex = Clusters.AddDefaulted();
+    ClusterIndices.Add(Cell, ClusterIndex);
+    return ClusterIndex;
+}
+
+void FRoadClusterHierarchy::AddNode(int32 NodeId, int32 ClusterIndex)
+{
+    NodeClusters[NodeId] = ClusterIndex;
+    NodeLocalIndices[NodeId] = Clusters[ClusterIndex].Nodes.Add(NodeId);
+    NodeBorderIndices[NodeId] = INDEX_NONE;
+}
+
+void FRoadClusterHierarchy::RemoveNode(int32 NodeId)
+{
+    TArray<int32>& Nodes = Clusters[NodeClusters[NodeId]].Nodes;
+    const int32 LocalIndex = NodeLocalIndices[NodeId];
+    Nodes.RemoveAtSwap(LocalIndex, 1, EAllowShrinking::No);
+    if (LocalIndex < Nodes.Num())
+    {
+        NodeLocalIndices[Nodes[LocalIndex]] = LocalIndex;
+    }
+
+    NodeClusters[NodeId] = INDEX_NONE;
+    NodeLocalIndices[NodeId] = INDEX_NONE;
+    NodeBorderIndices[NodeId] = INDEX_NONE;
+}
+
+int32 FRoadClusterHierarchy::UpdateNodes(const FRoadGraph& Graph, TConstArrayView<int32> NodeIds)
+{
+    const int32 NewNumNodes = Graph.GetNumNodes();
+    NodeClusters.SetNum(NewNumNodes);
+    NodeLocalIndices.SetNum(NewNumNodes);
+    NodeBorderIndices.SetNum(NewNumNodes);
+    NodeHashes.SetNum(NewNumNodes);
+    for (int32 NodeId = NumNodes; NodeId < NewNumNodes; NodeId++)
+    {
+        NodeClusters[NodeId] = INDEX_NONE;
+        NodeLocalIndices[NodeId] = INDEX_NONE;
+        NodeBorderIndices[NodeId] = INDEX_NONE;
+        NodeHashes[NodeId] = 0;
+    }
+
+    TSet<int32> DirtyClusters;
+    TArray<int32> MovedNodes;
+    for (const int32 NodeId : NodeIds)
+    {
+        const bool bActive = Graph.IsNodeActive(NodeId);
+        const uint32 Hash = bActive ? HashNode(Graph, NodeId) : 0;
+        if (Hash == NodeHashes[NodeId] && bActive == (NodeClusters[NodeId] != INDEX_NONE))
+        {
+            continue;
+        }
+
+        // Freed ids may be reused anywhere, so the cluster is looked up again
+        const int32 OldCluster = NodeClusters[NodeId];
+        const int32 NewCluster = bActive ? FindOrAddCluster(Graph.GetNodeLocation(NodeId)) : INDEX_NONE;
+        if (NewCluster != OldCluster)
+        {
+            if (OldCluster != INDEX_NONE)
+            {
+                RemoveNode(NodeId);
+                DirtyClusters.Add(OldCluster);
+            }
+            if (NewCluster != INDEX_NONE)
+            {
+                AddNode(NodeId, NewCluster);
+            }
+            MovedNodes.Add(NodeId);
+        }
+
+        if (NewCluster != INDEX_NONE)
+        {
+            DirtyClusters.Add(NewCluster);
+        }
+        NodeHashes[NodeId] = Hash;
+    }
+
+    // A node that changed cluster may turn its neighbours into border nodes or back
+    for (const int32 NodeId : MovedNodes)
+    {
+        if (NodeClusters[NodeId] == INDEX_NONE)
+        {
+            continue;
+        }
+
+        for (int32 EdgeId = Graph.GetFirstEdge(NodeId); EdgeId < Graph.GetEndEdge(NodeId); EdgeId++)
+        {
+            const int32 NeighborCluster = NodeClusters[Graph.GetEdgeTarget(EdgeId)];
+            if (NeighborCluster != INDEX_NONE)
+            {
+                DirtyClusters.Add(NeighborCluster);
+            }
+        }
+    }
+
+    NumNodes = NewNumNodes;
+    GraphRevision = Graph.GetRevision();
+
+    const TArray<int32> DirtyClusterIndices = DirtyClusters.Array();
+    ParallelFor(DirtyClusterIndices.Num(), [&](int32 DirtyIndex)
+        {
+            BuildCluster(Graph, DirtyClusterIndices[DirtyIndex]);
+        });
+
+    return DirtyClusterIndices.Num();
+}
+
+uint32 FRoadClusterHierarchy::HashNode(const FRoadGraph& Graph, int32 NodeId)
+{
+    // Edge ids are reassigned by every edit, so only targets and lengths go in, summed to ignore their order
+    uint32 EdgeHash = 0;
+    for (int32 EdgeId = Graph.GetFirstEdge(NodeId); EdgeId < Graph.GetEndEdge(NodeId); EdgeId++)
+    {
+        EdgeHash += HashCombineFast(GetTypeHash(Graph.GetEdgeTarget(EdgeId)), GetTypeHash(Graph.GetEdgeLength(EdgeId)));
+    }
+
+    // Never 0, which marks nodes the hierarchy hasn't seen
+    return HashCombineFast(GetTypeHash(Graph.GetNodeLocation(NodeId)), EdgeHash) | 1u;
+}
+
+void FRoadClusterHierarchy::BuildCluster(const FRoadGraph& Graph, int32 ClusterIndex)
+{
+    FCluster& Cluster = Clusters[ClusterIndex];
+    Cluster.BorderNodes.Reset();
+
+    for (const int32 NodeId : Cluster.Nodes)
+    {
+        NodeBorderIndices[NodeId] = INDEX_NONE;
+        for (int32 EdgeId = Graph.GetFirstEdge(NodeId); EdgeId < Graph.GetEndEdge(NodeId); EdgeId++)
+        {
+            if (NodeClusters[Graph.GetEdgeTarget(EdgeId)] != ClusterIndex)
+            {
+                NodeBorderIndices[NodeId] = Cluster.BorderNodes.Add(NodeId);
+                break;
+            }
+        }
+    }
+
+    const int32 NumBorderNodes = Cluster.BorderNodes.Num();
+    Cluster.BorderDistances.SetNumUninitialized(NumBorderNodes * NumBorderNodes);
+
+    FPathSearchScratch Search;
+    for (int32 FromIndex = 0; FromIndex < NumBorderNodes; FromIndex++)
+    {
+        SearchCluster(Graph, Cluster.BorderNodes[FromIndex], INDEX_NONE, Search);
+        for (int32 ToIndex = 0; ToIndex < NumBorderNodes; ToIndex++)
+        {
+            Cluster.BorderDistances[FromIndex * NumBorderNodes + ToIndex] = Search.GetGScore(NodeLocalIndices[Cluster.BorderNodes[ToIndex]]);
+        }
+    }
+}
+
+void FRoadClusterHierarchy::SearchCluster(const FRoadGraph& Graph, int32 SourceNodeId, int32 TargetNodeId, FPathSearchScratch& Search) const
+{
+    const int32 ClusterIndex = NodeClusters[SourceNodeId];
+    const FCluster& Cluster = Clusters[ClusterIndex];
+    Search.BeginSearch(Cluster.Nodes.Num());
+    Search.SetPath(NodeLocalIndices[SourceNodeId], 0.0f, INDEX_NONE, 0.0f);
+
+    while (Search.HasOpenNodes())
+    {
+        const int32 CurrentIndex = Search.PopAndClose();
+        const int32 CurrentId = Cluster.Nodes[CurrentIndex];
+        if (CurrentId == TargetNodeId)
+        {
+            break;
+        }
+
+        for (int32 EdgeId = Graph.GetFirstEdge(CurrentId); EdgeId < Graph.GetEndEdge(CurrentId); EdgeId++)
+        {
+            const int32 NeighborId = Graph.GetEdgeTarget(EdgeId);
+            if (NodeClusters[NeighborId] != ClusterIndex)
+            {
+                continue;
+            }
+
+            const int32 NeighborIndex = NodeLocalIndices[NeighborId];
+            const float Distance = Search.GetGScore(CurrentIndex) + Graph.GetEdgeLength(EdgeId);
+            if (!Search.IsClosed(NeighborIndex) && Distance < Search.GetGScore(NeighborIndex))
+            {
+                Search.SetPath(NeighborIndex, Distance, EdgeId, Distance);
+            }
+        }
+    }
+}
+
+bool FRoadClusterHierarchy::RefineHop(const FRoadGraph& Graph, int32 FromNodeId, int32 ToNodeId, FPathSearchScratch& Search, TArray<int32>& OutEdges) const
+{
+    // Hops between clusters are single edges, take the shortest if several splines connect the two nodes
+    if (NodeClusters[FromNodeId] != NodeClusters[ToNodeId])
+    {
+        int32 BestEdge = INDEX_NONE;
+        for (int32 EdgeId = Graph.GetFirstEdge(FromNodeId); EdgeId < Graph.GetEndEdge(FromNodeId); EdgeId++)
+        {
+            if (Graph.GetEdgeTarget(EdgeId) == ToNodeId && (BestEdge == INDEX_NONE || Graph.GetEdgeLength(EdgeId) < Graph.GetEdgeLength(BestEdge)))
+            {
+                BestEdge = EdgeId;
+            }
+        }
+
+        if (BestEdge == INDEX_NONE)
+        {
+            return false;
+        }
+
+        OutEdges.Add(BestEdge);
+        return true;
+    }
+
+    // Hops inside a cluster are searched again, only within that cluster
+    SearchCluster(Graph, FromNodeId, ToNodeId, Search);
+
+    const int32 FirstEdge = OutEdges.Num();
+    for (int32 NodeId = ToNodeId; NodeId != FromNodeId; )
+    {
+        const int32 EdgeId = Search.GetParent(NodeLocalIndices[NodeId]);
+        if (EdgeId == INDEX_NONE)
+        {
+            return false;
+        }
+
+        OutEdges.Add(EdgeId);
+        NodeId = Graph.GetEdgeSource(EdgeId);
+    }
+    Algo::Reverse(OutEdges.GetData() + FirstEdge, OutEdges.Num() - FirstEdge);
+    return true;
+}
@@ -0,0 +1,505 @@
+#include "RoadContractionHierarchy.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Count.h"
+
+// Contracts the nodes of a road graph on a working copy of its adjacency
+class FRoadContractionBuilder
+{
+public:
+    explicit FRoadContractionBuilder(const FRoadGraph& InGraph);
+
+    void Run(FRoadContractionHierarchy& Out);
+
+private:
+    struct FNeighbor
+    {
+        int32 NodeId;
+        float Weight;
+        int32 ArcId;
+    };
+
+    struct FShortcut
+    {
+        int32 NodeA;
+        int32 NodeB;
+        float Weight;
+        int32 ArcA;
+        int32 ArcB;
+    };
+
+    struct FQueuedNode
+    {
+        int32 Priority;
+        int32 NodeId;
+
+        bool operator<(const FQueuedNode& Other) const
+        {
+            return Priority < Other.Priority || (Priority == Other.Priority && NodeId < Other.NodeId);
+        }
+    };
+
+    // Witness searches give up after this many nodes, a missed witness only costs a redundant shortcut
+    static constexpr int32 MaxWitnessSettledNodes = 500;
+    static constexpr int32 NodesPerPriorityBatch = 1024;
+
+    void AddOriginalArcs();
+    int32 AddArc(int32 NodeA, int32 NodeB, int32 EdgeId, int32 Middle, int32 ChildA, int32 ChildB);
+    void SetNeighbor(int32 NodeId, int32 NeighborId, float Weight, int32 ArcId);
+    int32 FindNeighbor(int32 NodeId, int32 NeighborId) const;
+
+    void WitnessSearch(int32 SourceId, int32 ExcludedId, float MaxDistance, FPathSearchScratch& Scratch) const;
+    void FindShortcuts(int32 NodeId, FPathSearchScratch& Scratch, TArray<FShortcut>& OutShortcuts) const;
+    int32 ComputePriority(int32 NodeId, FPathSearchScratch& Scratch, TArray<FShortcut>& OutShortcuts) const;
+    void ContractNode(int32 NodeId, const TArray<FShortcut>& Shortcuts);
+
+    const FRoadGraph& Graph;
+    const int32 NumNodes;
+
+    // Arcs to the nodes that are not contracted yet
+    TArray<TArray<FNeighbor>> Adjacency;
+    TArray<TArray<FNeighbor>> UpwardArcs;
+    TArray<int32> DeletedNeighbors;
+
+    TArray<int32> ArcNodesA;
+    TArray<int32> ArcNodesB;
+    TArray<int32> ArcEdges;
+    TArray<int32> ArcMiddles;
+    TArray<int32> ArcChildrenA;
+    TArray<int32> ArcChildrenB;
+};
+
+// ---------- Constructor ---------
+FRoadContractionBuilder::FRoadContractionBuilder(const FRoadGraph& InGraph)
+    : Graph(InGraph), NumNodes(InGraph.GetNumNodes())
+{
+    Adjacency.SetNum(NumNodes);
+    UpwardArcs.SetNum(NumNodes);
+    DeletedNeighbors.Init(0, NumNodes);
+}
+
+// ---------- Public Methods ---------
+void FRoadContractionBuilder::Run(FRoadContractionHierarchy& Out)
+{
+    AddOriginalArcs();
+
+    // Initial priorities are independent simulated contractions, evaluate them in parallel batches
+    TArray<int32> Priorities;
+    Priorities.SetNumUninitialized(NumNodes);
+
+    const int32 NumBatches = FMath::DivideAndRoundUp(NumNodes, NodesPerPriorityBatch);
+    ParallelFor(NumBatches, [&](int32 BatchIndex)
+        {
+            FPathSearchScratch Scratch;
+            TArray<FShortcut> Shortcuts;
+
+            const int32 EndNode = FMath::Min((BatchIndex + 1) * NodesPerPriorityBatch, NumNodes);
+            for (int32 NodeId = BatchIndex * NodesPerPriorityBatch; NodeId < EndNode; NodeId++)
+            {
+                Priorities[NodeId] = ComputePriority(NodeId, Scratch, Shortcuts);
+            }
+        });
+
+    TArray<FQueuedNode> Queue;
+    Queue.Reserve(NumNodes);
+    for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+    {
+        Queue.Add({ Priorities[NodeId], NodeId });
+    }
+    Queue.Heapify();
+
+    FPathSearchScratch Scratch;
+    TArray<FShortcut> Shortcuts;
+    while (Queue.Num() > 0)
+    {
+        FQueuedNode Node;
+        Queue.HeapPop(Node, EAllowShrinking::No);
+
+        // Priorities go stale as neighbours are contracted, so re-evaluate lazily and requeue the node
+        // when it is no longer the cheapest one
+        const int32 Priority = ComputePriority(Node.NodeId, Scratch, Shortcuts);
+        if (Queue.Num() > 0 && Priority > Queue.HeapTop().Priority)
+        {
+            Queue.HeapPush({ Priority, Node.NodeId });
+            continue;
+        }
+
+        ContractNode(Node.NodeId, Shortcuts);
+    }
+
+    Out.Reset();
+    Out.NumNodes = NumNodes;
+    Out.NumEdges = Graph.GetNumEdges();
+    Out.GraphChecksum = Graph.ComputeChecksum();
+
+    Out.UpOffsets.SetNumUninitialized(NumNodes + 1);
+    Out.UpOffsets[0] = 0;
+    for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+    {
+        Out.UpOffsets[NodeId + 1] = Out.UpOffsets[NodeId] + UpwardArcs[NodeId].Num();
+    }
+
+    const int32 NumUpArcs = Out.UpOffsets[NumNodes];
+    Out.UpTargets.Reserve(NumUpArcs);
+    Out.UpWeights.Reserve(NumUpArcs);
+    Out.UpArcs.Reserve(NumUpArcs);
+    for (const TArray<FNeighbor>& Arcs : UpwardArcs)
+    {
+        for (const FNeighbor& Arc : Arcs)
+        {
+            Out.UpTargets.Add(Arc.NodeId);
+            Out.UpWeights.Add(Arc.Weight);
+            Out.UpArcs.Add(Arc.ArcId);
+        }
+    }
+
+    Out.ArcNodesA = MoveTemp(ArcNodesA);
+    Out.ArcNodesB = MoveTemp(ArcNodesB);
+    Out.ArcEdges = MoveTemp(ArcEdges);
+    Out.ArcMiddles = MoveTemp(ArcMiddles);
+    Out.ArcChildrenA = MoveTemp(ArcChildrenA);
+    Out.ArcChildrenB = MoveTemp(ArcChildrenB);
+}
+
+// ---------- Private Methods ---------
+void FRoadContractionBuilder::AddOriginalArcs()
+{
+    // Every edge has a reverse, so visiting each node pair from its lower id covers the graph.
+    // Parallel splines between the same nodes collapse into one arc with the shortest edge.
+    for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+    {
+        const int32 EndEdge = Graph.GetEndEdge(NodeId);
+        for (int32 EdgeId = Graph.GetFirstEdge(NodeId); EdgeId < EndEdge; EdgeId++)
+        {
+            const int32 TargetId = Graph.GetEdgeTarget(EdgeId);
+            if (TargetId <= NodeId)
+            {
+                continue;
+            }
+
+            const float Length = Graph.GetEdgeLength(EdgeId);
+            const int32 NeighborIndex = FindNeighbor(NodeId, TargetId);
+            if (NeighborIndex == INDEX_NONE)
+            {
+                const int32 ArcId = AddArc(NodeId, TargetId, EdgeId, INDEX_NONE, INDEX_NONE, INDEX_NONE);
+                SetNeighbor(NodeId, TargetId, Length, ArcId);
+                SetNeighbor(TargetId, NodeId, Length, ArcId);
+            }
+            else if (Length < Adjacency[NodeId][NeighborIndex].Weight)
+            {
+                const int32 ArcId = Adjacency[NodeId][NeighborIndex].ArcId;
+                ArcEdges[ArcId] = EdgeId;
+                SetNeighbor(NodeId, TargetId, Length, ArcId);
+                SetNeighbor(TargetId, NodeId, Length, ArcId);
+            }
+        }
+    }
+}
+
+int32 FRoadContractionBuilder::AddArc(int32 NodeA, int32 NodeB, int32 EdgeId, int32 Middle, int32 ChildA, int32 ChildB)
+{
+    const int32 ArcId = ArcNodesA.Add(NodeA);
+    ArcNodesB.Add(NodeB);
+    ArcEdges.Add(EdgeId);
+    ArcMiddles.Add(Middle);
+    ArcChildrenA.Add(ChildA);
+    ArcChildrenB.Add(ChildB);
+    return ArcId;
+}
+
+void FRoadContractionBuilder::SetNeighbor(int32 NodeId, int32 NeighborId, float Weight, int32 ArcId)
+{
+    const int32 NeighborIndex = FindNeighbor(NodeId, NeighborId);
+    if (NeighborIndex == INDEX_NONE)
+    {
+        Adjacency[NodeId].Add({ NeighborId, Weight, ArcId });
+    }
+    else
+    {
+        Adjacency[NodeId][NeighborIndex] = { NeighborId, Weight, ArcId };
+    }
+}
+
+int32 FRoadContractionBuilder::FindNeighbor(int32 NodeId, int32 NeighborId) const
+{
+    return Adjacency[NodeId].IndexOfByPredicate([NeighborId](const FNeighbor& Neighbor)
+        {
+            return Neighbor.NodeId == NeighborId;
+        });
+}
+
+void FRoadContractionBuilder::WitnessSearch(int32 SourceId, int32 ExcludedId, float MaxDistance, FPathSearchScratch& Scratch) const
+{
+    Scratch.BeginSearch(NumNodes);
+    Scratch.SetPath(SourceId, 0.0f, INDEX_NONE, 0.0f);
+
+    int32 NumSettled = 0;
+    while (Scratch.HasOpenNodes() && Scratch.GetMinPriority() <= MaxDistance && NumSettled < MaxWitnessSettledNodes)
+    {
+        const int32 CurrentId = Scratch.PopAndClose();
+        const float CurrentDistance = Scratch.GetGScore(CurrentId);
+        NumSettled++;
+
+        for (const FNeighbor& Neighbor : Adjacency[CurrentId])
+        {
+            if (Neighbor.NodeId == ExcludedId || Scratch.IsClosed(Neighbor.NodeId))
+            {
+                continue;
+            }
+
+            const float Distance = CurrentDistance + Neighbor.Weight;
+            if (Distance < Scratch.GetGScore(Neighbor.NodeId))
+            {
+                Scratch.SetPath(Neighbor.NodeId, Distance, INDEX_NONE, Distance);
+            }
+        }
+    }
+}
+
+void FRoadContractionBuilder::FindShortcuts(int32 NodeId, FPathSearchScratch& Scratch, TArray<FShortcut>& OutShortcuts) const
+{
+    OutShortcuts.Reset();
+
+    // A pair of neighbours needs a shortcut unless a witness path around the node is at most as long
+    const TArray<FNeighbor>& Neighbors = Adjacency[NodeId];
+    for (int32 FromIndex = 0; FromIndex < Neighbors.Num() - 1; FromIndex++)
+    {
+        const FNeighbor& From = Neighbors[FromIndex];
+
+        float MaxDistance = 0.0f;
+        for (int32 ToIndex = FromIndex + 1; ToIndex < Neighbors.Num(); ToIndex++)
+        {
+            MaxDistance = FMath::Max(MaxDistance, From.Weight + Neighbors[ToIndex].Weight);
+        }
+
+        WitnessSearch(From.NodeId, NodeId, MaxDistance, Scratch);
+
+        for (int32 ToIndex = FromIndex + 1; ToIndex < Neighbors.Num(); ToIndex++)
+        {
+            const FNeighbor& To = Neighbors[ToIndex];
+            const float ViaDistance = From.Weight + To.Weight;
+            if (Scratch.GetGScore(To.NodeId) > ViaDistance)
+            {
+                OutShortcuts.Add({ From.NodeId, To.NodeId, ViaDistance, From.ArcId, To.ArcId });
+            }
+        }
+    }
+}
+
+int32 FRoadContractionBuilder::ComputePriority(int32 NodeId, FPathSearchScratch& Scratch, TArray<FShortcut>& OutShortcuts) const
+{
+    // Edge difference plus the contracted neighbours, which spreads the contraction evenly over the map
+    FindShortcuts(NodeId, Scratch, OutShortcuts);
+    return OutShortcuts.Num() - Adjacency[NodeId].Num() + DeletedNeighbors[NodeId];
+}
+
+void FRoadContractionBuilder::ContractNode(int32 NodeId, const TArray<FShortcut>& Shortcuts)
+{
+    // The remaining neighbours are contracted later, so these arcs lead upward
+    UpwardArcs[NodeId] = MoveTemp(Adjacency[NodeId]);
+    Adjacency[NodeId].Reset();
+
+    for (const FNeighbor& Neighbor : UpwardArcs[NodeId])
+    {
+        Adjacency[Neighbor.NodeId].RemoveAllSwap([NodeId](const FNeighbor& Other)
+            {
+                return Other.NodeId == NodeId;
+            });
+        DeletedNeighbors[Neighbor.NodeId]++;
+    }
+
+    for (const FShortcut& Shortcut : Shortcuts)
+    {
+        const int32 NeighborIndex = FindNeighbor(Shortcut.NodeA, Shortcut.NodeB);
+        if (NeighborIndex != INDEX_NONE && Adjacency[Shortcut.NodeA][NeighborIndex].Weight <= Shortcut.Weight)
+        {
+            continue;
+        }
+
+        const int32 ArcId = AddArc(Shortcut.NodeA, Shortcut.NodeB, INDEX_NONE, NodeId, Shortcut.ArcA, Shortcut.ArcB);
+        SetNeighbor(Shortcut.NodeA, Shortcut.NodeB, Shortcut.Weight, ArcId);
+        SetNeighbor(Shortcut.NodeB, Shortcut.NodeA, Shortcut.Weight, ArcId);
+    }
+}
+
+// ---------- Public Methods ---------
+void FRoadContractionHierarchy::Build(const FRoadGraph& Graph)
+{
+    FRoadContractionBuilder Builder(Graph);
+    Builder.Run(*this);
+}
+
+void FRoadContractionHierarchy::Reset()
+{
+    NumNodes = 0;
+    NumEdges = 0;
+    GraphChecksum = 0;
+    UpOffsets.Reset();
+    UpTargets.Reset();
+    UpWeights.Reset();
+    UpArcs.Reset();
+    ArcNodesA.Reset();
+    ArcNodesB.Reset();
+    ArcEdges.Reset();
+    ArcMiddles.Reset();
+    ArcChildrenA.Reset();
+    ArcChildrenB.Reset();
+}
+
+bool FRoadContractionHierarchy::IsBuiltFor(const FRoadGraph& Graph) const
+{
+    return NumNodes > 0
+        && NumNodes == Graph.GetNumNodes()
+        && NumEdges == Graph.GetNumEdges()
+        && UpOffsets.Num() == NumNodes + 1
+        && GraphChecksum == Graph.ComputeChecksum();
+}
+
+bool FRoadContractionHierarchy::FindPath(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FPathSearchScratch& ForwardScratch, FPathSearchScratch& BackwardScratch, FRoadGraphPath& OutPath) const
+{
+    OutPath.Reset();
+
+    if (StartNodeId < 0 || StartNodeId >= NumNodes || GoalNodeId < 0 || GoalNodeId >= NumNodes)
+    {
+        return false;
+    }
+
+    ForwardScratch.BeginSearch(NumNodes);
+    BackwardScratch.BeginSearch(NumNodes);
+    ForwardScratch.SetPath(StartNodeId, 0.0f, INDEX_NONE, 0.0f);
+    BackwardScratch.SetPath(GoalNodeId, 0.0f, INDEX_NONE, 0.0f);
+
+    float BestDistance = TNumericLimits<float>::Max();
+    int32 MeetingNodeId = INDEX_NONE;
+
+    // Both searches only go upward, the graph is undirected so the backward search uses the same arcs.
+    // Neither side can improve the best path once both queues are at or above its length.
+    while (true)
+    {
+        const float ForwardMin = ForwardScratch.GetMinPriority();
+        const float BackwardMin = BackwardScratch.GetMinPriority();
+        if (FMath::Min(ForwardMin, BackwardMin) >= BestDistance)
+        {
+            break;
+        }
+
+        const bool bForward = ForwardMin <= BackwardMin;
+        FPathSearchScratch& Scratch = bForward ? ForwardScratch : BackwardScratch;
+        const FPathSearchScratch& OtherScratch = bForward ? BackwardScratch : ForwardScratch;
+
+        const int32 CurrentId = Scratch.PopAndClose();
+        const float CurrentDistance = Scratch.GetGScore(CurrentId);
+
+        const float OtherDistance = OtherScratch.GetGScore(CurrentId);
+        if (OtherDistance != TNumericLimits<float>::Max() && CurrentDistance + OtherDistance < BestDistance)
+        {
+            BestDistance = CurrentDistance + OtherDistance;
+            MeetingNodeId = CurrentId;
+        }
+
+        const int32 EndIndex = UpOffsets[CurrentId + 1];
+        for (int32 UpIndex = UpOffsets[CurrentId]; UpIndex < EndIndex; UpIndex++)
+        {
+            const int32 NeighborId = UpTargets[UpIndex];
+            if (Scratch.IsClosed(NeighborId))
+            {
+                continue;
+            }
+
+            const float Distance = CurrentDistance + UpWeights[UpIndex];
+            if (Distance < Scratch.GetGScore(NeighborId))
+            {
+                Scratch.SetPath(NeighborId, Distance, UpArcs[UpIndex], Distance);
+            }
+        }
+    }
+
+    if (MeetingNodeId == INDEX_NONE)
+    {
+        return false;
+    }
+
+    // The forward half is found from the meeting node back to the start
+    TArray<int32, TInlineAllocator<64>> ForwardArcs;
+    for (int32 NodeId = MeetingNodeId; NodeId != StartNodeId; )
+    {
+        const int32 ArcId = ForwardScratch.GetParent(NodeId);
+        ForwardArcs.Add(ArcId);
+        NodeId = GetOtherArcNode(ArcId, NodeId);
+    }
+
+    int32 FromNodeId = StartNodeId;
+    for (int32 ArcIndex = ForwardArcs.Num() - 1; ArcIndex >= 0; ArcIndex--)
+    {
+        UnpackArc(Graph, ForwardArcs[ArcIndex], FromNodeId, OutPath.Edges);
+        FromNodeId = GetOtherArcNode(ForwardArcs[ArcIndex], FromNodeId);
+    }
+
+    // The backward half already runs from the meeting node down to the goal
+    for (int32 NodeId = MeetingNodeId; NodeId != GoalNodeId; )
+    {
+        const int32 ArcId = BackwardScratch.GetParent(NodeId);
+        UnpackArc(Graph, ArcId, NodeId, OutPath.Edges);
+        NodeId = GetOtherArcNode(ArcId, NodeId);
+    }
+
+    OutPath.Nodes.Reserve(OutPath.Edges.Num() + 1);
+    OutPath.Nodes.Add(StartNodeId);
+    for (const int32 EdgeId : OutPath.Edges)
+    {
+        OutPath.Nodes.Add(Graph.GetEdgeTarget(EdgeId));
+    }
+    OutPath.Length = BestDistance;
+
+    return true;
+}
+
+int32 FRoadContractionHierarchy::GetNumShortcuts() const
+{
+    return ArcEdges.Num() - Algo::CountIf(ArcEdges, [](int32 EdgeId) { return EdgeId != INDEX_NONE; });
+}
+
+SIZE_T FRoadContractionHierarchy::GetAllocatedSize() const
+{
+    return UpOffsets.GetAllocatedSize() + UpTargets.GetAllocatedSize() + UpWeights.GetAllocatedSize() + UpArcs.GetAllocatedSize()
+        + ArcNodesA.GetAllocatedSize() + ArcNodesB.GetAllocatedSize() + ArcEdges.GetAllocatedSize()
+        + ArcMiddles.GetAllocatedSize() + ArcChildrenA.GetAllocatedSize() + ArcChildrenB.GetAllocatedSize();
+}
+
+// ---------- Private Methods ---------
+void FRoadContractionHierarchy::UnpackArc(const FRoadGraph& Graph, int32 ArcId, int32 FromNodeId, TArray<int32>& OutEdges) const
+{
+    // Depth first over the shortcut tree, children are pushed in reverse so edges come out in travel order
+    TArray<TPair<int32, int32>, TInlineAllocator<32>> Stack;
+    Stack.Push({ ArcId, FromNodeId });
+
+    while (Stack.Num() > 0)
+    {
+        const TPair<int32, int32> Item = Stack.Pop(EAllowShrinking::No);
+        const int32 CurrentArc = Item.Key;
+        const int32 CurrentFrom = Item.Value;
+
+        const int32 EdgeId = ArcEdges[CurrentArc];
+        if (EdgeId != INDEX_NONE)
+        {
+            OutEdges.Add(ArcNodesA[CurrentArc] == CurrentFrom ? EdgeId : Graph.GetReverseEdge(EdgeId));
+            continue;
+        }
+
+        const int32 Middle = ArcMiddles[CurrentArc];
+        if (ArcNodesA[CurrentArc] == CurrentFrom)
+        {
+            Stack.Push({ ArcChildrenB[CurrentArc], Middle });
+            Stack.Push({ ArcChildrenA[CurrentArc], CurrentFrom });
+        }
+        else
+        {
+            Stack.Push({ ArcChildrenA[CurrentArc], Middle });
+            Stack.Push({ ArcChildrenB[CurrentArc], CurrentFrom });
+        }
+    }
+}
+
+int32 FRoadContractionHierarchy::GetOtherArcNode(int32 ArcId, int32 NodeId) const
+{
+    return ArcNodesA[ArcId] == NodeId ? ArcNodesB[ArcId] : ArcNodesA[ArcId];
+}
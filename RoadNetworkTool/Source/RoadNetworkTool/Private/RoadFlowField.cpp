@@ -0,0 +1,258 @@
+#include "RoadFlowField.h"
+
+// ---------- Constructor ---------
+namespace
+{
+    // Distances are float sums, a tree edge may miss the difference of its end distances by some rounding
+    bool IsNearlyAtMost(float A, float B)
+    {
+        return A <= B + FMath::Max(FMath::Abs(B) * 1e-4f, 0.01f);
+    }
+}
+
+FRoadFlowField::FRoadFlowField()
+    : NumNodes(0), GoalNodeId(INDEX_NONE), GoalLocation(FVector::ZeroVector)
+{
+}
+
+// ---------- Public Methods ---------
+void FRoadFlowField::Build(const FRoadGraph& Graph, int32 InGoalNodeId, FPathSearchScratch& Scratch)
+{
+    NumNodes = Graph.GetNumNodes();
+    GoalNodeId = InGoalNodeId;
+    NextNodes.Init(INDEX_NONE, NumNodes);
+    Distances.Init(Unreachable, NumNodes);
+
+    if (GoalNodeId < 0 || GoalNodeId >= NumNodes)
+    {
+        GoalNodeId = INDEX_NONE;
+        return;
+    }
+    GoalLocation = Graph.GetNodeLocation(GoalNodeId);
+
+    Scratch.BeginSearch(NumNodes);
+    Scratch.SetPath(GoalNodeId, 0.0f, INDEX_NONE, 0.0f);
+
+    while (Scratch.HasOpenNodes())
+    {
+        const int32 CurrentId = Scratch.PopAndClose();
+        const float CurrentDistance = Scratch.GetGScore(CurrentId);
+        Distances[CurrentId] = CurrentDistance;
+
+        // The search reached this node from its parent, stepping back to it leads towards the goal
+        const int32 ParentEdge = Scratch.GetParent(CurrentId);
+        if (ParentEdge != INDEX_NONE)
+        {
+            NextNodes[CurrentId] = Graph.GetEdgeSource(ParentEdge);
+        }
+
+        const int32 EndEdge = Graph.GetEndEdge(CurrentId);
+        for (int32 EdgeId = Graph.GetFirstEdge(CurrentId); EdgeId < EndEdge; EdgeId++)
+        {
+            const int32 NeighborId = Graph.GetEdgeTarget(EdgeId);
+            const float Distance = CurrentDistance + Graph.GetEdgeLength(EdgeId);
+            if (!Scratch.IsClosed(NeighborId) && Distance < Scratch.GetGScore(NeighborId))
+            {
+                Scratch.SetPath(NeighborId, Distance, EdgeId, Distance);
+            }
+        }
+    }
+}
+
+bool FRoadFlowField::IsAffectedBy(const FRoadGraph& Graph, const FRoadGraphEdit& Edit) const
+{
+    if (GoalNodeId == INDEX_NONE || !Graph.IsNodeActive(GoalNodeId) || !Graph.GetNodeLocation(GoalNodeId).Equals(GoalLocation, 0.0))
+    {
+        return true;
+    }
+
+    // Hops only name the neighbour, so a removed connection matters if it was the shortest one of a hop
+    for (const FRoadGraphEdit::FConnection& Connection : Edit.RemovedConnections)
+    {
+        const float DistanceA = GetDistanceToGoal(Connection.NodeA);
+        const float DistanceB = GetDistanceToGoal(Connection.NodeB);
+        if ((GetNextNode(Connection.NodeA) == Connection.NodeB && IsNearlyAtMost(Connection.Length, DistanceA - DistanceB))
+            || (GetNextNode(Connection.NodeB) == Connection.NodeA && IsNearlyAtMost(Connection.Length, DistanceB - DistanceA)))
+        {
+            return true;
+        }
+    }
+
+    // Nodes added after the build read back as unreachable, connecting them to the tree needs a new table
+    for (const FRoadGraphEdit::FConnection& Connection : Edit.AddedConnections)
+    {
+        const float DistanceA = GetDistanceToGoal(Connection.NodeA);
+        const float DistanceB = GetDistanceToGoal(Connection.NodeB);
+        if ((DistanceB != Unreachable && !IsNearlyAtMost(DistanceA, DistanceB + Connection.Length))
+            || (DistanceA != Unreachable && !IsNearlyAtMost(DistanceB, DistanceA + Connection.Length)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int32 FRoadFlowField::GetGoalNode() const
+{
+    return GoalNodeId;
+}
+
+bool FRoadFlowField::IsReachable(int32 NodeId) const
+{
+    return Distances.IsValidIndex(NodeId) && Distances[NodeId] != Unreachable;
+}
+
+float FRoadFlowField::GetDistanceToGoal(int32 NodeId) const
+{
+    return Distances.IsValidIndex(NodeId) ? Distances[NodeId] : Unreachable;
+}
+
+int32 FRoadFlowField::GetNextNode(int32 NodeId) const
+{
+    return NextNodes.IsValidIndex(NodeId) ? NextNodes[NodeId] : INDEX_NONE;
+}
+
+bool FRoadFlowField::ExtractPath(const FRoadGraph& Graph, int32 StartNodeId, FRoadGraphPath& OutPath) const
+{
+    OutPath.Reset();
+
+    if (!IsReachable(StartNodeId) || NumNodes > Graph.GetNumNodes())
+    {
+        return false;
+    }
+
+    OutPath.Nodes.Add(StartNodeId);
+    for (int32 CurrentId = StartNodeId; CurrentId != GoalNodeId;)
+    {
+        // Several splines may connect the two nodes, the tree runs over the shortest
+        const int32 NextId = NextNodes[CurrentId];
+        int32 BestEdge = INDEX_NONE;
+        for (int32 EdgeId = Graph.GetFirstEdge(CurrentId); EdgeId < Graph.GetEndEdge(CurrentId); EdgeId++)
+        {
+            if (Graph.GetEdgeTarget(EdgeId) == NextId && (BestEdge == INDEX_NONE || Graph.GetEdgeLength(EdgeId) < Graph.GetEdgeLength(BestEdge)))
+            {
+                BestEdge = EdgeId;
+            }
+        }
+
+        if (BestEdge == INDEX_NONE)
+        {
+            OutPath.Reset();
+            return false;
+        }
+
+        OutPath.Edges.Add(BestEdge);
+        OutPath.Nodes.Add(NextId);
+        CurrentId = NextId;
+    }
+
+    OutPath.Length = Distances[StartNodeId];
+    return true;
+}
+
+SIZE_T FRoadFlowField::GetAllocatedSize() const
+{
+    return NextNodes.GetAllocatedSize() + Distances.GetAllocatedSize();
+}
+
+// ---------- Cache ---------
+FRoadFlowFieldCache::FRoadFlowFieldCache(int32 InCapacity)
+    : Capacity(0), GraphRevision(0)
+{
+    SetCapacity(InCapacity);
+}
+
+void FRoadFlowFieldCache::SetCapacity(int32 InCapacity)
+{
+    InCapacity = FMath::Max(InCapacity, 0);
+    if (InCapacity != Capacity)
+    {
+        Capacity = InCapacity;
+        Entries.Empty(Capacity);
+    }
+}
+
+int32 FRoadFlowFieldCache::GetCapacity() const
+{
+    return Capacity;
+}
+
+int32 FRoadFlowFieldCache::Num() const
+{
+    return Capacity > 0 ? Entries.Num() : 0;
+}
+
+void FRoadFlowFieldCache::Empty()
+{
+    Entries.Empty(Capacity);
+}
+
+TSharedPtr<const FRoadFlowField> FRoadFlowFieldCache::FindOrBuild(const TSharedPtr<const FRoadGraph>& Graph, int32 GoalNodeId)
+{
+    if (!Graph.IsValid() || !Graph->IsNodeActive(GoalNodeId))
+    {
+        return nullptr;
+    }
+
+    // A revision no edit led to is another network, none of the entries fit it
+    if (Graph->GetRevision() != GraphRevision)
+    {
+        Entries.Empty(Capacity);
+        GraphRevision = Graph->GetRevision();
+    }
+
+    if (Capacity > 0)
+    {
+        if (const TSharedPtr<const FRoadFlowField>* CachedField = Entries.FindAndTouch(GoalNodeId))
+        {
+            return *CachedField;
+        }
+    }
+
+    TSharedPtr<FRoadFlowField> FlowField = MakeShared<FRoadFlowField>();
+    FlowField->Build(*Graph, GoalNodeId, Scratch);
+
+    if (Capacity > 0)
+    {
+        Entries.Add(GoalNodeId, FlowField);
+    }
+
+    return FlowField;
+}
+
+void FRoadFlowFieldCache::ApplyEdit(const FRoadGraph& Graph, uint32 PreviousRevision, const FRoadGraphEdit& Edit)
+{
+    if (GraphRevision != PreviousRevision)
+    {
+        Entries.Empty(Capacity);
+        GraphRevision = Graph.GetRevision();
+        return;
+    }
+
+    TArray<int32> AffectedGoals;
+    for (TLruCache<int32, TSharedPtr<const FRoadFlowField>>::TConstIterator It(Entries); It; ++It)
+    {
+        if (It.Value()->IsAffectedBy(Graph, Edit))
+        {
+            AffectedGoals.Add(It.Key());
+        }
+    }
+
+    // Agents holding a dropped field keep it, the next lookup builds a new one
+    for (const int32 GoalNodeId : AffectedGoals)
+    {
+        Entries.Remove(GoalNodeId);
+    }
+    GraphRevision = Graph.GetRevision();
+}
+
+SIZE_T FRoadFlowFieldCache::GetAllocatedSize() const
+{
+    SIZE_T AllocatedSize = 0;
+    for (TLruCache<int32, TSharedPtr<const FRoadFlowField>>::TConstIterator It(Entries); It; ++It)
+    {
+        AllocatedSize += It.Value()->GetAllocatedSize();
+    }
+    return AllocatedSize;
+}
@@ -0,0 +1,683 @@
+#include "RoadGraph.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+namespace
+{
+    // Spare edge slots per node after a full layout, enough for most edits at a junction
+    constexpr int32 EdgeSlackPerNode = 2;
+
+    // Smallest block a node moves its edges to once its block is full
+    constexpr int32 MinRelocatedEdgeCapacity = 4;
+
+    // Shared by all graphs, so revisions never repeat between graphs either
+    std::atomic<uint32> NextGraphRevision{ 1 };
+
+    struct FRoadGraphEdgeRecord
+    {
+        int32 Source;
+        int32 Target;
+        int32 SplineIndex;
+        float StartKey;
+        float EndKey;
+        float Length;
+    };
+}
+
+// ---------- Constructor ---------
+FRoadGraph::FRoadGraph()
+    : NodeHash(FRoadNetworkTopology::DefaultWeldTolerance), NumActiveEdges(0), NumAbandonedSlots(0), Revision(0)
+{
+    BumpRevision();
+}
+
+// ---------- Building ---------
+void FRoadGraph::Build(const FRoadNetworkTopology& Topology)
+{
+    Reset();
+    NodeHash = FRoadEndpointHash(Topology.GetWeldTolerance());
+
+    for (int32 NodeId = 0; NodeId < Topology.GetNumNodes(); NodeId++)
+    {
+        const FRoadTopologyNode& Node = Topology.GetNode(NodeId);
+        NodeX.Add(Node.Location.X);
+        NodeY.Add(Node.Location.Y);
+        NodeZ.Add(Node.Location.Z);
+        NodeSplineCounts.Add(Node.Degree);
+        NodeHash.Add(Node.Location, NodeId);
+    }
+
+    FBox2D NodeBounds(ForceInit);
+    for (int32 NodeId = 0; NodeId < NodeX.Num(); NodeId++)
+    {
+        NodeBounds += FVector2D(NodeX[NodeId], NodeY[NodeId]);
+    }
+
+    NodeIndex.Reset(FRoadNodeIndex::ChooseCellSize(NodeBounds, NodeX.Num()));
+    for (int32 NodeId = 0; NodeId < NodeX.Num(); NodeId++)
+    {
+        NodeIndex.Add(NodeId, GetNodeLocation(NodeId));
+    }
+
+    for (int32 SplineIndex = 0; SplineIndex < Topology.GetNumSplines(); SplineIndex++)
+    {
+        const FRoadTopologySpline& TopologySpline = Topology.GetSpline(SplineIndex);
+        Splines.Add(TopologySpline.SplineComponent);
+        SplineStartNodes.Add(TopologySpline.StartNode);
+        SplineEndNodes.Add(TopologySpline.EndNode);
+        SplineEndKeys.Add(TopologySpline.EndKey);
+        SplineLengths.Add(TopologySpline.Length);
+        SplineIndices.Add(TopologySpline.SplineComponent, SplineIndex);
+    }
+
+    // Sampling reads every spline, which is by far the largest part of the build
+    SplineLanes.SetNum(Splines.Num());
+    ParallelFor(Splines.Num(), [&](int32 SplineIndex)
+        {
+            BuildSplineLanes(SplineIndex);
+        });
+
+    BuildEdges();
+}
+
+void FRoadGraph::Build(const TArray<USplineComponent*>& SplineComponents)
+{
+    FRoadNetworkTopology Topology(NodeHash.GetTolerance());
+    Topology.Build(SplineComponents);
+    Build(Topology);
+}
+
+void FRoadGraph::Reset()
+{
+    NodeX.Reset();
+    NodeY.Reset();
+    NodeZ.Reset();
+    NodeSplineCounts.Reset();
+    FreeNodes.Reset();
+    NodeHash.Reset();
+    NodeIndex.Reset(NodeIndex.GetCellSize());
+    EdgeOffsets.Reset();
+    EdgeCounts.Reset();
+    EdgeCapacities.Reset();
+    NumActiveEdges = 0;
+    NumAbandonedSlots = 0;
+    EdgeSources.Reset();
+    EdgeTargets.Reset();
+    EdgeSplines.Reset();
+    EdgeStartKeys.Reset();
+    EdgeEndKeys.Reset();
+    EdgeLengths.Reset();
+    EdgeReverses.Reset();
+    Splines.Reset();
+    SplineStartNodes.Reset();
+    SplineEndNodes.Reset();
+    SplineEndKeys.Reset();
+    SplineLengths.Reset();
+    SplineLanes.Reset();
+    FreeSplineIndices.Reset();
+    SplineIndices.Reset();
+    BumpRevision();
+}
+
+// ---------- Incremental Edits ---------
+bool FRoadGraph::AddSpline(USplineComponent* SplineComponent, FRoadGraphEdit* OutEdit)
+{
+    if (!AddSplineRecord(SplineComponent))
+    {
+        return false;
+    }
+
+    AddSplineEdges(FindSplineIndex(SplineComponent), OutEdit);
+    CompactEdgesIfNeeded();
+    BumpRevision();
+    return true;
+}
+
+bool FRoadGraph::RemoveSpline(const USplineComponent* SplineComponent, FRoadGraphEdit* OutEdit)
+{
+    int32 SplineIndex = INDEX_NONE;
+    if (!SplineIndices.RemoveAndCopyValue(SplineComponent, SplineIndex))
+    {
+        return false;
+    }
+
+    RemoveSplineEdges(SplineIndex, OutEdit);
+    ReleaseNode(SplineStartNodes[SplineIndex]);
+    ReleaseNode(SplineEndNodes[SplineIndex]);
+
+    Splines[SplineIndex] = nullptr;
+    SplineStartNodes[SplineIndex] = INDEX_NONE;
+    SplineEndNodes[SplineIndex] = INDEX_NONE;
+    SplineLanes[SplineIndex].Reset();
+    FreeSplineIndices.Add(SplineIndex);
+
+    BumpRevision();
+    return true;
+}
+
+bool FRoadGraph::UpdateSpline(USplineComponent* SplineComponent, FRoadGraphEdit* OutEdit)
+{
+    const int32 SplineIndex = FindSplineIndex(SplineComponent);
+    if (SplineIndex == INDEX_NONE)
+    {
+        return false;
+    }
+
+    if (SplineComponent->GetNumberOfSplinePoints() < 1)
+    {
+        return RemoveSpline(SplineComponent, OutEdit);
+    }
+
+    // The new ends are acquired before the old ones are released, so an end that didn't move keeps its node
+    const int32 OldStartNode = SplineStartNodes[SplineIndex];
+    const int32 OldEndNode = SplineEndNodes[SplineIndex];
+    RemoveSplineEdges(SplineIndex, OutEdit);
+    ReadSplineEnds(SplineIndex);
+    ReleaseNode(OldStartNode);
+    ReleaseNode(OldEndNode);
+    AddSplineEdges(SplineIndex, OutEdit);
+
+    CompactEdgesIfNeeded();
+    BumpRevision();
+    return true;
+}
+
+uint32 FRoadGraph::GetRevision() const
+{
+    return Revision;
+}
+
+// ---------- Nodes ---------
+int32 FRoadGraph::GetNumNodes() const
+{
+    return NodeX.Num();
+}
+
+FVector FRoadGraph::GetNodeLocation(int32 NodeId) const
+{
+    return FVector(NodeX[NodeId], NodeY[NodeId], NodeZ[NodeId]);
+}
+
+bool FRoadGraph::IsNodeActive(int32 NodeId) const
+{
+    return NodeSplineCounts.IsValidIndex(NodeId) && NodeSplineCounts[NodeId] > 0;
+}
+
+int32 FRoadGraph::FindNearestNode(const FVector& Location, double MaxDistance) const
+{
+    return NodeIndex.FindNearest(Location, MaxDistance);
+}
+
+void FRoadGraph::FindNearestNodes(const FVector& Location, int32 K, double MaxDistance, TArray<int32>& OutNodeIds) const
+{
+    NodeIndex.FindNearest(Location, K, MaxDistance, OutNodeIds);
+}
+
+void FRoadGraph::FindNodesInRadius(const FVector& Location, double Radius, TArray<int32>& OutNodeIds) const
+{
+    NodeIndex.FindInRadius(Location, Radius, OutNodeIds);
+}
+
+void FRoadGraph::FindNearestNodesBatch(TConstArrayView<FVector> Locations, TArray<int32>& OutNodeIds) const
+{
+    OutNodeIds.SetNumUninitialized(Locations.Num());
+
+    // Single lookups take well under a microsecond, so the work is split into chunks big enough to pay for a task
+    constexpr int32 LocationsPerTask = 256;
+    const int32 NumTasks = FMath::DivideAndRoundUp(Locations.Num(), LocationsPerTask);
+    ParallelFor(NumTasks, [&](int32 TaskIndex)
+        {
+            const int32 First = TaskIndex * LocationsPerTask;
+            const int32 Last = FMath::Min(First + LocationsPerTask, Locations.Num());
+            for (int32 Index = First; Index < Last; Index++)
+            {
+                OutNodeIds[Index] = NodeIndex.FindNearest(Locations[Index]);
+            }
+        });
+}
+
+// ---------- Edges ---------
+int32 FRoadGraph::GetNumEdges() const
+{
+    return EdgeTargets.Num();
+}
+
+int32 FRoadGraph::GetNumActiveEdges() const
+{
+    return NumActiveEdges;
+}
+
+int32 FRoadGraph::GetFirstEdge(int32 NodeId) const
+{
+    return EdgeOffsets[NodeId];
+}
+
+int32 FRoadGraph::GetEndEdge(int32 NodeId) const
+{
+    return EdgeOffsets[NodeId] + EdgeCounts[NodeId];
+}
+
+int32 FRoadGraph::GetEdgeSource(int32 EdgeId) const
+{
+    return EdgeSources[EdgeId];
+}
+
+int32 FRoadGraph::GetEdgeTarget(int32 EdgeId) const
+{
+    return EdgeTargets[EdgeId];
+}
+
+int32 FRoadGraph::GetEdgeSpline(int32 EdgeId) const
+{
+    return EdgeSplines[EdgeId];
+}
+
+float FRoadGraph::GetEdgeStartKey(int32 EdgeId) const
+{
+    return EdgeStartKeys[EdgeId];
+}
+
+float FRoadGraph::GetEdgeEndKey(int32 EdgeId) const
+{
+    return EdgeEndKeys[EdgeId];
+}
+
+float FRoadGraph::GetEdgeLength(int32 EdgeId) const
+{
+    return EdgeLengths[EdgeId];
+}
+
+int32 FRoadGraph::GetReverseEdge(int32 EdgeId) const
+{
+    return EdgeReverses[EdgeId];
+}
+
+uint32 FRoadGraph::ComputeChecksum() const
+{
+    // Spare and abandoned slots hold stale data, only the edges of every node go in
+    uint32 Checksum = FCrc::MemCrc32(EdgeOffsets.GetData(), EdgeOffsets.Num() * sizeof(int32));
+    Checksum = FCrc::MemCrc32(EdgeCounts.GetData(), EdgeCounts.Num() * sizeof(int32), Checksum);
+    for (int32 NodeId = 0; NodeId < EdgeCounts.Num(); NodeId++)
+    {
+        Checksum = FCrc::MemCrc32(EdgeTargets.GetData() + EdgeOffsets[NodeId], EdgeCounts[NodeId] * sizeof(int32), Checksum);
+        Checksum = FCrc::MemCrc32(EdgeLengths.GetData() + EdgeOffsets[NodeId], EdgeCounts[NodeId] * sizeof(float), Checksum);
+    }
+    return Checksum;
+}
+
+// ---------- Splines ---------
+int32 FRoadGraph::GetNumSplines() const
+{
+    return Splines.Num();
+}
+
+USplineComponent* FRoadGraph::GetSplineComponent(int32 SplineIndex) const
+{
+    return Splines.IsValidIndex(SplineIndex) ? Splines[SplineIndex] : nullptr;
+}
+
+int32 FRoadGraph::FindSplineIndex(const USplineComponent* SplineComponent) const
+{
+    const int32* SplineIndex = SplineIndices.Find(SplineComponent);
+    return SplineIndex ? *SplineIndex : INDEX_NONE;
+}
+
+int32 FRoadGraph::GetSplineStartNode(int32 SplineIndex) const
+{
+    return SplineStartNodes[SplineIndex];
+}
+
+int32 FRoadGraph::GetSplineEndNode(int32 SplineIndex) const
+{
+    return SplineEndNodes[SplineIndex];
+}
+
+float FRoadGraph::GetSplineKeyAtNode(int32 SplineIndex, int32 NodeId) const
+{
+    return SplineStartNodes[SplineIndex] == NodeId ? 0.0f : SplineEndKeys[SplineIndex];
+}
+
+// ---------- Lanes ---------
+void FRoadGraph::SetLaneOffsets(TConstArrayView<float> InLaneOffsets)
+{
+    LaneOffsets.Reset(InLaneOffsets.Num());
+    LaneOffsets.Append(InLaneOffsets.GetData(), InLaneOffsets.Num());
+
+    ParallelFor(Splines.Num(), [&](int32 SplineIndex)
+        {
+            BuildSplineLanes(SplineIndex);
+        });
+}
+
+const TArray<float>& FRoadGraph::GetLaneOffsets() const
+{
+    return LaneOffsets;
+}
+
+const FRoadSplineLanes* FRoadGraph::GetSplineLanes(int32 SplineIndex) const
+{
+    return SplineLanes.IsValidIndex(SplineIndex) ? SplineLanes[SplineIndex].Get() : nullptr;
+}
+
+// ---------- Private Methods ---------
+bool FRoadGraph::AddSplineRecord(USplineComponent* SplineComponent)
+{
+    if (!SplineComponent || SplineComponent->GetNumberOfSplinePoints() < 1 || SplineIndices.Contains(SplineComponent))
+    {
+        return false;
+    }
+
+    int32 SplineIndex = INDEX_NONE;
+    if (FreeSplineIndices.Num() > 0)
+    {
+        SplineIndex = FreeSplineIndices.Pop(EAllowShrinking::No);
+        Splines[SplineIndex] = SplineComponent;
+    }
+    else
+    {
+        SplineIndex = Splines.Add(SplineComponent);
+        SplineStartNodes.Add(INDEX_NONE);
+        SplineEndNodes.Add(INDEX_NONE);
+        SplineEndKeys.Add(0.0f);
+        SplineLengths.Add(0.0f);
+        SplineLanes.AddDefaulted();
+    }
+
+    SplineIndices.Add(SplineComponent, SplineIndex);
+    ReadSplineEnds(SplineIndex);
+    return true;
+}
+
+void FRoadGraph::ReadSplineEnds(int32 SplineIndex)
+{
+    const USplineComponent* Spline = Splines[SplineIndex];
+    const int32 LastPoint = Spline->GetNumberOfSplinePoints() - 1;
+
+    SplineStartNodes[SplineIndex] = AcquireNode(Spline->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World));
+    SplineEndNodes[SplineIndex] = AcquireNode(Spline->GetLocationAtSplinePoint(LastPoint, ESplineCoordinateSpace::World));
+    SplineEndKeys[SplineIndex] = static_cast<float>(LastPoint);
+    SplineLengths[SplineIndex] = Spline->GetDistanceAlongSplineAtSplinePoint(LastPoint);
+    BuildSplineLanes(SplineIndex);
+}
+
+void FRoadGraph::BuildSplineLanes(int32 SplineIndex)
+{
+    // A new object rather than an edit in place, copies of the graph may still share the old one
+    if (const USplineComponent* Spline = Splines[SplineIndex])
+    {
+        TSharedPtr<FRoadSplineLanes> Lanes = MakeShared<FRoadSplineLanes>();
+        Lanes->Build(Spline, LaneOffsets);
+        SplineLanes[SplineIndex] = Lanes;
+    }
+    else
+    {
+        SplineLanes[SplineIndex].Reset();
+    }
+}
+
+int32 FRoadGraph::AcquireNode(const FVector& Location)
+{
+    int32 NodeId = NodeHash.Find(Location);
+    if (NodeId != INDEX_NONE)
+    {
+        NodeSplineCounts[NodeId]++;
+        return NodeId;
+    }
+
+    if (FreeNodes.Num() > 0)
+    {
+        NodeId = FreeNodes.Pop(EAllowShrinking::No);
+        NodeX[NodeId] = Location.X;
+        NodeY[NodeId] = Location.Y;
+        NodeZ[NodeId] = Location.Z;
+        NodeSplineCounts[NodeId] = 1;
+    }
+    else
+    {
+        NodeId = NodeX.Add(Location.X);
+        NodeY.Add(Location.Y);
+        NodeZ.Add(Location.Z);
+        NodeSplineCounts.Add(1);
+
+        // No room yet, the first edge moves the node to a block at the end
+        EdgeOffsets.Add(EdgeTargets.Num());
+        EdgeCounts.Add(0);
+        EdgeCapacities.Add(0);
+    }
+
+    NodeHash.Add(Location, NodeId);
+    NodeIndex.Add(NodeId, Location);
+    return NodeId;
+}
+
+void FRoadGraph::ReleaseNode(int32 NodeId)
+{
+    if (--NodeSplineCounts[NodeId] == 0)
+    {
+        NodeHash.Remove(GetNodeLocation(NodeId), NodeId);
+        NodeIndex.Remove(NodeId, GetNodeLocation(NodeId));
+        FreeNodes.Add(NodeId);
+    }
+}
+
+void FRoadGraph::BuildEdges()
+{
+    TArray<FRoadGraphEdgeRecord> Records;
+    Records.Reserve(Splines.Num() * 2);
+
+    for (int32 SplineIndex = 0; SplineIndex < Splines.Num(); SplineIndex++)
+    {
+        const int32 StartNode = SplineStartNodes[SplineIndex];
+        const int32 EndNode = SplineEndNodes[SplineIndex];
+
+        // Removed splines have no nodes, splines that start and end at the same node don't connect anything
+        if (Splines[SplineIndex] && StartNode != EndNode)
+        {
+            const float EndKey = SplineEndKeys[SplineIndex];
+            const float Length = SplineLengths[SplineIndex];
+            Records.Add({ StartNode, EndNode, SplineIndex, 0.0f, EndKey, Length });
+            Records.Add({ EndNode, StartNode, SplineIndex, EndKey, 0.0f, Length });
+        }
+    }
+
+    // Counting sort of the edges by source node, every block gets the spare slots behind its edges
+    const int32 NumNodes = NodeX.Num();
+    const int32 NumEdges = Records.Num();
+    EdgeCounts.Init(0, NumNodes);
+    for (const FRoadGraphEdgeRecord& Record : Records)
+    {
+        EdgeCounts[Record.Source]++;
+    }
+
+    EdgeOffsets.SetNumUninitialized(NumNodes);
+    EdgeCapacities.SetNumUninitialized(NumNodes);
+    int32 NumSlots = 0;
+    for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+    {
+        EdgeOffsets[NodeId] = NumSlots;
+        EdgeCapacities[NodeId] = EdgeCounts[NodeId] + EdgeSlackPerNode;
+        NumSlots += EdgeCapacities[NodeId];
+    }
+
+    EdgeSources.SetNumUninitialized(NumSlots);
+    EdgeTargets.SetNumUninitialized(NumSlots);
+    EdgeSplines.SetNumUninitialized(NumSlots);
+    EdgeStartKeys.SetNumUninitialized(NumSlots);
+    EdgeEndKeys.SetNumUninitialized(NumSlots);
+    EdgeLengths.SetNumUninitialized(NumSlots);
+    EdgeReverses.SetNumUninitialized(NumSlots);
+
+    TArray<int32> RecordEdges;
+    RecordEdges.SetNumUninitialized(NumEdges);
+
+    TArray<int32> NextEdge(EdgeOffsets);
+    for (int32 RecordIndex = 0; RecordIndex < NumEdges; RecordIndex++)
+    {
+        const FRoadGraphEdgeRecord& Record = Records[RecordIndex];
+        const int32 EdgeId = NextEdge[Record.Source]++;
+        RecordEdges[RecordIndex] = EdgeId;
+        EdgeSources[EdgeId] = Record.Source;
+        EdgeTargets[EdgeId] = Record.Target;
+        EdgeSplines[EdgeId] = Record.SplineIndex;
+        EdgeStartKeys[EdgeId] = Record.StartKey;
+        EdgeEndKeys[EdgeId] = Record.EndKey;
+        EdgeLengths[EdgeId] = Record.Length;
+    }
+
+    // Records were added in forward and reverse pairs
+    for (int32 RecordIndex = 0; RecordIndex < NumEdges; RecordIndex++)
+    {
+        EdgeReverses[RecordEdges[RecordIndex]] = RecordEdges[RecordIndex ^ 1];
+    }
+
+    NumActiveEdges = NumEdges;
+    NumAbandonedSlots = 0;
+}
+
+void FRoadGraph::AddSplineEdges(int32 SplineIndex, FRoadGraphEdit* OutEdit)
+{
+    const int32 StartNode = SplineStartNodes[SplineIndex];
+    const int32 EndNode = SplineEndNodes[SplineIndex];
+    if (OutEdit)
+    {
+        OutEdit->Nodes.Add(StartNode);
+        OutEdit->Nodes.Add(EndNode);
+    }
+
+    if (StartNode == EndNode)
+    {
+        return;
+    }
+
+    // The two ends are different nodes, so making room at the end node never moves the forward edge
+    const int32 ForwardEdge = AddEdgeSlot(StartNode);
+    const int32 BackwardEdge = AddEdgeSlot(EndNode);
+    const float EndKey = SplineEndKeys[SplineIndex];
+    const float Length = SplineLengths[SplineIndex];
+
+    EdgeSources[ForwardEdge] = StartNode;
+    EdgeTargets[ForwardEdge] = EndNode;
+    EdgeSplines[ForwardEdge] = SplineIndex;
+    EdgeStartKeys[ForwardEdge] = 0.0f;
+    EdgeEndKeys[ForwardEdge] = EndKey;
+    EdgeLengths[ForwardEdge] = Length;
+    EdgeReverses[ForwardEdge] = BackwardEdge;
+
+    EdgeSources[BackwardEdge] = EndNode;
+    EdgeTargets[BackwardEdge] = StartNode;
+    EdgeSplines[BackwardEdge] = SplineIndex;
+    EdgeStartKeys[BackwardEdge] = EndKey;
+    EdgeEndKeys[BackwardEdge] = 0.0f;
+    EdgeLengths[BackwardEdge] = Length;
+    EdgeReverses[BackwardEdge] = ForwardEdge;
+
+    NumActiveEdges += 2;
+    if (OutEdit)
+    {
+        OutEdit->AddedConnections.Add({ StartNode, EndNode, Length });
+    }
+}
+
+void FRoadGraph::RemoveSplineEdges(int32 SplineIndex, FRoadGraphEdit* OutEdit)
+{
+    const int32 StartNode = SplineStartNodes[SplineIndex];
+    const int32 EndNode = SplineEndNodes[SplineIndex];
+    if (OutEdit)
+    {
+        OutEdit->Nodes.Add(StartNode);
+        OutEdit->Nodes.Add(EndNode);
+    }
+
+    if (StartNode == EndNode)
+    {
+        return;
+    }
+
+    for (int32 EdgeId = GetFirstEdge(StartNode); EdgeId < GetEndEdge(StartNode); EdgeId++)
+    {
+        if (EdgeSplines[EdgeId] == SplineIndex)
+        {
+            // Removing the forward edge only moves edges of the start node, the reverse edge keeps its slot
+            const int32 ReverseEdge = EdgeReverses[EdgeId];
+            RemoveEdgeSlot(EdgeId);
+            RemoveEdgeSlot(ReverseEdge);
+            NumActiveEdges -= 2;
+
+            if (OutEdit)
+            {
+                OutEdit->RemovedConnections.Add({ StartNode, EndNode, SplineLengths[SplineIndex] });
+            }
+            return;
+        }
+    }
+}
+
+int32 FRoadGraph::AddEdgeSlot(int32 NodeId)
+{
+    if (EdgeCounts[NodeId] == EdgeCapacities[NodeId])
+    {
+        RelocateEdges(NodeId, FMath::Max(EdgeCapacities[NodeId] * 2, MinRelocatedEdgeCapacity));
+    }
+
+    return EdgeOffsets[NodeId] + EdgeCounts[NodeId]++;
+}
+
+void FRoadGraph::RemoveEdgeSlot(int32 EdgeId)
+{
+    // The last edge of the node fills the gap, edges of a node are unordered
+    const int32 NodeId = EdgeSources[EdgeId];
+    const int32 LastEdge = GetEndEdge(NodeId) - 1;
+    if (EdgeId != LastEdge)
+    {
+        MoveEdge(LastEdge, EdgeId);
+    }
+    EdgeCounts[NodeId]--;
+}
+
+void FRoadGraph::MoveEdge(int32 FromEdgeId, int32 ToEdgeId)
+{
+    EdgeSources[ToEdgeId] = EdgeSources[FromEdgeId];
+    EdgeTargets[ToEdgeId] = EdgeTargets[FromEdgeId];
+    EdgeSplines[ToEdgeId] = EdgeSplines[FromEdgeId];
+    EdgeStartKeys[ToEdgeId] = EdgeStartKeys[FromEdgeId];
+    EdgeEndKeys[ToEdgeId] = EdgeEndKeys[FromEdgeId];
+    EdgeLengths[ToEdgeId] = EdgeLengths[FromEdgeId];
+    EdgeReverses[ToEdgeId] = EdgeReverses[FromEdgeId];
+    EdgeReverses[EdgeReverses[ToEdgeId]] = ToEdgeId;
+}
+
+void FRoadGraph::RelocateEdges(int32 NodeId, int32 NewCapacity)
+{
+    const int32 OldOffset = EdgeOffsets[NodeId];
+    const int32 NewOffset = EdgeTargets.Num();
+    EdgeSources.AddUninitialized(NewCapacity);
+    EdgeTargets.AddUninitialized(NewCapacity);
+    EdgeSplines.AddUninitialized(NewCapacity);
+    EdgeStartKeys.AddUninitialized(NewCapacity);
+    EdgeEndKeys.AddUninitialized(NewCapacity);
+    EdgeLengths.AddUninitialized(NewCapacity);
+    EdgeReverses.AddUninitialized(NewCapacity);
+
+    for (int32 Index = 0; Index < EdgeCounts[NodeId]; Index++)
+    {
+        MoveEdge(OldOffset + Index, NewOffset + Index);
+    }
+
+    NumAbandonedSlots += EdgeCapacities[NodeId];
+    EdgeOffsets[NodeId] = NewOffset;
+    EdgeCapacities[NodeId] = NewCapacity;
+}
+
+void FRoadGraph::CompactEdgesIfNeeded()
+{
+    // Amortised over the edits that abandoned the blocks, a full layout costs about as much as they saved
+    if (NumAbandonedSlots > FMath::Max(NumActiveEdges, 1024))
+    {
+        BuildEdges();
+    }
+}
+
+void FRoadGraph::BumpRevision()
+{
+    Revision = NextGraphRevision.fetch_add(1);
+}
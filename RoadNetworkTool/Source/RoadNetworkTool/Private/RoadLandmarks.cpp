@@ -0,0 +1,178 @@
+#include "RoadLandmarks.h"
+#include "RoadPathSearch.h"
+#include "Async/ParallelFor.h"
+
+// ---------- Constructor ---------
+FRoadLandmarks::FRoadLandmarks()
+    : NumNodes(0), GraphRevision(0), NumLandmarks(0)
+{
+}
+
+// ---------- Public Methods ---------
+int32 FRoadLandmarks::GetMaxLandmarksForMemory(int32 NumNodes, float MaxMemoryMB)
+{
+    if (NumNodes <= 0)
+    {
+        return 0;
+    }
+
+    const double BytesPerLandmark = static_cast<double>(NumNodes) * sizeof(float);
+    return static_cast<int32>(FMath::Min(MaxMemoryMB * 1024.0 * 1024.0 / BytesPerLandmark, static_cast<double>(MAX_int32)));
+}
+
+void FRoadLandmarks::Build(const FRoadGraph& Graph, int32 InNumLandmarks)
+{
+    NumNodes = Graph.GetNumNodes();
+    GraphRevision = Graph.GetRevision();
+    NumLandmarks = 0;
+    LandmarkNodes.Reset();
+    Distances.Reset();
+
+    const int32 Count = FMath::Min(InNumLandmarks, NumNodes);
+    if (Count <= 0)
+    {
+        return;
+    }
+
+    SelectLandmarks(Graph, Count);
+    NumLandmarks = LandmarkNodes.Num();
+    Distances.SetNumUninitialized(NumNodes * NumLandmarks);
+
+    // One full Dijkstra search per landmark, edges exist in both directions so one table serves both ways
+    ParallelFor(NumLandmarks, [&](int32 LandmarkIndex)
+        {
+            FPathSearchScratch Scratch;
+            Scratch.BeginSearch(NumNodes);
+            Scratch.SetPath(LandmarkNodes[LandmarkIndex], 0.0f, INDEX_NONE, 0.0f);
+
+            while (Scratch.HasOpenNodes())
+            {
+                const int32 CurrentId = Scratch.PopAndClose();
+                const float CurrentDistance = Scratch.GetGScore(CurrentId);
+                const int32 EndEdge = Graph.GetEndEdge(CurrentId);
+
+                for (int32 EdgeId = Graph.GetFirstEdge(CurrentId); EdgeId < EndEdge; EdgeId++)
+                {
+                    const int32 NeighborId = Graph.GetEdgeTarget(EdgeId);
+                    const float Distance = CurrentDistance + Graph.GetEdgeLength(EdgeId);
+                    if (!Scratch.IsClosed(NeighborId) && Distance < Scratch.GetGScore(NeighborId))
+                    {
+                        Scratch.SetPath(NeighborId, Distance, EdgeId, Distance);
+                    }
+                }
+            }
+
+            // Unreached nodes read back as the largest float, which is Unreachable
+            for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+            {
+                Distances[NodeId * NumLandmarks + LandmarkIndex] = Scratch.GetGScore(NodeId);
+            }
+        });
+}
+
+bool FRoadLandmarks::IsBuiltFor(const FRoadGraph& Graph) const
+{
+    return NumLandmarks > 0 && GraphRevision == Graph.GetRevision();
+}
+
+int32 FRoadLandmarks::GetNumLandmarks() const
+{
+    return NumLandmarks;
+}
+
+const TArray<int32>& FRoadLandmarks::GetLandmarkNodes() const
+{
+    return LandmarkNodes;
+}
+
+SIZE_T FRoadLandmarks::GetAllocatedSize() const
+{
+    return Distances.GetAllocatedSize() + LandmarkNodes.GetAllocatedSize();
+}
+
+const float* FRoadLandmarks::GetNodeDistances(int32 NodeId) const
+{
+    return Distances.GetData() + NodeId * NumLandmarks;
+}
+
+float FRoadLandmarks::GetLowerBound(int32 NodeId, const float* GoalDistances) const
+{
+    const float* NodeDistances = GetNodeDistances(NodeId);
+
+    float Bound = 0.0f;
+    for (int32 LandmarkIndex = 0; LandmarkIndex < NumLandmarks; LandmarkIndex++)
+    {
+        const float NodeDistance = NodeDistances[LandmarkIndex];
+        const float GoalDistance = GoalDistances[LandmarkIndex];
+        if (NodeDistance != Unreachable && GoalDistance != Unreachable)
+        {
+            Bound = FMath::Max(Bound, FMath::Abs(GoalDistance - NodeDistance));
+        }
+    }
+
+    return Bound;
+}
+
+// ---------- Private Methods ---------
+void FRoadLandmarks::SelectLandmarks(const FRoadGraph& Graph, int32 Count)
+{
+    // Farthest point selection on the node positions, landmarks on the rim of the network give the tightest bounds
+    // Nodes freed by graph edits are skipped, nothing reaches them
+    FVector Centroid = FVector::ZeroVector;
+    int32 NumActiveNodes = 0;
+    for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+    {
+        if (Graph.IsNodeActive(NodeId))
+        {
+            Centroid += Graph.GetNodeLocation(NodeId);
+            NumActiveNodes++;
+        }
+    }
+
+    if (NumActiveNodes == 0)
+    {
+        return;
+    }
+    Centroid /= NumActiveNodes;
+
+    TArray<double> NearestLandmarkDistances;
+    NearestLandmarkDistances.Init(TNumericLimits<double>::Max(), NumNodes);
+
+    FVector Reference = Centroid;
+    for (int32 LandmarkIndex = 0; LandmarkIndex < Count; LandmarkIndex++)
+    {
+        int32 FarthestNode = INDEX_NONE;
+        double FarthestDistance = -1.0;
+
+        for (int32 NodeId = 0; NodeId < NumNodes; NodeId++)
+        {
+            if (!Graph.IsNodeActive(NodeId))
+            {
+                continue;
+            }
+
+            double& NearestDistance = NearestLandmarkDistances[NodeId];
+            NearestDistance = FMath::Min(NearestDistance, FVector::DistSquared(Graph.GetNodeLocation(NodeId), Reference));
+
+            if (NearestDistance > FarthestDistance)
+            {
+                FarthestDistance = NearestDistance;
+                FarthestNode = NodeId;
+            }
+        }
+
+        // The first pass measured from the centroid, it must not count as a landmark
+        if (LandmarkIndex == 0)
+        {
+            NearestLandmarkDistances.Init(TNumericLimits<double>::Max(), NumNodes);
+        }
+
+        if (FarthestNode == INDEX_NONE || FarthestDistance <= 0.0)
+        {
+            break;
+        }
+
+        LandmarkNodes.Add(FarthestNode);
+        Reference = Graph.GetNodeLocation(FarthestNode);
+    }
+}
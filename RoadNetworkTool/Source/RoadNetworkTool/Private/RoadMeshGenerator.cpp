@@ -12,97 +12,39 @@ FRoadMeshGenerator::FRoadMeshGenerator()
 }
 
 // Intersection and NonIntersection Detection
-TArray<FIntersectionNode> FRoadMeshGenerator::FindSplineIntersectionNodes(const TArray<USplineComponent*>& SplineComponents) const
+TArray<FIntersectionNode> FRoadMeshGenerator::FindSplineIntersectionNodes(const FRoadNetworkTopology& Topology) const
 {
 	TArray<FIntersectionNode> IntersectionNodes;
-	const float IntersectionThreshold = 10.0f;
 
-	for (int32 i = 0; i < SplineComponents.Num(); i++)
+	// Every node where different splines meet becomes an intersection
+	for (int32 NodeId = 0; NodeId < Topology.GetNumNodes(); NodeId++)
 	{
-		USplineComponent* SplineA = SplineComponents[i];
-		if (!SplineA) continue;
-
-		// Get the start and end points of SplineA
-		FVector StartA = SplineA->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World);
-		FVector EndA = SplineA->GetLocationAtSplinePoint(SplineA->GetNumberOfSplinePoints() - 1, ESplineCoordinateSpace::World);
-
-		for (int32 j = 0; j < SplineComponents.Num(); j++)
+		const FRoadTopologyNode& Node = Topology.GetNode(NodeId);
+		if (Node.IsJunction())
 		{
-			USplineComponent* SplineB = SplineComponents[j];
-			if (j == i || !SplineB) continue;
-
-			// Get the start and end points of SplineB
-			FVector StartB = SplineB->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World);
-			FVector EndB = SplineB->GetLocationAtSplinePoint(SplineB->GetNumberOfSplinePoints() - 1, ESplineCoordinateSpace::World);
-
-			// Check for intersection at the start or end points
-			if (FVector::DistSquared(StartA, StartB) <= FMath::Square(IntersectionThreshold) ||
-				FVector::DistSquared(StartA, EndB) <= FMath::Square(IntersectionThreshold) ||
-				FVector::DistSquared(EndA, StartB) <= FMath::Square(IntersectionThreshold) ||
-				FVector::DistSquared(EndA, EndB) <= FMath::Square(IntersectionThreshold))
-			{
-				FVector IntersectionPoint = (FVector::DistSquared(StartA, StartB) <= FMath::Square(IntersectionThreshold)) ? StartA :
-					(FVector::DistSquared(StartA, EndB) <= FMath::Square(IntersectionThreshold)) ? StartA :
-					(FVector::DistSquared(EndA, StartB) <= FMath::Square(IntersectionThreshold)) ? EndA : EndA;
-
-				bool bIsNearExistingNode = false;
-				for (FIntersectionNode& Node : IntersectionNodes)
-				{
-					if (FVector::DistSquared(IntersectionPoint, Node.IntersectionPoint) <= FMath::Square(IntersectionThreshold))
-					{
-						Node.IntersectingSplines.AddUnique(SplineA);
-						Node.IntersectingSplines.AddUnique(SplineB);
-						bIsNearExistingNode = true;
-						break;
-					}
-				}
-
-				if (!bIsNearExistingNode)
-				{
-					FIntersectionNode NewNode(IntersectionPoint);
-					NewNode.IntersectingSplines.AddUnique(SplineA);
-					NewNode.IntersectingSplines.AddUnique(SplineB);
-					IntersectionNodes.Add(NewNode);
-				}
-			}
+			FIntersectionNode& IntersectionNode = IntersectionNodes.Emplace_GetRef(Node.Location);
+			IntersectionNode.IntersectingSplines.Append(Node.Splines);
 		}
 	}
 
 	return IntersectionNodes;
 }
 
-TArray<FNonIntersectionNode> FRoadMeshGenerator::FindSplineNonIntersectionNodes(const TArray<USplineComponent*>& SplineComponents) const
+TArray<FNonIntersectionNode> FRoadMeshGenerator::FindSplineNonIntersectionNodes(const FRoadNetworkTopology& Topology) const
 {
 	TArray<FNonIntersectionNode> NonIntersectionNodes;
-	const float IntersectionThreshold = 1.0f;
-	TArray<FIntersectionNode> IntersectionNodes = FindSplineIntersectionNodes(SplineComponents);
 
-	for (USplineComponent* Spline : SplineComponents)
+	// Consider only the start and end of every spline, those that aren't at a junction get a road end
+	for (int32 SplineIndex = 0; SplineIndex < Topology.GetNumSplines(); SplineIndex++)
 	{
-		if (!Spline) continue;
-		const int32 NumPoints = Spline->GetNumberOfSplinePoints();
-
-		// Consider only the start (Index 0) and end (Index NumPoints - 1) points
-		for (int32 PointIndex : {0, NumPoints - 1})
+		const FRoadTopologySpline& Spline = Topology.GetSpline(SplineIndex);
+		for (int32 NodeId : { Spline.StartNode, Spline.EndNode })
 		{
-			if (PointIndex >= NumPoints) continue; // Ensure the point index is within range
-			FVector SplinePoint = Spline->GetLocationAtSplinePoint(PointIndex, ESplineCoordinateSpace::World);
-
-			bool bIsIntersecting = false;
-			for (const FIntersectionNode& Node : IntersectionNodes)
-			{
-				if (FVector::DistSquared(SplinePoint, Node.IntersectionPoint) <= FMath::Square(IntersectionThreshold))
-				{
-					bIsIntersecting = true;
-					break;
-				}
-			}
-
-			if (!bIsIntersecting)
+			const FRoadTopologyNode& Node = Topology.GetNode(NodeId);
+			if (!Node.IsJunction())
 			{
-				FNonIntersectionNode NewNode(SplinePoint);
-				NewNode.NonIntersectingSplines.Add(Spline);
-				NonIntersectionNodes.Add(NewNode);
+				FNonIntersectionNode& NonIntersectionNode = NonIntersectionNodes.Emplace_GetRef(Node.Location);
+				NonIntersectionNode.NonIntersectingSplines.Add(Spline.SplineComponent);
 			}
 		}
 	}
@@ -116,9 +58,10 @@ void FRoadMeshGenerator::GenerateRoadMesh(ARoadActor* RoadActor)
 	RoadActor->RoadWidth = RoadActor->DebugWidth;
 	RoadActor->DestroyProceduralMeshes();
 
-	// Find intersection and non-intersection nodes
-	TArray<FIntersectionNode> IntersectionNodes = this->FindSplineIntersectionNodes(RoadActor->SplineComponents);
-	TArray<FNonIntersectionNode> NonIntersectionNodes = this->FindSplineNonIntersectionNodes(RoadActor->SplineComponents);
+	// Find intersection and non-intersection nodes, the topology is shared with the road graph
+	const FRoadNetworkTopology& Topology = RoadActor->GetRoadTopology();
+	TArray<FIntersectionNode> IntersectionNodes = this->FindSplineIntersectionNodes(Topology);
+	TArray<FNonIntersectionNode> NonIntersectionNodes = this->FindSplineNonIntersectionNodes(Topology);
 
 	// Map each SplineComponent to its corresponding SplineData
 	TMap<USplineComponent*, FSplineData> SplineDataMap;
@@ -624,4 +567,4 @@ void FRoadMeshGenerator::SetRoadMeshMaterialAndCollision(UProceduralMeshComponen
 	// Set Collision
 	ProcMeshComponent->SetCollisionProfileName(TEXT("Custom"));
 	ProcMeshComponent->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,932 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Components/SplineComponent.h"
+#include "UObject/Package.h"
+#include "Quadtree.h"
+#include "SplineHashGrid.h"
+#include "SplineSegmentBVH.h"
+#include "SplineNearestRaster.h"
+#include "RoadGraph.h"
+#include "RoadPathfindingComponent.h"
+#include "FSplinePointUtilities.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace RoadNetworkBenchmarks
+{
+    // Pointer based quadtree as it was before the flat node pool, kept here only as a baseline
+    struct FLegacyQuadtreeNode
+    {
+        FBox2D Bounds;
+        TArray<USplineComponent*> SplineComponents;
+        TSharedPtr<FLegacyQuadtreeNode> Children[4];
+
+        FLegacyQuadtreeNode(const FBox2D& InBounds) : Bounds(InBounds) {}
+
+        bool IsLeafNode() const
+        {
+            return Children[0] == nullptr;
+        }
+    };
+
+    class FLegacyQuadtree
+    {
+    public:
+        FLegacyQuadtree(const FBox2D& WorldBounds, int32 InMaxSplinesPerNode, int32 InMaxDepth)
+            : RootNode(MakeShared<FLegacyQuadtreeNode>(WorldBounds)), MaxSplinesPerNode(InMaxSplinesPerNode), MaxDepth(InMaxDepth) {}
+
+        void InsertSplineComponent(USplineComponent* SplineComponent)
+        {
+            InsertSplineIntoNode(RootNode, SplineComponent, 0);
+        }
+
+        void QuerySplinesInArea(const FBox2D& Area, TArray<USplineComponent*>& OutSplines) const
+        {
+            QueryNodeSplinesInArea(RootNode, Area, OutSplines);
+        }
+
+    private:
+        TSharedPtr<FLegacyQuadtreeNode> RootNode;
+        int32 MaxSplinesPerNode;
+        int32 MaxDepth;
+
+        void InsertSplineIntoNode(TSharedPtr<FLegacyQuadtreeNode> Node, USplineComponent* SplineComponent, int32 CurrentDepth)
+        {
+            FBox2D SplineBounds = FQuadtree::CalcSplineBounds2D(SplineComponent);
+
+            if (Node->IsLeafNode())
+            {
+                if (Node->SplineComponents.Num() < MaxSplinesPerNode || CurrentDepth >= MaxDepth)
+                {
+                    Node->SplineComponents.Add(SplineComponent);
+                    return;
+                }
+
+                FVector2D Min = Node->Bounds.Min;
+                FVector2D Max = Node->Bounds.Max;
+                FVector2D Center = (Min + Max) / 2;
+                Node->Children[0] = MakeShared<FLegacyQuadtreeNode>(FBox2D(Center, Max));
+                Node->Children[1] = MakeShared<FLegacyQuadtreeNode>(FBox2D(FVector2D(Min.X, Center.Y), FVector2D(Center.X, Max.Y)));
+                Node->Children[2] = MakeShared<FLegacyQuadtreeNode>(FBox2D(Min, Center));
+                Node->Children[3] = MakeShared<FLegacyQuadtreeNode>(FBox2D(FVector2D(Center.X, Min.Y), FVector2D(Max.X, Center.Y)));
+
+                for (USplineComponent* Existing : Node->SplineComponents)
+                {
+                    InsertSplineIntoNode(Node, Existing, CurrentDepth + 1);
+                }
+                Node->SplineComponents.Empty();
+            }
+
+            for (int32 i = 0; i < 4; i++)
+            {
+                if (Node->Children[i]->Bounds.Intersect(SplineBounds))
+                {
+                    InsertSplineIntoNode(Node->Children[i], SplineComponent, CurrentDepth + 1);
+                }
+            }
+        }
+
+        void QueryNodeSplinesInArea(TSharedPtr<FLegacyQuadtreeNode> Node, const FBox2D& Area, TArray<USplineComponent*>& OutSplines) const
+        {
+            if (!Node->Bounds.Intersect(Area))
+            {
+                return;
+            }
+
+            if (Node->IsLeafNode())
+            {
+                for (USplineComponent* SplineComponent : Node->SplineComponents)
+                {
+                    if (Area.Intersect(FQuadtree::CalcSplineBounds2D(SplineComponent)))
+                    {
+                        OutSplines.Add(SplineComponent);
+                    }
+                }
+            }
+            else
+            {
+                for (int32 i = 0; i < 4; i++)
+                {
+                    QueryNodeSplinesInArea(Node->Children[i], Area, OutSplines);
+                }
+            }
+        }
+    };
+
+    // Scatters short two or three point road splines over a square world
+    static TArray<USplineComponent*> CreateSyntheticSplines(int32 NumSplines, double WorldSize, FRandomStream& Random)
+    {
+        TArray<USplineComponent*> Splines;
+        Splines.Reserve(NumSplines);
+
+        for (int32 i = 0; i < NumSplines; i++)
+        {
+            USplineComponent* Spline = NewObject<USplineComponent>(GetTransientPackage());
+            Spline->ClearSplinePoints(false);
+
+            FVector Start(Random.FRand() * WorldSize, Random.FRand() * WorldSize, 0.0);
+            FVector Direction = FVector(Random.FRand() * 2.0 - 1.0, Random.FRand() * 2.0 - 1.0, 0.0).GetSafeNormal();
+            double Length = 1000.0 + Random.FRand() * 5000.0;
+            int32 NumPoints = Random.RandRange(2, 3);
+
+            for (int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+            {
+                FVector Offset = Direction * Length * PointIndex / (NumPoints - 1);
+                Spline->AddSplinePoint(Start + Offset, ESplineCoordinateSpace::World, false);
+            }
+            Spline->UpdateSpline();
+            Splines.Add(Spline);
+        }
+
+        return Splines;
+    }
+
+    // Jittered grid of junctions connected by curved three point splines, with a share of the streets left out
+    static TArray<USplineComponent*> CreateSyntheticRoadGrid(int32 GridSize, double Spacing, float MissingStreetFraction, FRandomStream& Random)
+    {
+        TArray<FVector> Junctions;
+        Junctions.Reserve(GridSize * GridSize);
+        for (int32 Y = 0; Y < GridSize; Y++)
+        {
+            for (int32 X = 0; X < GridSize; X++)
+            {
+                const FVector Jitter(Random.FRandRange(-0.25f, 0.25f) * Spacing, Random.FRandRange(-0.25f, 0.25f) * Spacing, 0.0);
+                Junctions.Add(FVector(X * Spacing, Y * Spacing, 0.0) + Jitter);
+            }
+        }
+
+        TArray<USplineComponent*> Splines;
+        auto AddStreet = [&Splines, &Random, Spacing](const FVector& Start, const FVector& End)
+            {
+                const FVector Side = FVector::CrossProduct(End - Start, FVector::UpVector).GetSafeNormal();
+                const FVector Middle = (Start + End) * 0.5 + Side * Random.FRandRange(-0.2f, 0.2f) * Spacing;
+
+                USplineComponent* Spline = NewObject<USplineComponent>(GetTransientPackage());
+                Spline->ClearSplinePoints(false);
+                Spline->AddSplinePoint(Start, ESplineCoordinateSpace::World, false);
+                Spline->AddSplinePoint(Middle, ESplineCoordinateSpace::World, false);
+                Spline->AddSplinePoint(End, ESplineCoordinateSpace::World, false);
+                Spline->UpdateSpline();
+                Splines.Add(Spline);
+            };
+
+        for (int32 Y = 0; Y < GridSize; Y++)
+        {
+            for (int32 X = 0; X < GridSize; X++)
+            {
+                const FVector& Junction = Junctions[Y * GridSize + X];
+                if (X + 1 < GridSize && Random.FRand() >= MissingStreetFraction)
+                {
+                    AddStreet(Junction, Junctions[Y * GridSize + X + 1]);
+                }
+                if (Y + 1 < GridSize && Random.FRand() >= MissingStreetFraction)
+                {
+                    AddStreet(Junction, Junctions[(Y + 1) * GridSize + X]);
+                }
+            }
+        }
+
+        return Splines;
+    }
+
+    static TArray<FBox2D> CreateQueryAreas(int32 NumQueries, double WorldSize, double SearchRadius, FRandomStream& Random)
+    {
+        TArray<FBox2D> Areas;
+        Areas.Reserve(NumQueries);
+
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            FVector2D Center(Random.FRand() * WorldSize, Random.FRand() * WorldSize);
+            Areas.Add(FBox2D(Center - FVector2D(SearchRadius), Center + FVector2D(SearchRadius)));
+        }
+
+        return Areas;
+    }
+
+    template <typename TreeType>
+    static double TimeQueries(const TreeType& Tree, const TArray<FBox2D>& Areas, int64& OutTotalHits)
+    {
+        TArray<USplineComponent*> Results;
+        OutTotalHits = 0;
+
+        double StartTime = FPlatformTime::Seconds();
+        for (const FBox2D& Area : Areas)
+        {
+            Results.Reset();
+            Tree.QuerySplinesInArea(Area, Results);
+            OutTotalHits += Results.Num();
+        }
+        return FPlatformTime::Seconds() - StartTime;
+    }
+
+    // RoadNetwork.Benchmark.Quadtree [NumSplines] [NumQueries] [MaxSplinesPerNode] [MaxDepth]
+    static void BenchmarkQuadtree(const TArray<FString>& Args)
+    {
+        const int32 NumSplines = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 4000;
+        const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 20000;
+        const int32 MaxSplinesPerNode = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 5;
+        const int32 MaxDepth = Args.Num() > 3 ? FCString::Atoi(*Args[3]) : 8;
+        const double SearchRadius = 2500.0;
+        const double WorldSize = FMath::Sqrt(static_cast<double>(NumSplines)) * 3000.0;
+
+        FRandomStream Random(1337);
+        TArray<USplineComponent*> Splines = CreateSyntheticSplines(NumSplines, WorldSize, Random);
+        TArray<FBox2D> Areas = CreateQueryAreas(NumQueries, WorldSize, SearchRadius, Random);
+        const FBox2D WorldBounds(FVector2D(-WorldSize * 0.1), FVector2D(WorldSize * 1.1));
+
+        double StartTime = FPlatformTime::Seconds();
+        FLegacyQuadtree LegacyTree(WorldBounds, MaxSplinesPerNode, MaxDepth);
+        for (USplineComponent* Spline : Splines)
+        {
+            LegacyTree.InsertSplineComponent(Spline);
+        }
+        const double LegacyBuildTime = FPlatformTime::Seconds() - StartTime;
+
+        StartTime = FPlatformTime::Seconds();
+        FQuadtree FlatTree(WorldBounds, MaxSplinesPerNode, MaxDepth);
+        for (USplineComponent* Spline : Splines)
+        {
+            FlatTree.InsertSplineComponent(Spline);
+        }
+        const double FlatBuildTime = FPlatformTime::Seconds() - StartTime;
+
+        StartTime = FPlatformTime::Seconds();
+        FQuadtree BulkTree(WorldBounds, MaxSplinesPerNode, MaxDepth);
+        BulkTree.BulkLoad(Splines);
+        const double BulkBuildTime = FPlatformTime::Seconds() - StartTime;
+
+        // The grid uses the cell size the automatic selection would pick, or the search radius if it prefers the quadtree
+        const FSplineSpatialIndexConfig AutoConfig = ISplineSpatialIndex::ChooseConfig(Splines, SearchRadius);
+        const double GridCellSize = AutoConfig.Type == ESplineSpatialIndexType::HashGrid ? AutoConfig.CellSize : SearchRadius;
+
+        StartTime = FPlatformTime::Seconds();
+        FSplineHashGrid Grid(WorldBounds, GridCellSize);
+        Grid.BulkLoad(Splines);
+        const double GridBuildTime = FPlatformTime::Seconds() - StartTime;
+
+        // Areas straddling each edge and corner of the root, each must end up inside after a few levels of growth
+        FQuadtree GrowTree(WorldBounds, MaxSplinesPerNode, MaxDepth);
+        GrowTree.BulkLoad(Splines);
+        const FVector2D WorldCenter = WorldBounds.GetCenter();
+        const FVector2D StraddleExtent(SearchRadius);
+        const FVector2D StraddleCenters[] =
+        {
+            FVector2D(WorldBounds.Min.X, WorldCenter.Y), FVector2D(WorldCenter.X, WorldBounds.Min.Y),
+            FVector2D(WorldBounds.Max.X, WorldCenter.Y), FVector2D(WorldCenter.X, WorldBounds.Max.Y),
+            WorldBounds.Min, WorldBounds.Max
+        };
+        int32 NumGrowLevels = 0;
+        int32 NumContained = 0;
+        for (const FVector2D& StraddleCenter : StraddleCenters)
+        {
+            const FBox2D StraddleArea(StraddleCenter - StraddleExtent, StraddleCenter + StraddleExtent);
+            NumGrowLevels += GrowTree.GrowToContain(StraddleArea);
+            NumContained += GrowTree.GetBounds().IsInside(StraddleArea) ? 1 : 0;
+        }
+
+        int64 LegacyHits = 0;
+        int64 FlatHits = 0;
+        int64 BulkHits = 0;
+        const double LegacyQueryTime = TimeQueries(LegacyTree, Areas, LegacyHits);
+        const double FlatQueryTime = TimeQueries(FlatTree, Areas, FlatHits);
+        const double BulkQueryTime = TimeQueries(BulkTree, Areas, BulkHits);
+        int64 GridHits = 0;
+        const double GridQueryTime = TimeQueries(Grid, Areas, GridHits);
+
+        UE_LOG(LogTemp, Display, TEXT("Quadtree benchmark: %d splines, %d queries, MaxSplinesPerNode %d, MaxDepth %d"), NumSplines, NumQueries, MaxSplinesPerNode, MaxDepth);
+        UE_LOG(LogTemp, Display, TEXT("  Legacy: build %.2f ms, query %.2f ms (%.3f us/query, %lld hits)"),
+            LegacyBuildTime * 1000.0, LegacyQueryTime * 1000.0, LegacyQueryTime * 1e6 / NumQueries, LegacyHits);
+        UE_LOG(LogTemp, Display, TEXT("  Flat:   build %.2f ms, query %.2f ms (%.3f us/query, %lld hits, %d nodes)"),
+            FlatBuildTime * 1000.0, FlatQueryTime * 1000.0, FlatQueryTime * 1e6 / NumQueries, FlatHits, FlatTree.GetNumNodes());
+        UE_LOG(LogTemp, Display, TEXT("  Bulk:   build %.2f ms, query %.2f ms (%.3f us/query, %lld hits, %d nodes)"),
+            BulkBuildTime * 1000.0, BulkQueryTime * 1000.0, BulkQueryTime * 1e6 / NumQueries, BulkHits, BulkTree.GetNumNodes());
+        UE_LOG(LogTemp, Display, TEXT("  Grid:   build %.2f ms, query %.2f ms (%.3f us/query, %lld hits, %d cells of %.0f)"),
+            GridBuildTime * 1000.0, GridQueryTime * 1000.0, GridQueryTime * 1e6 / NumQueries, GridHits, Grid.GetNumNodes(), GridCellSize);
+        UE_LOG(LogTemp, Display, TEXT("  Grow:   %d of %d edge straddling areas contained after %d levels"),
+            NumContained, static_cast<int32>(UE_ARRAY_COUNT(StraddleCenters)), NumGrowLevels);
+        UE_LOG(LogTemp, Display, TEXT("  Automatic selection: %s"), *AutoConfig.ToString());
+        UE_LOG(LogTemp, Display, TEXT("  Query speedup: %.2fx"), FlatQueryTime > 0.0 ? LegacyQueryTime / FlatQueryTime : 0.0);
+
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    // RoadNetwork.Benchmark.QuadtreeLeafScan [NumSplines] [NumQueries] [SearchRadius]
+    static void BenchmarkQuadtreeLeafScan(const TArray<FString>& Args)
+    {
+        const int32 NumSplines = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20000;
+        const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 50000;
+        const double SearchRadius = Args.Num() > 2 ? FCString::Atod(*Args[2]) : 2500.0;
+        const double WorldSize = FMath::Sqrt(static_cast<double>(NumSplines)) * 3000.0;
+        const int32 MaxDepth = 16;
+
+        FRandomStream Random(1337);
+        TArray<USplineComponent*> Splines = CreateSyntheticSplines(NumSplines, WorldSize, Random);
+        TArray<FBox2D> Areas = CreateQueryAreas(NumQueries, WorldSize, SearchRadius, Random);
+        const FBox2D WorldBounds(FVector2D(-WorldSize * 0.1), FVector2D(WorldSize * 1.1));
+
+        UE_LOG(LogTemp, Display, TEXT("Quadtree leaf scan benchmark: %d splines, %d queries, search radius %.0f"), NumSplines, NumQueries, SearchRadius);
+
+        // Leaf occupancy follows MaxSplinesPerNode, so sweep the range used by road networks
+        const int32 LeafSizes[] = { 5, 8, 16, 32, 64 };
+        for (int32 MaxSplinesPerNode : LeafSizes)
+        {
+            FQuadtree Tree(WorldBounds, MaxSplinesPerNode, MaxDepth);
+            Tree.BulkLoad(Splines);
+
+            int64 ScalarHits = 0;
+            int64 VectorHits = 0;
+            Tree.SetUseVectorLeafScan(false);
+            const double ScalarTime = TimeQueries(Tree, Areas, ScalarHits);
+            Tree.SetUseVectorLeafScan(true);
+            const double VectorTime = TimeQueries(Tree, Areas, VectorHits);
+
+            UE_LOG(LogTemp, Display, TEXT("  MaxSplinesPerNode %2d: scalar %.3f us/query, vector %.3f us/query, speedup %.2fx (%d nodes, hits %lld/%lld)"),
+                MaxSplinesPerNode, ScalarTime * 1e6 / NumQueries, VectorTime * 1e6 / NumQueries,
+                VectorTime > 0.0 ? ScalarTime / VectorTime : 0.0, Tree.GetNumNodes(), ScalarHits, VectorHits);
+        }
+
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    // RoadNetwork.Benchmark.NearestRoad [NumSplines] [NumQueries] [CellSize]
+    static void BenchmarkNearestRoad(const TArray<FString>& Args)
+    {
+        const int32 NumSplines = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2000;
+        const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100000;
+        const float CellSize = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 200.0f;
+        const double WorldSize = FMath::Sqrt(static_cast<double>(NumSplines)) * 3000.0;
+
+        FRandomStream Random(1337);
+        TArray<USplineComponent*> Splines = CreateSyntheticSplines(NumSplines, WorldSize, Random);
+        const FBox2D WorldBounds(FVector2D(-WorldSize * 0.1), FVector2D(WorldSize * 1.1));
+
+        TArray<FVector> Locations;
+        Locations.Reserve(NumQueries);
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            Locations.Add(FVector(Random.FRand() * WorldSize, Random.FRand() * WorldSize, 0.0));
+        }
+
+        FSplineSegmentBVH SegmentBVH;
+        SegmentBVH.Build(Splines);
+
+        double StartTime = FPlatformTime::Seconds();
+        FSplineNearestRaster Raster(CellSize, 5000.0f);
+        Raster.Build(SegmentBVH, WorldBounds);
+        const double BakeTime = FPlatformTime::Seconds() - StartTime;
+
+        TArray<FSplineSegmentHit> BVHHits;
+        BVHHits.SetNum(NumQueries);
+        StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            SegmentBVH.FindNearestPoint(Locations[i], BVHHits[i]);
+        }
+        const double BVHQueryTime = FPlatformTime::Seconds() - StartTime;
+
+        TArray<FSplineSegmentHit> RasterHits;
+        RasterHits.SetNum(NumQueries);
+        StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            Raster.FindNearestPoint(SegmentBVH, Locations[i], RasterHits[i]);
+        }
+        const double RasterQueryTime = FPlatformTime::Seconds() - StartTime;
+
+        // Accuracy against the exact BVH answer, for the locations the raster covers
+        int32 NumCovered = 0;
+        int32 NumSameSpline = 0;
+        double MaxExtraDistance = 0.0;
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            if (RasterHits[i].IsValid() && BVHHits[i].IsValid())
+            {
+                NumCovered++;
+                NumSameSpline += RasterHits[i].SplineComponent == BVHHits[i].SplineComponent ? 1 : 0;
+                MaxExtraDistance = FMath::Max(MaxExtraDistance, FMath::Sqrt(RasterHits[i].DistanceSquared) - FMath::Sqrt(BVHHits[i].DistanceSquared));
+            }
+        }
+
+        const FIntPoint NumCells = Raster.GetNumCells();
+        UE_LOG(LogTemp, Display, TEXT("Nearest road benchmark: %d splines, %d queries, %d x %d cells of %.0f baked in %.2f ms"),
+            NumSplines, NumQueries, NumCells.X, NumCells.Y, Raster.GetCellSize(), BakeTime * 1000.0);
+        UE_LOG(LogTemp, Display, TEXT("  BVH:    %.3f us/query"), BVHQueryTime * 1e6 / NumQueries);
+        UE_LOG(LogTemp, Display, TEXT("  Raster: %.3f us/query, speedup %.2fx, %d covered, %.2f%% same spline, max extra distance %.1f"),
+            RasterQueryTime * 1e6 / NumQueries, RasterQueryTime > 0.0 ? BVHQueryTime / RasterQueryTime : 0.0,
+            NumCovered, NumCovered > 0 ? 100.0 * NumSameSpline / NumCovered : 0.0, MaxExtraDistance);
+
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    // RoadNetwork.Benchmark.PathSearch [GridSize] [NumQueries] [NumLandmarks]
+    static void BenchmarkPathSearch(const TArray<FString>& Args)
+    {
+        const int32 GridSize = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+        const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000;
+        const int32 NumLandmarks = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 0;
+
+        FRandomStream Random(1337);
+        TArray<USplineComponent*> Splines = CreateSyntheticRoadGrid(GridSize, 3000.0, 0.15f, Random);
+
+        FRoadGraph Graph;
+        Graph.Build(Splines);
+
+        URoadPathfindingComponent* Pathfinding = NewObject<URoadPathfindingComponent>(GetTransientPackage());
+        Pathfinding->NumLandmarks = NumLandmarks;
+        Pathfinding->BuildLandmarks(Graph);
+        Pathfinding->bUseClusterHierarchy = true;
+        Pathfinding->BuildClusterHierarchy(Graph);
+
+        TArray<TPair<int32, int32>> Queries;
+        Queries.Reserve(NumQueries);
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            Queries.Add({ Random.RandHelper(Graph.GetNumNodes()), Random.RandHelper(Graph.GetNumNodes()) });
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("Path search benchmark: %d nodes, %d edges, %d queries, %d landmarks"),
+            Graph.GetNumNodes(), Graph.GetNumActiveEdges(), NumQueries, NumLandmarks);
+
+        // Shortest path lengths of the first mode, every other mode must find paths of the same length
+        TArray<float> ReferenceLengths;
+        ReferenceLengths.Init(-1.0f, NumQueries);
+
+        const ERoadPathSearchMode Modes[] = { ERoadPathSearchMode::AStar, ERoadPathSearchMode::Bidirectional, ERoadPathSearchMode::Hierarchical };
+        for (ERoadPathSearchMode Mode : Modes)
+        {
+            FRoadGraphPath GraphPath;
+            int64 TotalExpanded = 0;
+            int32 NumFound = 0;
+            float MaxLengthError = 0.0f;
+
+            const double StartTime = FPlatformTime::Seconds();
+            for (int32 i = 0; i < NumQueries; i++)
+            {
+                if (Pathfinding->FindGraphPath(Graph, Queries[i].Key, Queries[i].Value, GraphPath, Mode))
+                {
+                    NumFound++;
+                    if (ReferenceLengths[i] < 0.0f)
+                    {
+                        ReferenceLengths[i] = GraphPath.Length;
+                    }
+                    MaxLengthError = FMath::Max(MaxLengthError, FMath::Abs(GraphPath.Length - ReferenceLengths[i]));
+                }
+                TotalExpanded += Pathfinding->GetLastNumExpanded();
+            }
+            const double QueryTime = FPlatformTime::Seconds() - StartTime;
+
+            UE_LOG(LogTemp, Display, TEXT("  %-13s %.3f us/query, %.1f expanded nodes/query, %d found, max length difference %.3f"),
+                *UEnum::GetDisplayValueAsText(Mode).ToString(), QueryTime * 1e6 / NumQueries,
+                static_cast<double>(TotalExpanded) / NumQueries, NumFound, MaxLengthError);
+        }
+
+        Pathfinding->MarkAsGarbage();
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    // RoadNetwork.Benchmark.FlowField [GridSize] [NumAgents] [NumDestinations]
+    static void BenchmarkFlowField(const TArray<FString>& Args)
+    {
+        const int32 GridSize = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+        const int32 NumAgents = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000;
+        const int32 NumDestinations = FMath::Max(Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 1, 1);
+
+        FRandomStream Random(1337);
+        TArray<USplineComponent*> Splines = CreateSyntheticRoadGrid(GridSize, 3000.0, 0.15f, Random);
+
+        TSharedPtr<FRoadGraph> Graph = MakeShared<FRoadGraph>();
+        Graph->Build(Splines);
+
+        URoadPathfindingComponent* Pathfinding = NewObject<URoadPathfindingComponent>(GetTransientPackage());
+        Pathfinding->FlowFieldCacheSize = NumDestinations;
+
+        // Every agent heads to one of a few shared destinations
+        TArray<TPair<int32, int32>> Queries;
+        Queries.Reserve(NumAgents);
+        for (int32 i = 0; i < NumAgents; i++)
+        {
+            Queries.Add({ Random.RandHelper(Graph->GetNumNodes()), i % NumDestinations });
+        }
+
+        TArray<int32> Destinations;
+        for (int32 i = 0; i < NumDestinations; i++)
+        {
+            Destinations.Add(Random.RandHelper(Graph->GetNumNodes()));
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("Flow field benchmark: %d nodes, %d edges, %d agents, %d destinations"),
+            Graph->GetNumNodes(), Graph->GetNumActiveEdges(), NumAgents, NumDestinations);
+
+        TArray<float> AStarLengths;
+        AStarLengths.Init(-1.0f, NumAgents);
+        FRoadGraphPath GraphPath;
+
+        double StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumAgents; i++)
+        {
+            if (Pathfinding->FindGraphPath(*Graph, Queries[i].Key, Destinations[Queries[i].Value], GraphPath, ERoadPathSearchMode::AStar))
+            {
+                AStarLengths[i] = GraphPath.Length;
+            }
+        }
+        const double AStarTime = FPlatformTime::Seconds() - StartTime;
+
+        // The first agent of every destination pays for the field, the rest only follow it
+        int32 NumMismatches = 0;
+        StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumAgents; i++)
+        {
+            const TSharedPtr<const FRoadFlowField> FlowField = Pathfinding->GetFlowField(Graph, Destinations[Queries[i].Value]);
+            const bool bFound = FlowField->ExtractPath(*Graph, Queries[i].Key, GraphPath);
+            if (bFound != (AStarLengths[i] >= 0.0f) || (bFound && !FMath::IsNearlyEqual(GraphPath.Length, AStarLengths[i], 1.0f)))
+            {
+                NumMismatches++;
+            }
+        }
+        const double FlowFieldTime = FPlatformTime::Seconds() - StartTime;
+
+        const TSharedPtr<const FRoadFlowField> FlowField = Pathfinding->GetFlowField(Graph, Destinations[0]);
+        UE_LOG(LogTemp, Display, TEXT("  A*         %.3f us/agent"), AStarTime * 1e6 / NumAgents);
+        UE_LOG(LogTemp, Display, TEXT("  Flow field %.3f us/agent (%.1fx), %.2f MB per field, %d length mismatches"),
+            FlowFieldTime * 1e6 / NumAgents, FlowFieldTime > 0.0 ? AStarTime / FlowFieldTime : 0.0,
+            FlowField->GetAllocatedSize() / (1024.0 * 1024.0), NumMismatches);
+
+        // Every edit moves the end point of a random street off its junction. Fields the edit can't have changed
+        // are kept, so after the edits they must still route like A* on the edited graph.
+        const int32 NumEdits = 20;
+        int32 NumKeptFields = 0;
+        int32 NumLookups = 0;
+        TArray<TSharedPtr<const FRoadFlowField>> PreviousFields;
+        for (int32 EditIndex = 0; EditIndex < NumEdits; EditIndex++)
+        {
+            PreviousFields.Reset();
+            for (const int32 Destination : Destinations)
+            {
+                PreviousFields.Add(Pathfinding->GetFlowField(Graph, Destination));
+            }
+
+            USplineComponent* MovedSpline = Splines[Random.RandHelper(Splines.Num())];
+            const int32 LastPoint = MovedSpline->GetNumberOfSplinePoints() - 1;
+            MovedSpline->SetLocationAtSplinePoint(LastPoint, MovedSpline->GetLocationAtSplinePoint(LastPoint, ESplineCoordinateSpace::World) + FVector(100.0, 0.0, 0.0),
+                ESplineCoordinateSpace::World);
+
+            const uint32 PreviousRevision = Graph->GetRevision();
+            FRoadGraphEdit Edit;
+            Graph->UpdateSpline(MovedSpline, &Edit);
+            Pathfinding->OnRoadGraphEdited(Graph, PreviousRevision, Edit);
+
+            for (int32 DestinationIndex = 0; DestinationIndex < Destinations.Num(); DestinationIndex++)
+            {
+                const TSharedPtr<const FRoadFlowField> EditedField = Pathfinding->GetFlowField(Graph, Destinations[DestinationIndex]);
+                if (EditedField.IsValid() && EditedField == PreviousFields[DestinationIndex])
+                {
+                    NumKeptFields++;
+                }
+                NumLookups++;
+            }
+        }
+
+        int32 NumEditMismatches = 0;
+        for (int32 i = 0; i < NumAgents; i++)
+        {
+            const int32 GoalNodeId = Destinations[Queries[i].Value];
+            const TSharedPtr<const FRoadFlowField> EditedField = Pathfinding->GetFlowField(Graph, GoalNodeId);
+            const bool bAStarFound = Pathfinding->FindGraphPath(*Graph, Queries[i].Key, GoalNodeId, GraphPath, ERoadPathSearchMode::AStar);
+            const float AStarLength = GraphPath.Length;
+            const bool bFound = EditedField.IsValid() && EditedField->ExtractPath(*Graph, Queries[i].Key, GraphPath);
+            if (EditedField.IsValid() && (bFound != bAStarFound || (bFound && !FMath::IsNearlyEqual(GraphPath.Length, AStarLength, 1.0f))))
+            {
+                NumEditMismatches++;
+            }
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("  Edits      %d of %d fields kept over %d edits, %d length mismatches after the edits"),
+            NumKeptFields, NumLookups, NumEdits, NumEditMismatches);
+
+        Pathfinding->MarkAsGarbage();
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    // RoadNetwork.Benchmark.GraphEdit [GridSize] [NumEdits]
+    static void BenchmarkGraphEdit(const TArray<FString>& Args)
+    {
+        const int32 GridSize = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+        const int32 NumEdits = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100;
+
+        FRandomStream Random(1337);
+        TArray<USplineComponent*> Splines = CreateSyntheticRoadGrid(GridSize, 3000.0, 0.15f, Random);
+
+        double StartTime = FPlatformTime::Seconds();
+        TSharedPtr<FRoadGraph> Graph = MakeShared<FRoadGraph>();
+        Graph->Build(Splines);
+        const double BuildTime = FPlatformTime::Seconds() - StartTime;
+
+        UE_LOG(LogTemp, Display, TEXT("Graph edit benchmark: %d nodes, %d edges, %d edits"), Graph->GetNumNodes(), Graph->GetNumActiveEdges(), NumEdits);
+
+        // Every edit moves the end point of a random street off its junction, then removes and re-adds another street.
+        // Nothing else holds the graph, so it is edited in place like the road actor does between searches.
+        TArray<FVector> NodeLocations;
+        for (int32 NodeId = 0; NodeId < Graph->GetNumNodes(); NodeId++)
+        {
+            NodeLocations.Add(Graph->GetNodeLocation(NodeId));
+        }
+
+        // The cluster hierarchy follows the edits like the pathfinding component does, looking only at the touched nodes
+        StartTime = FPlatformTime::Seconds();
+        TSharedPtr<FRoadClusterHierarchy> Hierarchy = MakeShared<FRoadClusterHierarchy>();
+        Hierarchy->Build(*Graph, FRoadClusterHierarchy::ChooseClusterSize(*Graph));
+        const double HierarchyBuildTime = FPlatformTime::Seconds() - StartTime;
+        double HierarchyUpdateTime = 0.0;
+        int32 NumUpdatedClusters = 0;
+
+        TSet<int32> EditedNodes;
+        StartTime = FPlatformTime::Seconds();
+        for (int32 EditIndex = 0; EditIndex < NumEdits; EditIndex++)
+        {
+            USplineComponent* MovedSpline = Splines[Random.RandHelper(Splines.Num())];
+            const int32 MovedIndex = Graph->FindSplineIndex(MovedSpline);
+            EditedNodes.Add(Graph->GetSplineStartNode(MovedIndex));
+            EditedNodes.Add(Graph->GetSplineEndNode(MovedIndex));
+
+            const int32 LastPoint = MovedSpline->GetNumberOfSplinePoints() - 1;
+            MovedSpline->SetLocationAtSplinePoint(LastPoint, MovedSpline->GetLocationAtSplinePoint(LastPoint, ESplineCoordinateSpace::World) + FVector(100.0, 0.0, 0.0),
+                ESplineCoordinateSpace::World);
+
+            FRoadGraphEdit Edit;
+            Graph->UpdateSpline(MovedSpline, &Edit);
+
+            USplineComponent* ReplacedSpline = Splines[Random.RandHelper(Splines.Num())];
+            EditedNodes.Add(Graph->GetSplineStartNode(Graph->FindSplineIndex(ReplacedSpline)));
+            EditedNodes.Add(Graph->GetSplineEndNode(Graph->FindSplineIndex(ReplacedSpline)));
+            Graph->RemoveSpline(ReplacedSpline, &Edit);
+            Graph->AddSpline(ReplacedSpline, &Edit);
+
+            const double UpdateStartTime = FPlatformTime::Seconds();
+            NumUpdatedClusters += Hierarchy->Update(*Graph, Edit);
+            HierarchyUpdateTime += FPlatformTime::Seconds() - UpdateStartTime;
+        }
+        const double EditTime = FPlatformTime::Seconds() - StartTime - HierarchyUpdateTime;
+
+        // Nodes away from the edited streets must keep their ids
+        int32 NumMovedNodes = 0;
+        for (int32 NodeId = 0; NodeId < NodeLocations.Num(); NodeId++)
+        {
+            if (!EditedNodes.Contains(NodeId) && (!Graph->IsNodeActive(NodeId) || !Graph->GetNodeLocation(NodeId).Equals(NodeLocations[NodeId], 0.0)))
+            {
+                NumMovedNodes++;
+            }
+        }
+
+        FRoadGraph RebuiltGraph;
+        RebuiltGraph.Build(Splines);
+
+        // Routes on the updated hierarchy must be as long as plain A* on the edited graph
+        URoadPathfindingComponent* Pathfinding = NewObject<URoadPathfindingComponent>(GetTransientPackage());
+        FRoadPathSearchContext Context;
+        FRoadGraphPath HierarchyPath;
+        FRoadGraphPath AStarPath;
+        int32 NumMismatches = 0;
+        const int32 NumChecks = 200;
+        for (int32 i = 0; i < NumChecks; i++)
+        {
+            const int32 StartNodeId = Random.RandHelper(Graph->GetNumNodes());
+            const int32 GoalNodeId = Random.RandHelper(Graph->GetNumNodes());
+            const bool bHierarchyFound = Hierarchy->FindPath(*Graph, StartNodeId, GoalNodeId, Context, HierarchyPath);
+            const bool bAStarFound = Pathfinding->FindGraphPath(*Graph, StartNodeId, GoalNodeId, AStarPath, ERoadPathSearchMode::AStar);
+            if (bHierarchyFound != bAStarFound || (bAStarFound && !FMath::IsNearlyEqual(HierarchyPath.Length, AStarPath.Length, 1.0f)))
+            {
+                NumMismatches++;
+            }
+        }
+        Pathfinding->MarkAsGarbage();
+
+        UE_LOG(LogTemp, Display, TEXT("  Full build   %.3f ms"), BuildTime * 1000.0);
+        UE_LOG(LogTemp, Display, TEXT("  Edit         %.3f ms/edit (%.1fx), %d edges after the edits, %d in a fresh build, %d unrelated nodes changed id"),
+            EditTime * 1000.0 / NumEdits, EditTime > 0.0 ? BuildTime * NumEdits / EditTime : 0.0, Graph->GetNumActiveEdges(), RebuiltGraph.GetNumActiveEdges(), NumMovedNodes);
+        UE_LOG(LogTemp, Display, TEXT("  Clusters     %.3f ms full build of %d, %.3f ms/edit (%.1fx) recomputing %.1f clusters/edit, %d of %d routes differ from A*"),
+            HierarchyBuildTime * 1000.0, Hierarchy->GetNumClusters(), HierarchyUpdateTime * 1000.0 / NumEdits,
+            HierarchyUpdateTime > 0.0 ? HierarchyBuildTime * NumEdits / HierarchyUpdateTime : 0.0,
+            static_cast<double>(NumUpdatedClusters) / NumEdits, NumMismatches, NumChecks);
+
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    // RoadNetwork.Benchmark.NearestNode [GridSize] [NumQueries]
+    static void BenchmarkNearestNode(const TArray<FString>& Args)
+    {
+        const int32 GridSize = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+        const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000;
+
+        FRandomStream Random(1337);
+        const double Spacing = 3000.0;
+        TArray<USplineComponent*> Splines = CreateSyntheticRoadGrid(GridSize, Spacing, 0.15f, Random);
+
+        FRoadGraph Graph;
+        Graph.Build(Splines);
+
+        // Queries cover the grid and a margin of one street around it
+        const double WorldSize = (GridSize + 1) * Spacing;
+        TArray<FVector> Locations;
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            Locations.Add(FVector(Random.FRand() * WorldSize - Spacing, Random.FRand() * WorldSize - Spacing, 0.0));
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("Nearest node benchmark: %d nodes, %d queries"), Graph.GetNumNodes(), NumQueries);
+
+        // Linear scan over all nodes, as the lookup worked before the grid index
+        TArray<int32> ScanNodes;
+        double StartTime = FPlatformTime::Seconds();
+        for (const FVector& Location : Locations)
+        {
+            int32 NearestNode = INDEX_NONE;
+            double NearestDistanceSquared = TNumericLimits<double>::Max();
+            for (int32 NodeId = 0; NodeId < Graph.GetNumNodes(); NodeId++)
+            {
+                const double DistanceSquared = FVector::DistSquared(Location, Graph.GetNodeLocation(NodeId));
+                if (Graph.IsNodeActive(NodeId) && DistanceSquared < NearestDistanceSquared)
+                {
+                    NearestDistanceSquared = DistanceSquared;
+                    NearestNode = NodeId;
+                }
+            }
+            ScanNodes.Add(NearestNode);
+        }
+        const double ScanTime = FPlatformTime::Seconds() - StartTime;
+
+        TArray<int32> IndexNodes;
+        StartTime = FPlatformTime::Seconds();
+        for (const FVector& Location : Locations)
+        {
+            IndexNodes.Add(Graph.FindNearestNode(Location));
+        }
+        const double IndexTime = FPlatformTime::Seconds() - StartTime;
+
+        TArray<int32> BatchNodes;
+        StartTime = FPlatformTime::Seconds();
+        Graph.FindNearestNodesBatch(Locations, BatchNodes);
+        const double BatchTime = FPlatformTime::Seconds() - StartTime;
+
+        // Ties between equally distant nodes may resolve either way, so results are compared by distance
+        int32 NumMismatches = 0;
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            const double ScanDistance = FVector::Dist(Locations[i], Graph.GetNodeLocation(ScanNodes[i]));
+            if (!FMath::IsNearlyEqual(ScanDistance, FVector::Dist(Locations[i], Graph.GetNodeLocation(IndexNodes[i])), 0.01)
+                || !FMath::IsNearlyEqual(ScanDistance, FVector::Dist(Locations[i], Graph.GetNodeLocation(BatchNodes[i])), 0.01))
+            {
+                NumMismatches++;
+            }
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("  Linear scan %.3f us/query"), ScanTime * 1e6 / NumQueries);
+        UE_LOG(LogTemp, Display, TEXT("  Grid index  %.3f us/query (%.1fx)"), IndexTime * 1e6 / NumQueries, IndexTime > 0.0 ? ScanTime / IndexTime : 0.0);
+        UE_LOG(LogTemp, Display, TEXT("  Batch       %.3f us/query (%.1fx), %d mismatches"), BatchTime * 1e6 / NumQueries, BatchTime > 0.0 ? ScanTime / BatchTime : 0.0, NumMismatches);
+
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    // RoadNetwork.Benchmark.LaneRefinement [GridSize] [NumQueries] [LaneOffset]
+    static void BenchmarkLaneRefinement(const TArray<FString>& Args)
+    {
+        const int32 GridSize = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50;
+        const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000;
+        const float LaneOffset = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 125.0f;
+
+        FRandomStream Random(1337);
+        TArray<USplineComponent*> Splines = CreateSyntheticRoadGrid(GridSize, 3000.0, 0.15f, Random);
+
+        double StartTime = FPlatformTime::Seconds();
+        FRoadGraph Graph;
+        Graph.SetLaneOffsets({ LaneOffset });
+        Graph.Build(Splines);
+        const double BuildTime = FPlatformTime::Seconds() - StartTime;
+
+        // Random stretches of random streets in either direction, as the spans of a path
+        TArray<FRoadPathSpan> Spans;
+        for (int32 i = 0; i < NumQueries; i++)
+        {
+            const int32 SplineIndex = Random.RandHelper(Graph.GetNumSplines());
+            const float EndKey = Graph.GetSplineKeyAtNode(SplineIndex, Graph.GetSplineEndNode(SplineIndex));
+            Spans.Add({ SplineIndex, Random.FRand() * EndKey, Random.FRand() * EndKey });
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("Lane refinement benchmark: %d splines, %d spans, lanes sampled in %.3f ms"), Graph.GetNumSplines(), NumQueries, BuildTime * 1000.0);
+
+        // Sampling the spline per query and offsetting every point, as paths were refined before the lanes
+        int32 NumSampledPoints = 0;
+        StartTime = FPlatformTime::Seconds();
+        for (const FRoadPathSpan& Span : Spans)
+        {
+            TArray<FVector> Points = SplineUtilities::GetSplinePointsBetweenInputKeys(Graph.GetSplineComponent(Span.SplineIndex), FRoadSplineLanes::DefaultSampleSpacing, Span.StartKey, Span.EndKey);
+            for (int32 PointIndex = 0; PointIndex < Points.Num(); PointIndex++)
+            {
+                const FVector Forward = PointIndex + 1 < Points.Num()
+                    ? (Points[PointIndex + 1] - Points[PointIndex]).GetSafeNormal()
+                    : (PointIndex > 0 ? (Points[PointIndex] - Points[PointIndex - 1]).GetSafeNormal() : FVector::ForwardVector);
+                Points[PointIndex] += FVector::CrossProduct(FVector::UpVector, Forward).GetSafeNormal() * LaneOffset;
+            }
+            NumSampledPoints += Points.Num();
+        }
+        const double SampleTime = FPlatformTime::Seconds() - StartTime;
+
+        int32 NumLanePoints = 0;
+        TArray<FVector> LanePoints;
+        StartTime = FPlatformTime::Seconds();
+        for (const FRoadPathSpan& Span : Spans)
+        {
+            LanePoints.Reset();
+            Graph.GetSplineLanes(Span.SplineIndex)->AppendPoints(Span.StartKey, Span.EndKey, 0, LanePoints);
+            NumLanePoints += LanePoints.Num();
+        }
+        const double LaneTime = FPlatformTime::Seconds() - StartTime;
+
+        SIZE_T LaneBytes = 0;
+        for (int32 SplineIndex = 0; SplineIndex < Graph.GetNumSplines(); SplineIndex++)
+        {
+            LaneBytes += Graph.GetSplineLanes(SplineIndex)->GetAllocatedSize();
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("  Spline sampling %.3f us/span, %d points"), SampleTime * 1e6 / NumQueries, NumSampledPoints);
+        UE_LOG(LogTemp, Display, TEXT("  Lane copy       %.3f us/span (%.1fx), %d points, %.2f MB of lanes"),
+            LaneTime * 1e6 / NumQueries, LaneTime > 0.0 ? SampleTime / LaneTime : 0.0, NumLanePoints, LaneBytes / (1024.0 * 1024.0));
+
+        for (USplineComponent* Spline : Splines)
+        {
+            Spline->MarkAsGarbage();
+        }
+    }
+
+    static FAutoConsoleCommand BenchmarkQuadtreeCommand(
+        TEXT("RoadNetwork.Benchmark.Quadtree"),
+        TEXT("Compares build and area query times of the flat quadtree, incremental and bulk-loaded, against the legacy pointer quadtree. Args: [NumSplines] [NumQueries] [MaxSplinesPerNode] [MaxDepth]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkQuadtree)
+    );
+
+    static FAutoConsoleCommand BenchmarkQuadtreeLeafScanCommand(
+        TEXT("RoadNetwork.Benchmark.QuadtreeLeafScan"),
+        TEXT("Compares the packed vector leaf scan of the quadtree against the scalar scan for MaxSplinesPerNode 5 to 64. Args: [NumSplines] [NumQueries] [SearchRadius]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkQuadtreeLeafScan)
+    );
+
+    static FAutoConsoleCommand BenchmarkNearestRoadCommand(
+        TEXT("RoadNetwork.Benchmark.NearestRoad"),
+        TEXT("Compares nearest road lookups on the baked raster against the segment BVH, and reports how often they agree. Args: [NumSplines] [NumQueries] [CellSize]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkNearestRoad)
+    );
+
+    static FAutoConsoleCommand BenchmarkPathSearchCommand(
+        TEXT("RoadNetwork.Benchmark.PathSearch"),
+        TEXT("Compares time and expanded nodes of unidirectional A*, bidirectional A* and hierarchical A* over the cluster grid on a synthetic road grid, and checks all three find equally long paths. Args: [GridSize] [NumQueries] [NumLandmarks]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkPathSearch)
+    );
+
+    static FAutoConsoleCommand BenchmarkFlowFieldCommand(
+        TEXT("RoadNetwork.Benchmark.FlowField"),
+        TEXT("Compares per agent A* searches against following cached flow fields when many agents share a few destinations, and checks both find equally long paths. Args: [GridSize] [NumAgents] [NumDestinations]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkFlowField)
+    );
+
+    static FAutoConsoleCommand BenchmarkGraphEditCommand(
+        TEXT("RoadNetwork.Benchmark.GraphEdit"),
+        TEXT("Compares a full road graph build against incremental spline edits that patch the edges of the touched nodes in place, and the cluster hierarchy build against its updates. Checks that unrelated node ids stay stable and routes match A*. Args: [GridSize] [NumEdits]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkGraphEdit)
+    );
+
+    static FAutoConsoleCommand BenchmarkNearestNodeCommand(
+        TEXT("RoadNetwork.Benchmark.NearestNode"),
+        TEXT("Compares nearest road node lookups on the grid index, single and batched, against a linear scan over all nodes. Args: [GridSize] [NumQueries]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkNearestNode)
+    );
+
+    static FAutoConsoleCommand BenchmarkLaneRefinementCommand(
+        TEXT("RoadNetwork.Benchmark.LaneRefinement"),
+        TEXT("Compares refining path spans by sampling the splines and offsetting every point against copying the precomputed lane polylines. Args: [GridSize] [NumQueries] [LaneOffset]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkLaneRefinement)
+    );
+}
+
+#endif // !UE_BUILD_SHIPPING
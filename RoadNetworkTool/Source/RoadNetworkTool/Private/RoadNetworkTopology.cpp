@@ -0,0 +1,164 @@
+#include "RoadNetworkTopology.h"
+
+// ---------- Endpoint Hash ---------
+FRoadEndpointHash::FRoadEndpointHash(float InTolerance)
+    : Tolerance(FMath::Max(InTolerance, UE_KINDA_SMALL_NUMBER))
+{
+}
+
+float FRoadEndpointHash::GetTolerance() const
+{
+    return Tolerance;
+}
+
+void FRoadEndpointHash::Reset()
+{
+    Cells.Reset();
+}
+
+int32 FRoadEndpointHash::Find(const FVector& Location) const
+{
+    const FIntVector Cell = GetCell(Location);
+
+    int32 NearestId = INDEX_NONE;
+    double NearestDistanceSquared = FMath::Square(static_cast<double>(Tolerance));
+
+    for (int32 Z = Cell.Z - 1; Z <= Cell.Z + 1; Z++)
+    {
+        for (int32 Y = Cell.Y - 1; Y <= Cell.Y + 1; Y++)
+        {
+            for (int32 X = Cell.X - 1; X <= Cell.X + 1; X++)
+            {
+                const TArray<FEntry, TInlineAllocator<2>>* Entries = Cells.Find(FIntVector(X, Y, Z));
+                if (!Entries)
+                {
+                    continue;
+                }
+
+                for (const FEntry& Entry : *Entries)
+                {
+                    const double DistanceSquared = FVector::DistSquared(Location, Entry.Location);
+                    if (DistanceSquared <= NearestDistanceSquared)
+                    {
+                        NearestDistanceSquared = DistanceSquared;
+                        NearestId = Entry.Id;
+                    }
+                }
+            }
+        }
+    }
+
+    return NearestId;
+}
+
+void FRoadEndpointHash::Add(const FVector& Location, int32 Id)
+{
+    Cells.FindOrAdd(GetCell(Location)).Add({ Location, Id });
+}
+
+void FRoadEndpointHash::Remove(const FVector& Location, int32 Id)
+{
+    const FIntVector Cell = GetCell(Location);
+    if (TArray<FEntry, TInlineAllocator<2>>* Entries = Cells.Find(Cell))
+    {
+        Entries->RemoveAllSwap([Id](const FEntry& Entry) { return Entry.Id == Id; }, EAllowShrinking::No);
+        if (Entries->Num() == 0)
+        {
+            Cells.Remove(Cell);
+        }
+    }
+}
+
+FIntVector FRoadEndpointHash::GetCell(const FVector& Location) const
+{
+    return FIntVector(
+        FMath::FloorToInt32(Location.X / Tolerance),
+        FMath::FloorToInt32(Location.Y / Tolerance),
+        FMath::FloorToInt32(Location.Z / Tolerance));
+}
+
+// ---------- Constructor ---------
+FRoadNetworkTopology::FRoadNetworkTopology(float InWeldTolerance)
+    : NodeHash(InWeldTolerance)
+{
+}
+
+// ---------- Public Methods ---------
+void FRoadNetworkTopology::Build(const TArray<USplineComponent*>& SplineComponents)
+{
+    Nodes.Reset();
+    Splines.Reset();
+    SplineIndices.Reset();
+    NodeHash.Reset();
+
+    auto WeldEnd = [this](const FVector& Location, USplineComponent* Spline)
+        {
+            int32 NodeId = NodeHash.Find(Location);
+            if (NodeId == INDEX_NONE)
+            {
+                NodeId = Nodes.AddDefaulted();
+                Nodes[NodeId].Location = Location;
+                NodeHash.Add(Location, NodeId);
+            }
+
+            FRoadTopologyNode& Node = Nodes[NodeId];
+            Node.Splines.AddUnique(Spline);
+            Node.Degree++;
+            return NodeId;
+        };
+
+    for (USplineComponent* Spline : SplineComponents)
+    {
+        if (!Spline || Spline->GetNumberOfSplinePoints() < 1 || SplineIndices.Contains(Spline))
+        {
+            continue;
+        }
+
+        const int32 LastPoint = Spline->GetNumberOfSplinePoints() - 1;
+
+        FRoadTopologySpline& TopologySpline = Splines.AddDefaulted_GetRef();
+        TopologySpline.SplineComponent = Spline;
+        TopologySpline.StartNode = WeldEnd(Spline->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World), Spline);
+        TopologySpline.EndNode = WeldEnd(Spline->GetLocationAtSplinePoint(LastPoint, ESplineCoordinateSpace::World), Spline);
+        TopologySpline.EndKey = static_cast<float>(LastPoint);
+        TopologySpline.Length = Spline->GetDistanceAlongSplineAtSplinePoint(LastPoint);
+
+        SplineIndices.Add(Spline, Splines.Num() - 1);
+    }
+}
+
+float FRoadNetworkTopology::GetWeldTolerance() const
+{
+    return NodeHash.GetTolerance();
+}
+
+int32 FRoadNetworkTopology::GetNumNodes() const
+{
+    return Nodes.Num();
+}
+
+const FRoadTopologyNode& FRoadNetworkTopology::GetNode(int32 NodeId) const
+{
+    return Nodes[NodeId];
+}
+
+int32 FRoadNetworkTopology::FindNode(const FVector& Location) const
+{
+    return NodeHash.Find(Location);
+}
+
+int32 FRoadNetworkTopology::GetNumSplines() const
+{
+    return Splines.Num();
+}
+
+const FRoadTopologySpline& FRoadNetworkTopology::GetSpline(int32 SplineIndex) const
+{
+    return Splines[SplineIndex];
+}
+
+int32 FRoadNetworkTopology::FindSplineIndex(const USplineComponent* SplineComponent) const
+{
+    const int32* SplineIndex = SplineIndices.Find(SplineComponent);
+    return SplineIndex ? *SplineIndex : INDEX_NONE;
+}
@@ -0,0 +1,215 @@
+#include "RoadNodeIndex.h"
+
+namespace
+{
+    // Keeps cell coordinates and the ring distances between them within int32
+    constexpr double MaxCellCoord = static_cast<double>(1 << 29);
+}
+
+// ---------- Constructor ---------
+FRoadNodeIndex::FRoadNodeIndex(double InCellSize)
+{
+    Reset(InCellSize);
+}
+
+// ---------- Public Methods ---------
+double FRoadNodeIndex::ChooseCellSize(const FBox2D& Bounds, int32 NumNodes)
+{
+    if (!Bounds.bIsValid || NumNodes <= 0)
+    {
+        return 5000.0;
+    }
+
+    const FVector2D Size = Bounds.GetSize();
+    const double Area = FMath::Max(Size.X, 1.0) * FMath::Max(Size.Y, 1.0);
+    return FMath::Max(FMath::Sqrt(4.0 * Area / NumNodes), 100.0);
+}
+
+void FRoadNodeIndex::Reset(double InCellSize)
+{
+    CellSize = FMath::Max(InCellSize, 1.0);
+    NumEntries = 0;
+    Cells.Reset();
+    MinCell = FIntPoint(MAX_int32, MAX_int32);
+    MaxCell = FIntPoint(MIN_int32, MIN_int32);
+}
+
+double FRoadNodeIndex::GetCellSize() const
+{
+    return CellSize;
+}
+
+int32 FRoadNodeIndex::Num() const
+{
+    return NumEntries;
+}
+
+void FRoadNodeIndex::Add(int32 NodeId, const FVector& Location)
+{
+    const FIntPoint Cell = GetCell(Location);
+    Cells.FindOrAdd(Cell).Add({ Location, NodeId });
+    NumEntries++;
+
+    MinCell = FIntPoint(FMath::Min(MinCell.X, Cell.X), FMath::Min(MinCell.Y, Cell.Y));
+    MaxCell = FIntPoint(FMath::Max(MaxCell.X, Cell.X), FMath::Max(MaxCell.Y, Cell.Y));
+}
+
+void FRoadNodeIndex::Remove(int32 NodeId, const FVector& Location)
+{
+    const FIntPoint Cell = GetCell(Location);
+    if (TArray<FEntry, TInlineAllocator<4>>* Entries = Cells.Find(Cell))
+    {
+        NumEntries -= Entries->RemoveAllSwap([NodeId](const FEntry& Entry) { return Entry.NodeId == NodeId; }, EAllowShrinking::No);
+        if (Entries->Num() == 0)
+        {
+            Cells.Remove(Cell);
+        }
+    }
+}
+
+int32 FRoadNodeIndex::FindNearest(const FVector& Location, double MaxDistance) const
+{
+    FNearestList Nearest;
+    FindNearestEntries(Location, 1, MaxDistance, Nearest);
+    return Nearest.Num() > 0 ? Nearest[0].Value : INDEX_NONE;
+}
+
+void FRoadNodeIndex::FindNearest(const FVector& Location, int32 K, double MaxDistance, TArray<int32>& OutNodeIds) const
+{
+    OutNodeIds.Reset();
+
+    FNearestList Nearest;
+    FindNearestEntries(Location, K, MaxDistance, Nearest);
+    for (const TPair<double, int32>& Entry : Nearest)
+    {
+        OutNodeIds.Add(Entry.Value);
+    }
+}
+
+void FRoadNodeIndex::FindInRadius(const FVector& Location, double Radius, TArray<int32>& OutNodeIds) const
+{
+    OutNodeIds.Reset();
+    if (NumEntries == 0 || Radius < 0.0)
+    {
+        return;
+    }
+
+    const FIntPoint FirstCell = GetCell(Location - FVector(Radius, Radius, 0.0));
+    const FIntPoint LastCell = GetCell(Location + FVector(Radius, Radius, 0.0));
+    const double RadiusSquared = FMath::Square(Radius);
+
+    for (int32 Y = FMath::Max(FirstCell.Y, MinCell.Y); Y <= FMath::Min(LastCell.Y, MaxCell.Y); Y++)
+    {
+        for (int32 X = FMath::Max(FirstCell.X, MinCell.X); X <= FMath::Min(LastCell.X, MaxCell.X); X++)
+        {
+            if (const TArray<FEntry, TInlineAllocator<4>>* Entries = Cells.Find(FIntPoint(X, Y)))
+            {
+                for (const FEntry& Entry : *Entries)
+                {
+                    if (FVector::DistSquared(Location, Entry.Location) <= RadiusSquared)
+                    {
+                        OutNodeIds.Add(Entry.NodeId);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ---------- Private Methods ---------
+FIntPoint FRoadNodeIndex::GetCell(const FVector& Location) const
+{
+    return FIntPoint(
+        FMath::FloorToInt32(FMath::Clamp(Location.X / CellSize, -MaxCellCoord, MaxCellCoord)),
+        FMath::FloorToInt32(FMath::Clamp(Location.Y / CellSize, -MaxCellCoord, MaxCellCoord)));
+}
+
+void FRoadNodeIndex::FindNearestEntries(const FVector& Location, int32 K, double MaxDistance, FNearestList& OutNearest) const
+{
+    OutNearest.Reset();
+    if (NumEntries == 0 || K <= 0)
+    {
+        return;
+    }
+
+    const double MaxDistanceSquared = MaxDistance < TNumericLimits<double>::Max() ? FMath::Square(MaxDistance) : TNumericLimits<double>::Max();
+    const FIntPoint Center = GetCell(Location);
+
+    // Rings closer than the occupied cells are empty, rings beyond the farthest occupied cell hold nothing either
+    const int32 FirstRing = FMath::Max3(0, FMath::Max(MinCell.X - Center.X, Center.X - MaxCell.X), FMath::Max(MinCell.Y - Center.Y, Center.Y - MaxCell.Y));
+    const int32 LastRing = FMath::Max(FMath::Max(FMath::Abs(Center.X - MinCell.X), FMath::Abs(Center.X - MaxCell.X)),
+        FMath::Max(FMath::Abs(Center.Y - MinCell.Y), FMath::Abs(Center.Y - MaxCell.Y)));
+
+    for (int32 Ring = FirstRing; Ring <= LastRing; Ring++)
+    {
+        // Nodes in this ring and beyond are at least Ring - 1 full cells away in the plane
+        const double RingDistanceSquared = Ring > 0 ? FMath::Square((Ring - 1) * CellSize) : 0.0;
+        if (RingDistanceSquared > MaxDistanceSquared || (OutNearest.Num() == K && RingDistanceSquared >= OutNearest.Last().Key))
+        {
+            break;
+        }
+
+        VisitRing(Center, Ring, [&](const FEntry& Entry)
+            {
+                const double DistanceSquared = FVector::DistSquared(Location, Entry.Location);
+                if (DistanceSquared > MaxDistanceSquared || (OutNearest.Num() == K && DistanceSquared >= OutNearest.Last().Key))
+                {
+                    return;
+                }
+
+                if (OutNearest.Num() == K)
+                {
+                    OutNearest.Pop(EAllowShrinking::No);
+                }
+
+                int32 InsertIndex = OutNearest.Num();
+                while (InsertIndex > 0 && OutNearest[InsertIndex - 1].Key > DistanceSquared)
+                {
+                    InsertIndex--;
+                }
+                OutNearest.Insert(TPair<double, int32>(DistanceSquared, Entry.NodeId), InsertIndex);
+            });
+    }
+}
+
+void FRoadNodeIndex::VisitRing(const FIntPoint& Center, int32 Ring, TFunctionRef<void(const FEntry&)> Visitor) const
+{
+    auto VisitCell = [this, &Visitor](int32 X, int32 Y)
+        {
+            if (X < MinCell.X || X > MaxCell.X || Y < MinCell.Y || Y > MaxCell.Y)
+            {
+                return;
+            }
+
+            if (const TArray<FEntry, TInlineAllocator<4>>* Entries = Cells.Find(FIntPoint(X, Y)))
+            {
+                for (const FEntry& Entry : *Entries)
+                {
+                    Visitor(Entry);
+                }
+            }
+        };
+
+    if (Ring == 0)
+    {
+        VisitCell(Center.X, Center.Y);
+        return;
+    }
+
+    // Top and bottom rows including the corners, then the columns in between
+    const int32 FirstX = FMath::Max(Center.X - Ring, MinCell.X);
+    const int32 LastX = FMath::Min(Center.X + Ring, MaxCell.X);
+    for (int32 X = FirstX; X <= LastX; X++)
+    {
+        VisitCell(X, Center.Y - Ring);
+        VisitCell(X, Center.Y + Ring);
+    }
+
+    const int32 FirstY = FMath::Max(Center.Y - Ring + 1, MinCell.Y);
+    const int32 LastY = FMath::Min(Center.Y + Ring - 1, MaxCell.Y);
+    for (int32 Y = FirstY; Y <= LastY; Y++)
+    {
+        VisitCell(Center.X - Ring, Y);
+        VisitCell(Center.X + Ring, Y);
+    }
+}
@@ -0,0 +1,144 @@
+#include "RoadPathCache.h"
+#include "Algo/Reverse.h"
+
+// ---------- Key ---------
+FRoadPathCacheKey::FRoadPathCacheKey(const FSplineSegmentHit& StartHit, const FSplineSegmentHit& GoalHit, int32 InStartNode, int32 InGoalNode, int32 InLane)
+    : StartSpline(StartHit.SplineComponent)
+    , GoalSpline(GoalHit.SplineComponent)
+    , StartKey(FMath::RoundToInt32(StartHit.InputKey * KeyResolution))
+    , GoalKey(FMath::RoundToInt32(GoalHit.InputKey * KeyResolution))
+    , StartNode(InStartNode)
+    , GoalNode(InGoalNode)
+    , Lane(InLane)
+{
+}
+
+FRoadPathCacheKey FRoadPathCacheKey::GetReversed() const
+{
+    FRoadPathCacheKey Reversed;
+    Reversed.StartSpline = GoalSpline;
+    Reversed.GoalSpline = StartSpline;
+    Reversed.StartKey = GoalKey;
+    Reversed.GoalKey = StartKey;
+    Reversed.StartNode = GoalNode;
+    Reversed.GoalNode = StartNode;
+    Reversed.Lane = Lane;
+    return Reversed;
+}
+
+// ---------- Constructor ---------
+FRoadPathCache::FRoadPathCache(int32 InCapacity)
+    : Capacity(0), Version(0), NumHits(0), NumMisses(0)
+{
+    SetCapacity(InCapacity);
+}
+
+// ---------- Public Methods ---------
+void FRoadPathCache::SetCapacity(int32 InCapacity)
+{
+    InCapacity = FMath::Max(InCapacity, 0);
+    if (InCapacity != Capacity)
+    {
+        Capacity = InCapacity;
+        Entries.Empty(Capacity);
+    }
+}
+
+int32 FRoadPathCache::GetCapacity() const
+{
+    return Capacity;
+}
+
+int32 FRoadPathCache::Num() const
+{
+    return Capacity > 0 ? Entries.Num() : 0;
+}
+
+void FRoadPathCache::Empty()
+{
+    Entries.Empty(Capacity);
+}
+
+bool FRoadPathCache::Find(const FRoadPathCacheKey& Key, uint32 NetworkVersion, TArray<FVector>& OutPoints)
+{
+    if (Capacity <= 0)
+    {
+        return false;
+    }
+
+    SyncVersion(NetworkVersion);
+
+    bool bReversed = false;
+    const FCachedPath* CachedPath = Entries.FindAndTouch(Key);
+    if (!CachedPath && Key.Lane == INDEX_NONE)
+    {
+        CachedPath = Entries.FindAndTouch(Key.GetReversed());
+        bReversed = true;
+    }
+
+    if (!CachedPath)
+    {
+        NumMisses++;
+        return false;
+    }
+
+    NumHits++;
+    OutPoints.Reset(CachedPath->Points.Num());
+    for (const FVector3f& Point : CachedPath->Points)
+    {
+        OutPoints.Add(CachedPath->Origin + FVector(Point));
+    }
+
+    if (bReversed)
+    {
+        Algo::Reverse(OutPoints);
+    }
+
+    return true;
+}
+
+void FRoadPathCache::Add(const FRoadPathCacheKey& Key, uint32 NetworkVersion, const TArray<FVector>& Points)
+{
+    if (Capacity <= 0 || Points.Num() == 0)
+    {
+        return;
+    }
+
+    SyncVersion(NetworkVersion);
+
+    FCachedPath CachedPath;
+    CachedPath.Origin = Points[0];
+    CachedPath.Points.Reserve(Points.Num());
+    for (const FVector& Point : Points)
+    {
+        CachedPath.Points.Add(FVector3f(Point - CachedPath.Origin));
+    }
+
+    Entries.Add(Key, MoveTemp(CachedPath));
+}
+
+int64 FRoadPathCache::GetNumHits() const
+{
+    return NumHits;
+}
+
+int64 FRoadPathCache::GetNumMisses() const
+{
+    return NumMisses;
+}
+
+void FRoadPathCache::ResetStats()
+{
+    NumHits = 0;
+    NumMisses = 0;
+}
+
+// ---------- Private Methods ---------
+void FRoadPathCache::SyncVersion(uint32 NetworkVersion)
+{
+    if (NetworkVersion != Version)
+    {
+        Version = NetworkVersion;
+        Entries.Empty(Capacity);
+    }
+}
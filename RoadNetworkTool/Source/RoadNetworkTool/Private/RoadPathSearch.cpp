@@ -0,0 +1,193 @@
+#include "RoadPathSearch.h"
+
+// ---------- Constructor ---------
+FPathSearchScratch::FPathSearchScratch()
+    : Generation(0), NumExpanded(0)
+{
+}
+
+// ---------- Public Methods ---------
+void FPathSearchScratch::BeginSearch(int32 NumNodes)
+{
+    if (NodeGenerations.Num() < NumNodes)
+    {
+        NodeGenerations.AddZeroed(NumNodes - NodeGenerations.Num());
+        GScores.SetNumUninitialized(NumNodes);
+        Parents.SetNumUninitialized(NumNodes);
+        HeapPositions.SetNumUninitialized(NumNodes);
+    }
+
+    // Clear the stamps only when the generation counter wraps around
+    if (++Generation == 0)
+    {
+        FMemory::Memzero(NodeGenerations.GetData(), NodeGenerations.Num() * sizeof(uint32));
+        Generation = 1;
+    }
+
+    NumExpanded = 0;
+    OpenHeap.Reset();
+}
+
+float FPathSearchScratch::GetGScore(int32 NodeId) const
+{
+    return NodeGenerations[NodeId] == Generation ? GScores[NodeId] : TNumericLimits<float>::Max();
+}
+
+int32 FPathSearchScratch::GetParent(int32 NodeId) const
+{
+    return NodeGenerations[NodeId] == Generation ? Parents[NodeId] : INDEX_NONE;
+}
+
+bool FPathSearchScratch::IsClosed(int32 NodeId) const
+{
+    return NodeGenerations[NodeId] == Generation && HeapPositions[NodeId] == Closed;
+}
+
+void FPathSearchScratch::SetPath(int32 NodeId, float GScore, int32 Parent, float Priority)
+{
+    Touch(NodeId);
+    GScores[NodeId] = GScore;
+    Parents[NodeId] = Parent;
+
+    int32 HeapPosition = HeapPositions[NodeId];
+    if (HeapPosition == Closed)
+    {
+        // Reopened by an inconsistent heuristic
+        NumExpanded--;
+        HeapPosition = NotQueued;
+    }
+
+    if (HeapPosition == NotQueued)
+    {
+        HeapPosition = OpenHeap.Add({ NodeId, Priority });
+        HeapPositions[NodeId] = HeapPosition;
+        SiftUp(HeapPosition);
+    }
+    else if (Priority < OpenHeap[HeapPosition].Priority)
+    {
+        OpenHeap[HeapPosition].Priority = Priority;
+        SiftUp(HeapPosition);
+    }
+    else
+    {
+        OpenHeap[HeapPosition].Priority = Priority;
+        SiftDown(HeapPosition);
+    }
+}
+
+int32 FPathSearchScratch::PopAndClose()
+{
+    const int32 NodeId = OpenHeap[0].NodeId;
+    HeapPositions[NodeId] = Closed;
+    NumExpanded++;
+
+    const FPathHeapItem Last = OpenHeap.Pop(EAllowShrinking::No);
+    if (OpenHeap.Num() > 0)
+    {
+        Place(0, Last);
+        SiftDown(0);
+    }
+
+    return NodeId;
+}
+
+bool FPathSearchScratch::HasOpenNodes() const
+{
+    return OpenHeap.Num() > 0;
+}
+
+float FPathSearchScratch::GetMinPriority() const
+{
+    return OpenHeap.Num() > 0 ? OpenHeap[0].Priority : TNumericLimits<float>::Max();
+}
+
+int32 FPathSearchScratch::GetNumExpanded() const
+{
+    return NumExpanded;
+}
+
+// ---------- Private Methods ---------
+void FPathSearchScratch::Touch(int32 NodeId)
+{
+    if (NodeGenerations[NodeId] != Generation)
+    {
+        NodeGenerations[NodeId] = Generation;
+        GScores[NodeId] = TNumericLimits<float>::Max();
+        Parents[NodeId] = INDEX_NONE;
+        HeapPositions[NodeId] = NotQueued;
+    }
+}
+
+void FPathSearchScratch::SiftUp(int32 HeapPosition)
+{
+    const FPathHeapItem Item = OpenHeap[HeapPosition];
+    while (HeapPosition > 0)
+    {
+        const int32 ParentPosition = (HeapPosition - 1) / 2;
+        if (OpenHeap[ParentPosition].Priority <= Item.Priority)
+        {
+            break;
+        }
+
+        Place(HeapPosition, OpenHeap[ParentPosition]);
+        HeapPosition = ParentPosition;
+    }
+    Place(HeapPosition, Item);
+}
+
+void FPathSearchScratch::SiftDown(int32 HeapPosition)
+{
+    const FPathHeapItem Item = OpenHeap[HeapPosition];
+    const int32 NumItems = OpenHeap.Num();
+    while (true)
+    {
+        int32 ChildPosition = 2 * HeapPosition + 1;
+        if (ChildPosition >= NumItems)
+        {
+            break;
+        }
+
+        if (ChildPosition + 1 < NumItems && OpenHeap[ChildPosition + 1].Priority < OpenHeap[ChildPosition].Priority)
+        {
+            ChildPosition++;
+        }
+
+        if (Item.Priority <= OpenHeap[ChildPosition].Priority)
+        {
+            break;
+        }
+
+        Place(HeapPosition, OpenHeap[ChildPosition]);
+        HeapPosition = ChildPosition;
+    }
+    Place(HeapPosition, Item);
+}
+
+void FPathSearchScratch::Place(int32 HeapPosition, const FPathHeapItem& Item)
+{
+    OpenHeap[HeapPosition] = Item;
+    HeapPositions[Item.NodeId] = HeapPosition;
+}
+
+// ---------- Context Pool ---------
+TUniquePtr<FRoadPathSearchContext> FRoadPathSearchContextPool::Acquire()
+{
+    {
+        FScopeLock ScopeLock(&Lock);
+        if (FreeContexts.Num() > 0)
+        {
+            return FreeContexts.Pop(EAllowShrinking::No);
+        }
+    }
+
+    return MakeUnique<FRoadPathSearchContext>();
+}
+
+void FRoadPathSearchContextPool::Release(TUniquePtr<FRoadPathSearchContext> Context)
+{
+    if (Context.IsValid())
+    {
+        FScopeLock ScopeLock(&Lock);
+        FreeContexts.Add(MoveTemp(Context));
+    }
+}
@@ -2,260 +2,574 @@
 #include "Containers/Queue.h"
 #include "Algo/Reverse.h"
 #include "RoadActor.h"
+#include "Async/Async.h"
+#include "Engine/World.h"
 
 URoadPathfindingComponent::URoadPathfindingComponent()
 {
     PrimaryComponentTick.bCanEverTick = false;
 }
 
-TArray<TSharedPtr<FPathNode>> URoadPathfindingComponent::FindAllNodes(const TArray<USplineComponent*>& SplineComponents)
+bool URoadPathfindingComponent::AStarPathfinding(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath)
 {
-    TMap<FVector, TSharedPtr<FPathNode>> NodeMap; // Use smart pointers for NodeMap to manage neighbors correctly
+    return AStarPathfinding(Graph, GetActiveLandmarks(Graph), StartNodeId, GoalNodeId, OutPath, SearchContext);
+}
+
+bool URoadPathfindingComponent::AStarPathfinding(const FRoadGraph& Graph, const FRoadLandmarks* ActiveLandmarks, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, FRoadPathSearchContext& Context)
+{
+    OutPath.Reset();
+    Context.NumExpanded = 0;
 
-    // Create nodes and link neighbors
-    for (USplineComponent* Spline : SplineComponents)
+    const int32 NumNodes = Graph.GetNumNodes();
+    if (StartNodeId < 0 || StartNodeId >= NumNodes || GoalNodeId < 0 || GoalNodeId >= NumNodes)
     {
-        FVector StartLocation = Spline->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World);
-        FVector EndLocation = Spline->GetLocationAtSplinePoint(Spline->GetNumberOfSplinePoints() - 1, ESplineCoordinateSpace::World);
+        return false;
+    }
+
+    // Straight-line distance never overestimates an arc length, so closed nodes stay closed.
+    // The landmark bounds are consistent as well, and usually much tighter on winding roads.
+    const FVector GoalLocation = Graph.GetNodeLocation(GoalNodeId);
+    const float* GoalLandmarkDistances = ActiveLandmarks ? ActiveLandmarks->GetNodeDistances(GoalNodeId) : nullptr;
 
-        // Check or add StartNode
-        TSharedPtr<FPathNode>* StartNodePtr = NodeMap.Find(StartLocation);
-        if (StartNodePtr == nullptr)
+    auto Heuristic = [&Graph, &GoalLocation, ActiveLandmarks, GoalLandmarkDistances](int32 NodeId)
         {
-            TSharedPtr<FPathNode> NewNode = MakeShared<FPathNode>(StartLocation);
-            NodeMap.Add(StartLocation, NewNode);
-            StartNodePtr = &NewNode;
-        }
+            const float StraightDistance = static_cast<float>(FVector::Distance(Graph.GetNodeLocation(NodeId), GoalLocation));
+            return ActiveLandmarks ? FMath::Max(StraightDistance, ActiveLandmarks->GetLowerBound(NodeId, GoalLandmarkDistances)) : StraightDistance;
+        };
+
+    FPathSearchScratch& SearchScratch = Context.ForwardScratch;
+    SearchScratch.BeginSearch(NumNodes);
+    SearchScratch.SetPath(StartNodeId, 0.0f, INDEX_NONE, Heuristic(StartNodeId));
 
-        // Check or add EndNode
-        TSharedPtr<FPathNode>* EndNodePtr = NodeMap.Find(EndLocation);
-        if (EndNodePtr == nullptr)
+    while (SearchScratch.HasOpenNodes())
+    {
+        // Get node with the lowest FScore
+        const int32 CurrentId = SearchScratch.PopAndClose();
+
+        if (CurrentId == GoalNodeId)
         {
-            TSharedPtr<FPathNode> NewNode = MakeShared<FPathNode>(EndLocation);
-            NodeMap.Add(EndLocation, NewNode);
-            EndNodePtr = &NewNode;
+            // Reconstruct path, the parent of each node is the edge it was reached by
+            OutPath.Length = SearchScratch.GetGScore(GoalNodeId);
+            for (int32 NodeId = GoalNodeId; NodeId != StartNodeId; )
+            {
+                const int32 EdgeId = SearchScratch.GetParent(NodeId);
+                OutPath.Nodes.Add(NodeId);
+                OutPath.Edges.Add(EdgeId);
+                NodeId = Graph.GetEdgeSource(EdgeId);
+            }
+            OutPath.Nodes.Add(StartNodeId);
+            Algo::Reverse(OutPath.Nodes);
+            Algo::Reverse(OutPath.Edges);
+            Context.NumExpanded = SearchScratch.GetNumExpanded();
+            return true;
         }
 
-        // Link nodes as neighbors if they are different
-        if (*StartNodePtr != *EndNodePtr)
+        const float CurrentGScore = SearchScratch.GetGScore(CurrentId);
+        const int32 EndEdge = Graph.GetEndEdge(CurrentId);
+
+        for (int32 EdgeId = Graph.GetFirstEdge(CurrentId); EdgeId < EndEdge; EdgeId++)
         {
-            if (!(*StartNodePtr)->Neighbors.Contains(*EndNodePtr))
+            const int32 NeighborId = Graph.GetEdgeTarget(EdgeId);
+            if (SearchScratch.IsClosed(NeighborId))
             {
-                (*StartNodePtr)->Neighbors.Add(*EndNodePtr);
+                continue;
             }
 
-            if (!(*EndNodePtr)->Neighbors.Contains(*StartNodePtr))
+            const float TentativeGScore = CurrentGScore + Graph.GetEdgeLength(EdgeId);
+            if (TentativeGScore < SearchScratch.GetGScore(NeighborId))
             {
-                (*EndNodePtr)->Neighbors.Add(*StartNodePtr);
+                SearchScratch.SetPath(NeighborId, TentativeGScore, EdgeId, TentativeGScore + Heuristic(NeighborId));
             }
         }
     }
 
-    // Convert NodeMap values to TArray
-    TArray<TSharedPtr<FPathNode>> PathNodes;
-    NodeMap.GenerateValueArray(PathNodes);
+    // No path found
+    Context.NumExpanded = SearchScratch.GetNumExpanded();
+    return false;
+}
 
-    return PathNodes;
+bool URoadPathfindingComponent::BidirectionalPathfinding(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath)
+{
+    return BidirectionalPathfinding(Graph, GetActiveLandmarks(Graph), StartNodeId, GoalNodeId, OutPath, SearchContext);
 }
 
-TArray<TSharedPtr<FPathNode>> URoadPathfindingComponent::AStarPathfinding(TSharedPtr<FPathNode> StartNode, TSharedPtr<FPathNode> GoalNode, const TArray<TSharedPtr<FPathNode>>& AllNodes)
+bool URoadPathfindingComponent::BidirectionalPathfinding(const FRoadGraph& Graph, const FRoadLandmarks* ActiveLandmarks, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, FRoadPathSearchContext& Context)
 {
-    if (!StartNode.IsValid() || !GoalNode.IsValid())
-    {
-        return TArray<TSharedPtr<FPathNode>>();
-    }
+    OutPath.Reset();
+    Context.NumExpanded = 0;
 
-    TMap<FVector, TSharedPtr<FPathNode>> NodeMap;
-    for (TSharedPtr<FPathNode> Node : AllNodes)
+    const int32 NumNodes = Graph.GetNumNodes();
+    if (StartNodeId < 0 || StartNodeId >= NumNodes || GoalNodeId < 0 || GoalNodeId >= NumNodes)
     {
-        NodeMap.Add(Node->Location, Node);
+        return false;
     }
 
-    // Open set (nodes to be evaluated) and closed set (nodes already evaluated)
-    TSet<TSharedPtr<FPathNode>> OpenSet;
-    TSet<TSharedPtr<FPathNode>> ClosedSet;
-    TMap<TSharedPtr<FPathNode>, TSharedPtr<FPathNode>> CameFrom; // For path reconstruction
-    TMap<TSharedPtr<FPathNode>, float> GScore; // Cost from start node
-    TMap<TSharedPtr<FPathNode>, float> FScore; // Total cost (GScore + heuristic)
-
-    // Initialize scores
-    OpenSet.Add(StartNode);
-    GScore.Add(StartNode, 0.0f);
-    FScore.Add(StartNode, FVector::Distance(StartNode->Location, GoalNode->Location));
+    const FVector StartLocation = Graph.GetNodeLocation(StartNodeId);
+    const FVector GoalLocation = Graph.GetNodeLocation(GoalNodeId);
+    const float* StartLandmarkDistances = ActiveLandmarks ? ActiveLandmarks->GetNodeDistances(StartNodeId) : nullptr;
+    const float* GoalLandmarkDistances = ActiveLandmarks ? ActiveLandmarks->GetNodeDistances(GoalNodeId) : nullptr;
 
-   // Spline - based Heuristic function
-   auto SplineHeuristic = [this](const TSharedPtr<FPathNode> NodeA, const TSharedPtr<FPathNode> NodeB) {
-        // Calculate spline distance between points A and B
-        USplineComponent* SplineComponent = FindSplineContainingNodes(NodeA, NodeB);
+    auto LowerBound = [&Graph, ActiveLandmarks](int32 NodeId, const FVector& TargetLocation, const float* TargetLandmarkDistances)
+        {
+            const float StraightDistance = static_cast<float>(FVector::Distance(Graph.GetNodeLocation(NodeId), TargetLocation));
+            return ActiveLandmarks ? FMath::Max(StraightDistance, ActiveLandmarks->GetLowerBound(NodeId, TargetLandmarkDistances)) : StraightDistance;
+        };
 
-        if (!SplineComponent)
+    // Each direction on its own heuristic would not be consistent with the other one. The averaged potential is,
+    // with the negated value for the backward search, so both searches can stop once their keys add up to the best path.
+    auto ForwardPotential = [&](int32 NodeId)
         {
-            // Fallback to Euclidean distance if no spline is found
-            return FVector::Distance(NodeA->Location, NodeB->Location);
-        }
+            return 0.5f * (LowerBound(NodeId, GoalLocation, GoalLandmarkDistances) - LowerBound(NodeId, StartLocation, StartLandmarkDistances));
+        };
 
-        // Calculate spline distance only between the two nodes
-        float StartKey = SplineComponent->FindInputKeyClosestToWorldLocation(NodeA->Location);
-        float EndKey = SplineComponent->FindInputKeyClosestToWorldLocation(NodeB->Location);
-        double SplineDistance = FMath::Abs(SplineComponent->GetDistanceAlongSplineAtSplineInputKey(EndKey) - SplineComponent->GetDistanceAlongSplineAtSplineInputKey(StartKey));
+    FPathSearchScratch& ForwardScratch = Context.ForwardScratch;
+    FPathSearchScratch& BackwardScratch = Context.BackwardScratch;
+    ForwardScratch.BeginSearch(NumNodes);
+    BackwardScratch.BeginSearch(NumNodes);
+    ForwardScratch.SetPath(StartNodeId, 0.0f, INDEX_NONE, ForwardPotential(StartNodeId));
+    BackwardScratch.SetPath(GoalNodeId, 0.0f, INDEX_NONE, -ForwardPotential(GoalNodeId));
 
-        return SplineDistance;
-        };
+    float BestDistance = StartNodeId == GoalNodeId ? 0.0f : TNumericLimits<float>::Max();
+    int32 MeetingNodeId = StartNodeId == GoalNodeId ? StartNodeId : INDEX_NONE;
 
-    while (OpenSet.Num() > 0)
+    while (ForwardScratch.HasOpenNodes() && BackwardScratch.HasOpenNodes())
     {
-        // Get node with the lowest FScore
-        TSharedPtr<FPathNode> CurrentNode = nullptr;
-        float LowestScore = FLT_MAX;
-        for (TSharedPtr<FPathNode> Node : OpenSet)
+        const float ForwardMin = ForwardScratch.GetMinPriority();
+        const float BackwardMin = BackwardScratch.GetMinPriority();
+        if (ForwardMin + BackwardMin >= BestDistance)
         {
-            float Score = FScore[Node];
-            if (Score < LowestScore)
-            {
-                LowestScore = Score;
-                CurrentNode = Node;
-            }
+            break;
         }
 
-        if (CurrentNode == GoalNode)
-        {
-            // Reconstruct path
-            TArray<TSharedPtr<FPathNode>> Path;
-            while (CameFrom.Contains(CurrentNode))
-            {
-                Path.Add(CurrentNode);
-                CurrentNode = CameFrom[CurrentNode];
-            }
-            Path.Add(StartNode);
-            Algo::Reverse(Path);
-            return Path;
-        }
+        // Expand the side with the smaller key, the edges exist in both directions so both sides walk the same lists
+        const bool bForward = ForwardMin <= BackwardMin;
+        FPathSearchScratch& Scratch = bForward ? ForwardScratch : BackwardScratch;
+        const FPathSearchScratch& OtherScratch = bForward ? BackwardScratch : ForwardScratch;
 
-        OpenSet.Remove(CurrentNode);
-        ClosedSet.Add(CurrentNode);
+        const int32 CurrentId = Scratch.PopAndClose();
+        const float CurrentGScore = Scratch.GetGScore(CurrentId);
+        const int32 EndEdge = Graph.GetEndEdge(CurrentId);
 
-        for (TSharedPtr<FPathNode> Neighbor : CurrentNode->Neighbors)
+        for (int32 EdgeId = Graph.GetFirstEdge(CurrentId); EdgeId < EndEdge; EdgeId++)
         {
-            TSharedPtr<FPathNode>* ActualNeighborPtr = NodeMap.Find(Neighbor->Location);
-            if (ActualNeighborPtr == nullptr || ClosedSet.Contains(*ActualNeighborPtr))
+            const int32 NeighborId = Graph.GetEdgeTarget(EdgeId);
+            if (Scratch.IsClosed(NeighborId))
             {
                 continue;
             }
 
-            TSharedPtr<FPathNode> ActualNeighbor = *ActualNeighborPtr;
-
-            float TentativeGScore = GScore[CurrentNode] + SplineHeuristic(CurrentNode, ActualNeighbor);
-
-            if (!OpenSet.Contains(ActualNeighbor))
-            {
-                OpenSet.Add(ActualNeighbor);
-            }
-            else if (TentativeGScore >= GScore[ActualNeighbor])
+            const float TentativeGScore = CurrentGScore + Graph.GetEdgeLength(EdgeId);
+            if (TentativeGScore >= Scratch.GetGScore(NeighborId))
             {
                 continue;
             }
 
-            CameFrom.Add(ActualNeighbor, CurrentNode);
-            GScore.Add(ActualNeighbor, TentativeGScore);
-            FScore.Add(ActualNeighbor, TentativeGScore + SplineHeuristic(ActualNeighbor, GoalNode));
+            // Backward parents are stored as the edge in travel direction, from the neighbour towards the goal
+            const int32 ParentEdge = bForward ? EdgeId : Graph.GetReverseEdge(EdgeId);
+            const float Potential = bForward ? ForwardPotential(NeighborId) : -ForwardPotential(NeighborId);
+            Scratch.SetPath(NeighborId, TentativeGScore, ParentEdge, TentativeGScore + Potential);
+
+            const float OtherGScore = OtherScratch.GetGScore(NeighborId);
+            if (OtherGScore != TNumericLimits<float>::Max() && TentativeGScore + OtherGScore < BestDistance)
+            {
+                BestDistance = TentativeGScore + OtherGScore;
+                MeetingNodeId = NeighborId;
+            }
         }
     }
 
-    // No path found
-    return TArray<TSharedPtr<FPathNode>>();
+    Context.NumExpanded = ForwardScratch.GetNumExpanded() + BackwardScratch.GetNumExpanded();
+
+    if (MeetingNodeId == INDEX_NONE)
+    {
+        return false;
+    }
+
+    // Reconstruct path, forward parents lead back to the start and backward parents on to the goal
+    OutPath.Length = BestDistance;
+    for (int32 NodeId = MeetingNodeId; NodeId != StartNodeId; )
+    {
+        const int32 EdgeId = ForwardScratch.GetParent(NodeId);
+        OutPath.Edges.Add(EdgeId);
+        NodeId = Graph.GetEdgeSource(EdgeId);
+    }
+    Algo::Reverse(OutPath.Edges);
+
+    for (int32 NodeId = MeetingNodeId; NodeId != GoalNodeId; )
+    {
+        const int32 EdgeId = BackwardScratch.GetParent(NodeId);
+        OutPath.Edges.Add(EdgeId);
+        NodeId = Graph.GetEdgeTarget(EdgeId);
+    }
+
+    OutPath.Nodes.Reserve(OutPath.Edges.Num() + 1);
+    OutPath.Nodes.Add(StartNodeId);
+    for (const int32 EdgeId : OutPath.Edges)
+    {
+        OutPath.Nodes.Add(Graph.GetEdgeTarget(EdgeId));
+    }
+
+    return true;
+}
+
+void URoadPathfindingComponent::BuildLandmarks(const FRoadGraph& Graph)
+{
+    LandmarkBuildId++;
+    PendingLandmarkGraph.Reset();
+    if (NumLandmarks <= 0)
+    {
+        Landmarks.Reset();
+        return;
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    TSharedPtr<FRoadLandmarks> NewLandmarks = MakeShared<FRoadLandmarks>();
+    NewLandmarks->Build(Graph, GetLandmarkCount(Graph.GetNumNodes()));
+    Landmarks = NewLandmarks;
+
+    UE_LOG(LogTemp, Log, TEXT("Built %d landmarks for %d nodes in %.2f ms (%.2f MB)."), Landmarks->GetNumLandmarks(), Graph.GetNumNodes(),
+        (FPlatformTime::Seconds() - StartTime) * 1000.0, Landmarks->GetAllocatedSize() / (1024.0 * 1024.0));
 }
 
-TSharedPtr<FPathNode> URoadPathfindingComponent::FindNearestNodeByLocation(const FVector& Location, const TArray<TSharedPtr<FPathNode>>& AllNodes)
+void URoadPathfindingComponent::BuildLandmarksAsync(TSharedPtr<const FRoadGraph> Graph)
 {
-    if (AllNodes.Num() == 0)
+    LandmarkBuildId++;
+    PendingLandmarkGraph.Reset();
+    if (NumLandmarks <= 0 || !Graph.IsValid())
     {
-        return nullptr;
+        Landmarks.Reset();
+        return;
     }
 
-    TSharedPtr<FPathNode> NearestNode = nullptr;
-    float MinDistance = FLT_MAX;
+    // The running build is outdated now, its result is dropped and this graph is built right after it
+    if (bLandmarkBuildRunning)
+    {
+        PendingLandmarkGraph = Graph;
+        return;
+    }
 
-    for (TSharedPtr<FPathNode> Node : AllNodes)
+    StartLandmarkBuild(Graph);
+}
+
+int32 URoadPathfindingComponent::GetLandmarkCount(int32 NumNodes) const
+{
+    const int32 MaxLandmarks = FRoadLandmarks::GetMaxLandmarksForMemory(NumNodes, MaxLandmarkMemoryMB);
+    const int32 LandmarkCount = FMath::Min(NumLandmarks, MaxLandmarks);
+    if (LandmarkCount < NumLandmarks)
     {
-        float Distance = FVector::Dist(Location, Node->Location);
-        if (Distance < MinDistance)
+        UE_LOG(LogTemp, Warning, TEXT("Landmark tables for %d nodes exceed %.1f MB, using %d of %d landmarks."),
+            NumNodes, MaxLandmarkMemoryMB, LandmarkCount, NumLandmarks);
+    }
+    return LandmarkCount;
+}
+
+void URoadPathfindingComponent::StartLandmarkBuild(TSharedPtr<const FRoadGraph> Graph)
+{
+    bLandmarkBuildRunning = true;
+    const int32 LandmarkCount = GetLandmarkCount(Graph->GetNumNodes());
+    const uint32 BuildId = LandmarkBuildId;
+    TWeakObjectPtr<URoadPathfindingComponent> WeakThis(this);
+
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Graph, BuildId, LandmarkCount]()
         {
-            MinDistance = Distance;
-            NearestNode = Node;
-        }
+            const double StartTime = FPlatformTime::Seconds();
+            TSharedRef<FRoadLandmarks> NewLandmarks = MakeShared<FRoadLandmarks>();
+            NewLandmarks->Build(*Graph, LandmarkCount);
+            const double BuildTime = FPlatformTime::Seconds() - StartTime;
+
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, NewLandmarks, BuildId, BuildTime, NumNodes = Graph->GetNumNodes()]()
+                {
+                    URoadPathfindingComponent* Component = WeakThis.Get();
+                    if (!Component)
+                    {
+                        return;
+                    }
+
+                    Component->bLandmarkBuildRunning = false;
+                    if (Component->LandmarkBuildId == BuildId)
+                    {
+                        Component->Landmarks = NewLandmarks;
+                        UE_LOG(LogTemp, Log, TEXT("Built %d landmarks for %d nodes in %.2f ms (%.2f MB)."), NewLandmarks->GetNumLandmarks(), NumNodes,
+                            BuildTime * 1000.0, NewLandmarks->GetAllocatedSize() / (1024.0 * 1024.0));
+                    }
+
+                    if (const TSharedPtr<const FRoadGraph> PendingGraph = Component->PendingLandmarkGraph.Pin())
+                    {
+                        Component->PendingLandmarkGraph.Reset();
+                        Component->StartLandmarkBuild(PendingGraph);
+                    }
+                });
+        });
+}
+
+void URoadPathfindingComponent::BuildClusterHierarchy(const FRoadGraph& Graph)
+{
+    UpdateClusterHierarchy(Graph, nullptr);
+}
+
+void URoadPathfindingComponent::UpdateClusterHierarchy(const FRoadGraph& Graph, const FRoadGraphEdit* Edit)
+{
+    if (!bUseClusterHierarchy || Graph.GetNumNodes() == 0)
+    {
+        ClusterHierarchy.Reset();
+        return;
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    // An automatic size is only picked once, so edits don't shift the grid and rebuild every cluster
+    double NewClusterSize = ClusterSize;
+    if (NewClusterSize <= 0.0)
+    {
+        NewClusterSize = ClusterHierarchy.IsValid() ? ClusterHierarchy->GetClusterSize() : FRoadClusterHierarchy::ChooseClusterSize(Graph);
+    }
+
+    TSharedPtr<FRoadClusterHierarchy> NewHierarchy;
+    int32 NumBuiltClusters = 0;
+    if (ClusterHierarchy.IsValid() && FMath::IsNearlyEqual(ClusterHierarchy->GetClusterSize(), NewClusterSize, 1.0))
+    {
+        // Searches in flight may still read the current hierarchy, then the edit is applied to a copy
+        NewHierarchy = ClusterHierarchy.IsUnique() ? ConstCastSharedPtr<FRoadClusterHierarchy>(ClusterHierarchy) : MakeShared<FRoadClusterHierarchy>(*ClusterHierarchy);
+        NumBuiltClusters = Edit ? NewHierarchy->Update(Graph, *Edit) : NewHierarchy->Update(Graph);
+    }
+    else
+    {
+        NewHierarchy = MakeShared<FRoadClusterHierarchy>();
+        NewHierarchy->Build(Graph, NewClusterSize);
+        NumBuiltClusters = NewHierarchy->GetNumClusters();
     }
+    ClusterHierarchy = NewHierarchy;
 
-    return NearestNode;
+    UE_LOG(LogTemp, Log, TEXT("Built %d of %d clusters (%d border nodes, %.0f cm) for %d nodes in %.2f ms (%.2f MB)."),
+        NumBuiltClusters, ClusterHierarchy->GetNumClusters(), ClusterHierarchy->GetNumBorderNodes(), ClusterHierarchy->GetClusterSize(),
+        Graph.GetNumNodes(), (FPlatformTime::Seconds() - StartTime) * 1000.0, ClusterHierarchy->GetAllocatedSize() / (1024.0 * 1024.0));
 }
 
-TArray<FVector> URoadPathfindingComponent::GetLocationsFromPathNodes(const TArray<TSharedPtr<FPathNode>>& PathNodes)
+void URoadPathfindingComponent::OnRoadGraphEdited(const TSharedPtr<const FRoadGraph>& Graph, uint32 PreviousRevision, const FRoadGraphEdit& Edit)
 {
-    TArray<FVector> Locations;
+    if (!Graph.IsValid())
+    {
+        return;
+    }
+
+    // One edit can change landmark distances all over the network, so the tables are built again off the game thread
+    BuildLandmarksAsync(Graph);
 
-    // Iterate through the path nodes and collect their locations
-    for (TSharedPtr<FPathNode> Node : PathNodes)
+    // A hierarchy that missed an edit compares every node instead
+    const bool bClusterHierarchyInLine = ClusterHierarchy.IsValid() && ClusterHierarchy->GetGraphRevision() == PreviousRevision;
+    UpdateClusterHierarchy(*Graph, bClusterHierarchyInLine ? &Edit : nullptr);
+
+    BuildContractionHierarchy(Graph);
+
+    // Fields towards other parts of the network usually don't run over the edited splines and are kept
+    FlowFieldCache.ApplyEdit(*Graph, PreviousRevision, Edit);
+}
+
+bool URoadPathfindingComponent::FindGraphPath(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, ERoadPathSearchMode Mode)
+{
+    return FindGraphPath(Graph, GetActiveLandmarks(Graph), IsContractionHierarchyReady() ? ActiveContractionHierarchy.Get() : nullptr,
+        GetActiveClusterHierarchy(Graph), StartNodeId, GoalNodeId, OutPath, Mode, SearchContext);
+}
+
+bool URoadPathfindingComponent::FindGraphPath(const FRoadPathSearchSnapshot& Snapshot, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, ERoadPathSearchMode Mode, FRoadPathSearchContext& Context)
+{
+    if (!Snapshot.Graph.IsValid())
     {
-        if (Node.IsValid())
-        {
-            Locations.Add(Node->Location);
-        }
+        OutPath.Reset();
+        return false;
     }
 
-    return Locations;
+    return FindGraphPath(*Snapshot.Graph, Snapshot.Landmarks.Get(), Snapshot.ContractionHierarchy.Get(), Snapshot.ClusterHierarchy.Get(), StartNodeId, GoalNodeId, OutPath, Mode, Context);
 }
 
-USplineComponent* URoadPathfindingComponent::FindSplineContainingNodes(TSharedPtr<FPathNode> NodeA, TSharedPtr<FPathNode> NodeB) const
+bool URoadPathfindingComponent::FindGraphPath(const FRoadGraph& Graph, const FRoadLandmarks* ActiveLandmarks, const FRoadContractionHierarchy* ActiveHierarchy,
+    const FRoadClusterHierarchy* ActiveClusterHierarchy, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, ERoadPathSearchMode Mode, FRoadPathSearchContext& Context)
 {
-    if (!NodeA.IsValid() || !NodeB.IsValid())
+    switch (Mode)
     {
-        return nullptr;
+    case ERoadPathSearchMode::AStar:
+        return AStarPathfinding(Graph, ActiveLandmarks, StartNodeId, GoalNodeId, OutPath, Context);
+
+    case ERoadPathSearchMode::Bidirectional:
+        return BidirectionalPathfinding(Graph, ActiveLandmarks, StartNodeId, GoalNodeId, OutPath, Context);
+
+    case ERoadPathSearchMode::Hierarchical:
+        ActiveHierarchy = nullptr;
+        break;
+
+    default:
+        break;
     }
 
-    TArray<USplineComponent*> NearbySplines;
-    FindSplinesInArea(NodeA->Location, DefaultSearchRadius, NearbySplines);
+    if (ActiveHierarchy)
+    {
+        const bool bFound = ActiveHierarchy->FindPath(Graph, StartNodeId, GoalNodeId, Context.ForwardScratch, Context.BackwardScratch, OutPath);
+        Context.NumExpanded = Context.ForwardScratch.GetNumExpanded() + Context.BackwardScratch.GetNumExpanded();
+        return bFound;
+    }
+
+    if (ActiveClusterHierarchy)
+    {
+        const bool bFound = ActiveClusterHierarchy->FindPath(Graph, StartNodeId, GoalNodeId, Context, OutPath);
+        Context.NumExpanded = Context.ForwardScratch.GetNumExpanded();
+        return bFound;
+    }
 
-    TArray<USplineComponent*> NearbySplinesForNodeB;
-    FindSplinesInArea(NodeB->Location, DefaultSearchRadius, NearbySplinesForNodeB);
+    return AStarPathfinding(Graph, ActiveLandmarks, StartNodeId, GoalNodeId, OutPath, Context);
+}
 
-    for (USplineComponent* Spline : NearbySplinesForNodeB)
+FRoadPathSearchSnapshot URoadPathfindingComponent::CreateSearchSnapshot(TSharedPtr<const FRoadGraph> Graph) const
+{
+    FRoadPathSearchSnapshot Snapshot;
+    if (Graph.IsValid())
     {
-        if (!NearbySplines.Contains(Spline))
-        {
-            NearbySplines.Add(Spline);
-        }
+        Snapshot.Graph = Graph;
+        Snapshot.Landmarks = GetActiveLandmarks(*Graph) ? Landmarks : nullptr;
+        Snapshot.ContractionHierarchy = IsContractionHierarchyReady() ? ActiveContractionHierarchy : nullptr;
+        Snapshot.ClusterHierarchy = GetActiveClusterHierarchy(*Graph) ? ClusterHierarchy : nullptr;
+    }
+    return Snapshot;
+}
+
+const FRoadLandmarks* URoadPathfindingComponent::GetActiveLandmarks(const FRoadGraph& Graph) const
+{
+    return Landmarks.IsValid() && Landmarks->IsBuiltFor(Graph) ? Landmarks.Get() : nullptr;
+}
+
+const FRoadClusterHierarchy* URoadPathfindingComponent::GetActiveClusterHierarchy(const FRoadGraph& Graph) const
+{
+    return ClusterHierarchy.IsValid() && ClusterHierarchy->IsBuiltFor(Graph) ? ClusterHierarchy.Get() : nullptr;
+}
+
+FRoadPathSearchContext& URoadPathfindingComponent::GetSearchContext()
+{
+    return SearchContext;
+}
+
+int32 URoadPathfindingComponent::GetLastNumExpanded() const
+{
+    return SearchContext.NumExpanded;
+}
+
+void URoadPathfindingComponent::BuildContractionHierarchy(TSharedPtr<const FRoadGraph> Graph, bool bSaveToLevel)
+{
+    if (!bUseContractionHierarchy || !Graph.IsValid() || Graph->GetNumNodes() == 0)
+    {
+        ContractionHierarchyBuildId++;
+        PendingContractionHierarchyGraph.Reset();
+        ActiveContractionHierarchy.Reset();
+        ContractionHierarchy.Reset();
+        return;
+    }
+
+    // Only explicit bakes in the editor write the saved copy, edits and PIE or game worlds leave the level untouched
+#if WITH_EDITOR
+    const bool bSaveResult = bSaveToLevel && GetWorld() && GetWorld()->WorldType == EWorldType::Editor;
+#else
+    const bool bSaveResult = false;
+#endif
+
+    // A bake of the graph the active hierarchy was built for only has to store it
+    if (bSaveResult && IsContractionHierarchyReady() && ActiveContractionHierarchy->IsBuiltFor(*Graph))
+    {
+        SaveContractionHierarchy(*ActiveContractionHierarchy);
+        return;
     }
 
-    // Loop through all spline components
-    for (USplineComponent* Spline : NearbySplines)
+    ContractionHierarchyBuildId++;
+    PendingContractionHierarchyGraph.Reset();
+    ActiveContractionHierarchy.Reset();
+
+    // The checksum covers the topology and edge lengths, so a hierarchy loaded with the level is only reused for the same network.
+    // Outside the editor the level is never saved again, so the saved copy can be handed over instead of duplicated.
+    if (ContractionHierarchy.IsBuiltFor(*Graph))
     {
-        // Check if the spline contains both NodeA and NodeB
-        bool bContainsNodeA = false;
-        bool bContainsNodeB = false;
+#if WITH_EDITOR
+        ActiveContractionHierarchy = MakeShared<FRoadContractionHierarchy>(ContractionHierarchy);
+#else
+        ActiveContractionHierarchy = MakeShared<FRoadContractionHierarchy>(MoveTemp(ContractionHierarchy));
+#endif
+        UE_LOG(LogTemp, Log, TEXT("Using saved contraction hierarchy for %d nodes (%d shortcuts)."),
+            Graph->GetNumNodes(), ActiveContractionHierarchy->GetNumShortcuts());
+        return;
+    }
 
-        // Check the first and last points on the spline to compare with NodeA and NodeB locations
-        FVector SplineStartLocation = Spline->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World);
-        FVector SplineEndLocation = Spline->GetLocationAtSplinePoint(Spline->GetNumberOfSplinePoints() - 1, ESplineCoordinateSpace::World);
+    // A burst of edits would otherwise queue one full contraction per edit, only the last graph is worth building
+    if (bContractionHierarchyBuildRunning)
+    {
+        PendingContractionHierarchyGraph = Graph;
+        bSavePendingContractionHierarchy = bSaveResult;
+        return;
+    }
+
+    StartContractionHierarchyBuild(Graph, bSaveResult);
+}
 
-        // Use distance-based checks for precision issues
-        const float ToleranceDistance = 10.0f;
-        bContainsNodeA = FVector::Dist(SplineStartLocation, NodeA->Location) < ToleranceDistance || FVector::Dist(SplineEndLocation, NodeA->Location) < ToleranceDistance;
-        bContainsNodeB = FVector::Dist(SplineStartLocation, NodeB->Location) < ToleranceDistance || FVector::Dist(SplineEndLocation, NodeB->Location) < ToleranceDistance;
+void URoadPathfindingComponent::StartContractionHierarchyBuild(TSharedPtr<const FRoadGraph> Graph, bool bSaveResult)
+{
+    bContractionHierarchyBuildRunning = true;
+    const uint32 BuildId = ContractionHierarchyBuildId;
+    TWeakObjectPtr<URoadPathfindingComponent> WeakThis(this);
 
-        // If both nodes are found at the start or end points of the spline, return the spline component
-        if (bContainsNodeA && bContainsNodeB)
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Graph, BuildId, bSaveResult]()
         {
-            return Spline;
-        }
-    }
+            const double StartTime = FPlatformTime::Seconds();
+            TSharedRef<FRoadContractionHierarchy> NewHierarchy = MakeShared<FRoadContractionHierarchy>();
+            NewHierarchy->Build(*Graph);
+            const double BuildTime = FPlatformTime::Seconds() - StartTime;
+
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, NewHierarchy, BuildId, BuildTime, bSaveResult, NumNodes = Graph->GetNumNodes()]()
+                {
+                    URoadPathfindingComponent* Component = WeakThis.Get();
+                    if (!Component)
+                    {
+                        return;
+                    }
+
+                    Component->bContractionHierarchyBuildRunning = false;
+                    if (Component->ContractionHierarchyBuildId == BuildId)
+                    {
+                        Component->ActiveContractionHierarchy = NewHierarchy;
+                        if (bSaveResult)
+                        {
+                            Component->SaveContractionHierarchy(*NewHierarchy);
+                        }
+
+                        UE_LOG(LogTemp, Log, TEXT("Built contraction hierarchy for %d nodes with %d shortcuts in %.2f ms (%.2f MB)."),
+                            NumNodes, NewHierarchy->GetNumShortcuts(), BuildTime * 1000.0, NewHierarchy->GetAllocatedSize() / (1024.0 * 1024.0));
+                    }
+
+                    if (const TSharedPtr<const FRoadGraph> PendingGraph = Component->PendingContractionHierarchyGraph.Pin())
+                    {
+                        Component->PendingContractionHierarchyGraph.Reset();
+                        Component->StartContractionHierarchyBuild(PendingGraph, Component->bSavePendingContractionHierarchy);
+                    }
+                });
+        });
+}
 
-    // If no spline contains both nodes, return nullptr
-    return nullptr;
+bool URoadPathfindingComponent::IsContractionHierarchyReady() const
+{
+    return bUseContractionHierarchy && ActiveContractionHierarchy.IsValid();
+}
+
+void URoadPathfindingComponent::SaveContractionHierarchy(const FRoadContractionHierarchy& Hierarchy)
+{
+    ContractionHierarchy = Hierarchy;
+    MarkPackageDirty();
+
+    UE_LOG(LogTemp, Log, TEXT("Saved contraction hierarchy with %d shortcuts to the level."), Hierarchy.GetNumShortcuts());
+}
+
+TSharedPtr<const FRoadFlowField> URoadPathfindingComponent::GetFlowField(const TSharedPtr<const FRoadGraph>& Graph, int32 GoalNodeId)
+{
+    FlowFieldCache.SetCapacity(FlowFieldCacheSize);
+    return FlowFieldCache.FindOrBuild(Graph, GoalNodeId);
 }
 
 void URoadPathfindingComponent::FindSplinesInArea(const FVector& Location, float SearchRadius, TArray<USplineComponent*>& OutSplines) const
 {
     ARoadActor* RoadActor = Cast<ARoadActor>(GetOwner());
-    if (!RoadActor || !RoadActor->SplineQuadtree.IsValid())
+    if (!RoadActor || !RoadActor->SplineSpatialIndex.IsValid())
     {
         return;
     }
@@ -266,7 +580,10 @@ void URoadPathfindingComponent::FindSplinesInArea(const FVector& Location, float
         FVector2D(Location.X + SearchRadius, Location.Y + SearchRadius)
     );
 
-    RoadActor->SplineQuadtree->QuerySplinesInArea(SearchArea, OutSplines);
+    // Limit the search vertically so bridges and ramps above or below the location are pruned
+    const FSplineZRange SearchZRange(Location.Z - VerticalSearchRadius, Location.Z + VerticalSearchRadius);
+
+    RoadActor->SplineSpatialIndex->QuerySplinesInArea(SearchArea, OutSplines, SearchZRange);
 
     bool DrawDebug = false;
     if (DrawDebug)
@@ -278,36 +595,86 @@ void URoadPathfindingComponent::FindSplinesInArea(const FVector& Location, float
     }
 }
 
-USplineComponent* URoadPathfindingComponent::FindNearestSplineComponent(const FVector& Location)
+USplineComponent* URoadPathfindingComponent::FindNearestSplineComponent(const FVector& Location, double MaxDistance)
 {
-    TArray<USplineComponent*> NearbySplines;
+    return FindNearestSplineHit(Location, MaxDistance).SplineComponent;
+}
+
+FSplineSegmentHit URoadPathfindingComponent::FindNearestSplineHit(const FVector& Location, double MaxDistance) const
+{
+    FSplineSegmentHit Hit;
 
-    FindSplinesInArea(Location, DefaultSearchRadius, NearbySplines);
+    ARoadActor* RoadActor = Cast<ARoadActor>(GetOwner());
+    if (!RoadActor)
+    {
+        return Hit;
+    }
 
-    USplineComponent* NearestSpline = nullptr;
-    float MinDistance = FLT_MAX;
+    UpdateDirtySpatialData();
 
-    // Loop through all spline components to find the nearest
-    for (USplineComponent* Spline : NearbySplines)
+    // The baked raster answers most lookups. Locations outside it, far from roads, or on another level
+    // than the baked road (bridges, ramps) fall through to the full BVH search.
+    if (RoadActor->NearestRoadRaster.IsValid() && RoadActor->SplineSegmentBVH.IsValid())
     {
-        if (Spline)
+        const double MaxDistanceSquared = MaxDistance < TNumericLimits<double>::Max() ? FMath::Square(MaxDistance) : TNumericLimits<double>::Max();
+        if (RoadActor->NearestRoadRaster->FindNearestPoint(*RoadActor->SplineSegmentBVH, Location, Hit)
+            && Hit.DistanceSquared <= MaxDistanceSquared
+            && FMath::Abs(Hit.Location.Z - Location.Z) <= VerticalSearchRadius)
+        {
+            return Hit;
+        }
+    }
+
+    if (RoadActor->SplineSegmentBVH.IsValid())
+    {
+        RoadActor->SplineSegmentBVH->FindNearestPoint(Location, Hit, MaxDistance);
+        return Hit;
+    }
+
+    // Fallback when the segment BVH has not been built yet: best-first search on the quadtree,
+    // refining each candidate with the exact closest point only when it can still win
+    if (!RoadActor->SplineSpatialIndex.IsValid())
+    {
+        return Hit;
+    }
+
+    auto ExactDistanceSquared = [&Location](USplineComponent* Spline)
         {
             // Find the closest location on the spline to the input location
             FVector ClosestPointOnSpline = Spline->FindLocationClosestToWorldLocation(Location, ESplineCoordinateSpace::World);
+            return FVector::DistSquared(Location, ClosestPointOnSpline);
+        };
 
-            // Calculate the distance between the given location and the closest point on the spline
-            float Distance = FVector::Dist(Location, ClosestPointOnSpline);
+    USplineComponent* NearestSpline = RoadActor->SplineSpatialIndex->FindNearestSplineWithin(FVector2D(Location.X, Location.Y), MaxDistance, ExactDistanceSquared);
+    if (NearestSpline)
+    {
+        Hit.SplineComponent = NearestSpline;
+        Hit.InputKey = NearestSpline->FindInputKeyClosestToWorldLocation(Location);
+        Hit.Location = NearestSpline->GetLocationAtSplineInputKey(Hit.InputKey, ESplineCoordinateSpace::World);
+        Hit.DistanceSquared = FVector::DistSquared(Location, Hit.Location);
+    }
 
-            // Track the nearest spline component
-            if (Distance < MinDistance)
-            {
-                MinDistance = Distance;
-                NearestSpline = Spline;
-            }
-        }
+    return Hit;
+}
+
+void URoadPathfindingComponent::UpdateDirtySpatialData() const
+{
+    ARoadActor* RoadActor = Cast<ARoadActor>(GetOwner());
+    if (!RoadActor || !RoadActor->SplineSegmentBVH.IsValid())
+    {
+        return;
     }
 
-    return NearestSpline;
+    // The raster re-bakes from the BVH samples, which are current even while the tree itself is dirty
+    if (RoadActor->NearestRoadRaster.IsValid() && RoadActor->NearestRoadRaster->IsDirty())
+    {
+        RoadActor->NearestRoadRaster->Update(*RoadActor->SplineSegmentBVH);
+    }
+
+    if (RoadActor->SplineSegmentBVH->IsDirty())
+    {
+        RoadActor->SplineSegmentBVH->Rebuild();
+    }
 }
 
 void URoadPathfindingComponent::DrawSplineAndBoxDebug(const TArray<USplineComponent*>& SplineComponents, const FVector BoxCenter, const FVector BoxExtent) const
@@ -379,12 +746,12 @@ bool URoadPathfindingComponent::AreSplineConnected(USplineComponent* SplineA, US
 void URoadPathfindingComponent::FindSplinesInLineArea(const FVector& LineStart, const FVector& LineEnd, TArray<USplineComponent*>& OutSplines) const
 {
     ARoadActor* RoadActor = Cast<ARoadActor>(GetOwner());
-    if (!RoadActor || !RoadActor->SplineQuadtree.IsValid())
+    if (!RoadActor || !RoadActor->SplineSpatialIndex.IsValid())
     {
         return;
     }
 
-    // Define the search area as an axis-aligned bounding box (AABB) around the line
+    // Axis-aligned bounds of the searched capsule, only used for debug drawing
     FBox2D LineBoundingBox(
         FVector2D(FMath::Min(LineStart.X, LineEnd.X) - DefaultSearchRadius, FMath::Min(LineStart.Y, LineEnd.Y) - DefaultSearchRadius),
         FVector2D(FMath::Max(LineStart.X, LineEnd.X) + DefaultSearchRadius, FMath::Max(LineStart.Y, LineEnd.Y) + DefaultSearchRadius)
@@ -402,11 +769,23 @@ void URoadPathfindingComponent::FindSplinesInLineArea(const FVector& LineStart,
         500.0f
     );
 
-    RoadActor->SplineQuadtree->QuerySplinesInArea(LineBoundingBox, OutSplines);
+    // Search a capsule around the line so long diagonal lines don't cover the empty corners of their bounds
+    RoadActor->SplineSpatialIndex->QuerySplinesInCapsule(FVector2D(LineStart), FVector2D(LineEnd), DefaultSearchRadius, OutSplines);
 
     bool DrawDebug = false;
     if (DrawDebug)
     {
         DrawSplineAndBoxDebug(OutSplines, BoxCenter, BoxExtent);
     }
+}
+
+bool URoadPathfindingComponent::VisitSplinesAlongLine(const FVector& LineStart, const FVector& LineEnd, float Radius, FSplineVisitorFunction Visitor) const
+{
+    ARoadActor* RoadActor = Cast<ARoadActor>(GetOwner());
+    if (!RoadActor || !RoadActor->SplineSpatialIndex.IsValid())
+    {
+        return true;
+    }
+
+    return RoadActor->SplineSpatialIndex->VisitSplinesInCapsule(FVector2D(LineStart), FVector2D(LineEnd), Radius, Visitor);
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "RoadSplineLanes.h"
+
+// ---------- Building ---------
+void FRoadSplineLanes::Build(const USplineComponent* SplineComponent, TConstArrayView<float> LaneOffsets, float InSampleSpacing)
+{
+    SampleSpacing = FMath::Max(InSampleSpacing, 1.0f);
+    KeyDistances.Reset();
+    SampleDistances.Reset();
+    CenterPoints.Reset();
+    LanePoints.Reset();
+    LanePoints.SetNum(LaneOffsets.Num() * 2);
+
+    const int32 NumPoints = SplineComponent ? SplineComponent->GetNumberOfSplinePoints() : 0;
+    if (NumPoints == 0)
+    {
+        return;
+    }
+
+    const int32 NumKeySteps = (NumPoints - 1) * KeyStepsPerSegment;
+    KeyDistances.Reserve(NumKeySteps + 1);
+    for (int32 KeyStep = 0; KeyStep < NumKeySteps; KeyStep++)
+    {
+        KeyDistances.Add(SplineComponent->GetDistanceAlongSplineAtSplineInputKey(static_cast<float>(KeyStep) / KeyStepsPerSegment));
+    }
+    KeyDistances.Add(SplineComponent->GetDistanceAlongSplineAtSplinePoint(NumPoints - 1));
+
+    const float Length = KeyDistances.Last();
+    for (float Distance = 0.0f; Distance < Length; Distance += SampleSpacing)
+    {
+        SampleDistances.Add(Distance);
+    }
+    SampleDistances.Add(Length);
+
+    CenterPoints.Reserve(SampleDistances.Num());
+    for (TArray<FVector>& Points : LanePoints)
+    {
+        Points.Reserve(SampleDistances.Num());
+    }
+
+    for (const float Distance : SampleDistances)
+    {
+        const FVector Center = SplineComponent->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+        const FVector Direction = SplineComponent->GetDirectionAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+        const FVector RightVector = FVector::CrossProduct(FVector::UpVector, Direction).GetSafeNormal();
+
+        CenterPoints.Add(Center);
+        for (int32 Lane = 0; Lane < LaneOffsets.Num(); Lane++)
+        {
+            LanePoints[Lane * 2].Add(Center + RightVector * LaneOffsets[Lane]);
+            LanePoints[Lane * 2 + 1].Add(Center - RightVector * LaneOffsets[Lane]);
+        }
+    }
+}
+
+// ---------- Public Methods ---------
+int32 FRoadSplineLanes::GetNumLanes() const
+{
+    return LanePoints.Num() / 2;
+}
+
+int32 FRoadSplineLanes::GetNumSamples() const
+{
+    return SampleDistances.Num();
+}
+
+SIZE_T FRoadSplineLanes::GetAllocatedSize() const
+{
+    SIZE_T Size = KeyDistances.GetAllocatedSize() + SampleDistances.GetAllocatedSize() + CenterPoints.GetAllocatedSize() + LanePoints.GetAllocatedSize();
+    for (const TArray<FVector>& Points : LanePoints)
+    {
+        Size += Points.GetAllocatedSize();
+    }
+    return Size;
+}
+
+void FRoadSplineLanes::AppendPoints(float StartKey, float EndKey, int32 Lane, TArray<FVector>& OutPoints) const
+{
+    if (CenterPoints.Num() == 0)
+    {
+        return;
+    }
+
+    const float StartDistance = GetDistanceAtKey(StartKey);
+    const float EndDistance = GetDistanceAtKey(EndKey);
+    const bool bReverse = EndDistance < StartDistance;
+    const TArray<FVector>& Points = LanePoints.IsValidIndex(Lane * 2) ? LanePoints[Lane * 2 + (bReverse ? 1 : 0)] : CenterPoints;
+
+    auto AddPoint = [&OutPoints](const FVector& Point)
+        {
+            if (OutPoints.Num() == 0 || !OutPoints.Last().Equals(Point, UE_KINDA_SMALL_NUMBER))
+            {
+                OutPoints.Add(Point);
+            }
+        };
+
+    // The samples strictly between the two ends are copied as they are
+    AddPoint(GetPointAtDistance(Points, StartDistance));
+    if (!bReverse)
+    {
+        for (int32 SampleIndex = FMath::FloorToInt32(StartDistance / SampleSpacing) + 1; SampleIndex < SampleDistances.Num() && SampleDistances[SampleIndex] < EndDistance; SampleIndex++)
+        {
+            AddPoint(Points[SampleIndex]);
+        }
+    }
+    else
+    {
+        for (int32 SampleIndex = FMath::Min(FMath::CeilToInt32(StartDistance / SampleSpacing), SampleDistances.Num()) - 1; SampleIndex >= 0 && SampleDistances[SampleIndex] > EndDistance; SampleIndex--)
+        {
+            AddPoint(Points[SampleIndex]);
+        }
+    }
+    AddPoint(GetPointAtDistance(Points, EndDistance));
+}
+
+// ---------- Private Methods ---------
+float FRoadSplineLanes::GetDistanceAtKey(float InputKey) const
+{
+    const int32 LastStep = KeyDistances.Num() - 1;
+    if (LastStep <= 0)
+    {
+        return 0.0f;
+    }
+
+    const float Step = FMath::Clamp(InputKey * KeyStepsPerSegment, 0.0f, static_cast<float>(LastStep));
+    const int32 StepIndex = FMath::Min(FMath::FloorToInt32(Step), LastStep - 1);
+    return FMath::Lerp(KeyDistances[StepIndex], KeyDistances[StepIndex + 1], Step - StepIndex);
+}
+
+FVector FRoadSplineLanes::GetPointAtDistance(const TArray<FVector>& Points, float Distance) const
+{
+    if (Points.Num() == 1)
+    {
+        return Points[0];
+    }
+
+    // Samples are evenly spaced up to the last one, which sits at the spline end
+    const int32 SampleIndex = FMath::Clamp(FMath::FloorToInt32(Distance / SampleSpacing), 0, Points.Num() - 2);
+    const float SegmentLength = SampleDistances[SampleIndex + 1] - SampleDistances[SampleIndex];
+    const float Alpha = SegmentLength > 0.0f ? FMath::Clamp((Distance - SampleDistances[SampleIndex]) / SegmentLength, 0.0f, 1.0f) : 0.0f;
+    return FMath::Lerp(Points[SampleIndex], Points[SampleIndex + 1], Alpha);
+}
@@ -0,0 +1,547 @@
+#include "SplineHashGrid.h"
+#include "SplineSpatialQueries.h"
+#include "Async/ParallelFor.h"
+
+using namespace SplineSpatialQueries;
+
+namespace
+{
+    // Cell coordinates are clamped so ring arithmetic around them can't overflow
+    constexpr double MaxCellCoord = static_cast<double>(1 << 29);
+}
+
+// ---------- Constructor ---------
+FSplineHashGrid::FSplineHashGrid(const FBox2D& WorldBounds, double InCellSize)
+    : CellSize(FMath::Max(InCellSize, 1.0)), InvCellSize(1.0 / FMath::Max(InCellSize, 1.0)), Bounds(WorldBounds),
+    OccupiedMin(MAX_int32, MAX_int32), OccupiedMax(MIN_int32, MIN_int32), QueryEpoch(0)
+{
+}
+
+// ---------- Public Methods ---------
+void FSplineHashGrid::InsertSplineComponent(USplineComponent* SplineComponent)
+{
+    if (!SplineComponent)
+    {
+        return;
+    }
+
+    if (SplineToEntry.Contains(SplineComponent))
+    {
+        UpdateSplineComponent(SplineComponent);
+        return;
+    }
+
+    const int32 EntryId = AllocateEntry(SplineComponent, CalcSplineBounds(SplineComponent));
+    AddEntryToCells(EntryId);
+}
+
+void FSplineHashGrid::BulkLoad(const TArray<USplineComponent*>& SplineComponents)
+{
+    Clear();
+
+    TArray<USplineComponent*> ValidSplines;
+    ValidSplines.Reserve(SplineComponents.Num());
+    for (USplineComponent* SplineComponent : SplineComponents)
+    {
+        if (SplineComponent && !SplineToEntry.Contains(SplineComponent))
+        {
+            SplineToEntry.Add(SplineComponent, ValidSplines.Add(SplineComponent));
+        }
+    }
+
+    // Bounds of every spline are independent, compute them on worker threads
+    const int32 NumEntries = ValidSplines.Num();
+    TArray<FBox> SplineBounds;
+    SplineBounds.SetNumUninitialized(NumEntries);
+    ParallelFor(NumEntries, [&](int32 EntryId)
+        {
+            SplineBounds[EntryId] = CalcSplineBounds(ValidSplines[EntryId]);
+        });
+
+    EntrySplines = MoveTemp(ValidSplines);
+    EntryBounds.SetNumUninitialized(NumEntries);
+    EntryZRanges.SetNumUninitialized(NumEntries);
+    EntryCells.SetNum(NumEntries);
+
+    for (int32 EntryId = 0; EntryId < NumEntries; EntryId++)
+    {
+        const FBox& Box = SplineBounds[EntryId];
+        EntryBounds[EntryId] = FBox2D(FVector2D(Box.Min.X, Box.Min.Y), FVector2D(Box.Max.X, Box.Max.Y));
+        EntryZRanges[EntryId] = FSplineZRange(Box.Min.Z, Box.Max.Z);
+        AddEntryToCells(EntryId);
+    }
+}
+
+void FSplineHashGrid::RemoveSplineComponent(USplineComponent* SplineComponent)
+{
+    const int32* EntryIdPtr = SplineToEntry.Find(SplineComponent);
+    if (!EntryIdPtr)
+    {
+        return;
+    }
+
+    const int32 EntryId = *EntryIdPtr;
+    SplineToEntry.Remove(SplineComponent);
+    RemoveEntryFromCells(EntryId);
+    ReleaseEntry(EntryId);
+}
+
+void FSplineHashGrid::UpdateSplineComponent(USplineComponent* SplineComponent)
+{
+    if (SplineComponent)
+    {
+        RemoveSplineComponent(SplineComponent);
+        InsertSplineComponent(SplineComponent);
+    }
+}
+
+void FSplineHashGrid::Clear()
+{
+    Cells.Reset();
+    FreeCells.Reset();
+    CoordToCell.Reset();
+    OccupiedMin = FIntPoint(MAX_int32, MAX_int32);
+    OccupiedMax = FIntPoint(MIN_int32, MIN_int32);
+
+    EntrySplines.Reset();
+    EntryBounds.Reset();
+    EntryZRanges.Reset();
+    EntryCells.Reset();
+    OversizedEntries.Reset();
+    FreeEntries.Reset();
+    SplineToEntry.Reset();
+    EntryQueryStamps.Reset();
+}
+
+void FSplineHashGrid::GetAllSplines(TArray<USplineComponent*>& OutSplines) const
+{
+    OutSplines.Reserve(OutSplines.Num() + SplineToEntry.Num());
+    for (const TPair<USplineComponent*, int32>& Pair : SplineToEntry)
+    {
+        OutSplines.Add(Pair.Key);
+    }
+}
+
+FBox2D FSplineHashGrid::GetBounds() const
+{
+    return Bounds;
+}
+
+int32 FSplineHashGrid::GrowToContain(const FBox2D& Area)
+{
+    // Cells are hashed, so the grid already covers any area and only the reported bounds change
+    Bounds += Area;
+    return 0;
+}
+
+int32 FSplineHashGrid::GetNumNodes() const
+{
+    return CoordToCell.Num();
+}
+
+ESplineSpatialIndexType FSplineHashGrid::GetType() const
+{
+    return ESplineSpatialIndexType::HashGrid;
+}
+
+double FSplineHashGrid::GetCellSize() const
+{
+    return CellSize;
+}
+
+bool FSplineHashGrid::VisitSplinesInArea(const FBox2D& Area, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange) const
+{
+    return VisitSplinesInShape(FBoxQueryShape{ Area }, ZRange, Visitor);
+}
+
+bool FSplineHashGrid::VisitSplinesInCircle(const FVector2D& Center, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange) const
+{
+    return VisitSplinesInShape(FCircleQueryShape{ Center, Radius * Radius }, ZRange, Visitor);
+}
+
+bool FSplineHashGrid::VisitSplinesInCapsule(const FVector2D& Start, const FVector2D& End, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange) const
+{
+    return VisitSplinesInShape(FCapsuleQueryShape(Start, End, Radius), ZRange, Visitor);
+}
+
+void FSplineHashGrid::FindNearestSplines(const FVector2D& Point, int32 K, double MaxDistance, TArray<USplineComponent*>& OutSplines, FSplineDistanceSquaredFunction DistanceSquaredFn) const
+{
+    if (K <= 0)
+    {
+        return;
+    }
+
+    const double MaxDistanceSquared = MaxDistance < TNumericLimits<double>::Max() ? FMath::Square(MaxDistance) : TNumericLimits<double>::Max();
+    const int32 NumFound = OutSplines.Num();
+    const uint32 Epoch = BeginQuery();
+
+    // Rings of cells around the query cell are keyed by the distance to the block they enclose, entries
+    // by the distance to their bounds and exact items by the refined distance, as in the quadtree search
+    TArray<FNearestQueueItem, TInlineAllocator<64>> Queue;
+
+    for (int32 EntryId : OversizedEntries)
+    {
+        const double DistanceSquared = BoxDistanceSquared(EntryBounds[EntryId], Point);
+        if (DistanceSquared <= MaxDistanceSquared)
+        {
+            Queue.HeapPush({ DistanceSquared, EntryId, FNearestQueueItem::EType::Entry });
+        }
+    }
+
+    const FIntPoint CenterCoord = GetCellCoord(Point);
+    int32 LastRing = INDEX_NONE;
+
+    // Lower bound of the distance to any cell of a ring, which lies outside the block of the previous ring
+    auto RingDistanceSquared = [&](int32 Ring)
+        {
+            if (Ring == 0)
+            {
+                return 0.0;
+            }
+
+            const double InnerMinX = static_cast<double>(CenterCoord.X - Ring + 1) * CellSize;
+            const double InnerMinY = static_cast<double>(CenterCoord.Y - Ring + 1) * CellSize;
+            const double InnerMaxX = static_cast<double>(CenterCoord.X + Ring) * CellSize;
+            const double InnerMaxY = static_cast<double>(CenterCoord.Y + Ring) * CellSize;
+            const double Distance = FMath::Min(
+                FMath::Min(Point.X - InnerMinX, InnerMaxX - Point.X),
+                FMath::Min(Point.Y - InnerMinY, InnerMaxY - Point.Y));
+            return FMath::Square(FMath::Max(Distance, 0.0));
+        };
+
+    if (HasOccupiedCells())
+    {
+        // Rings closer than the occupied range are empty, start at the first one that can hold cells
+        const int32 FirstRing = FMath::Max3(0,
+            FMath::Max(OccupiedMin.X - CenterCoord.X, CenterCoord.X - OccupiedMax.X),
+            FMath::Max(OccupiedMin.Y - CenterCoord.Y, CenterCoord.Y - OccupiedMax.Y));
+        LastRing = FMath::Max(
+            FMath::Max(CenterCoord.X - OccupiedMin.X, OccupiedMax.X - CenterCoord.X),
+            FMath::Max(CenterCoord.Y - OccupiedMin.Y, OccupiedMax.Y - CenterCoord.Y));
+
+        Queue.HeapPush({ RingDistanceSquared(FirstRing), FirstRing, FNearestQueueItem::EType::Node });
+    }
+
+    auto QueueCellEntries = [&](const FIntPoint& Coord)
+        {
+            const int32* CellIndex = CoordToCell.Find(Coord);
+            if (!CellIndex)
+            {
+                return;
+            }
+
+            for (int32 EntryId : Cells[*CellIndex].EntryIds)
+            {
+                // A spline covering several cells is queued only once
+                if (EntryQueryStamps[EntryId] == Epoch)
+                {
+                    continue;
+                }
+                EntryQueryStamps[EntryId] = Epoch;
+
+                const double DistanceSquared = BoxDistanceSquared(EntryBounds[EntryId], Point);
+                if (DistanceSquared <= MaxDistanceSquared)
+                {
+                    Queue.HeapPush({ DistanceSquared, EntryId, FNearestQueueItem::EType::Entry });
+                }
+            }
+        };
+
+    while (Queue.Num() > 0)
+    {
+        FNearestQueueItem Item;
+        Queue.HeapPop(Item, EAllowShrinking::No);
+
+        if (Item.DistanceSquared > MaxDistanceSquared)
+        {
+            break;
+        }
+
+        if (Item.Type == FNearestQueueItem::EType::Exact)
+        {
+            OutSplines.Add(EntrySplines[Item.Index]);
+            if (OutSplines.Num() - NumFound >= K)
+            {
+                break;
+            }
+        }
+        else if (Item.Type == FNearestQueueItem::EType::Entry)
+        {
+            const double ExactDistanceSquared = DistanceSquaredFn(EntrySplines[Item.Index]);
+            if (ExactDistanceSquared <= MaxDistanceSquared)
+            {
+                Queue.HeapPush({ FMath::Max(ExactDistanceSquared, Item.DistanceSquared), Item.Index, FNearestQueueItem::EType::Exact });
+            }
+        }
+        else
+        {
+            const int32 Ring = Item.Index;
+            const int32 MinX = CenterCoord.X - Ring;
+            const int32 MaxX = CenterCoord.X + Ring;
+            const int32 MinY = CenterCoord.Y - Ring;
+            const int32 MaxY = CenterCoord.Y + Ring;
+
+            // Top and bottom rows of the ring, then the columns between them, clipped to the occupied range
+            const int32 NumRows = Ring == 0 ? 1 : 2;
+            const int32 Rows[2] = { MinY, MaxY };
+            for (int32 RowIndex = 0; RowIndex < NumRows; RowIndex++)
+            {
+                const int32 Y = Rows[RowIndex];
+                if (Y < OccupiedMin.Y || Y > OccupiedMax.Y)
+                {
+                    continue;
+                }
+
+                for (int32 X = FMath::Max(MinX, OccupiedMin.X); X <= FMath::Min(MaxX, OccupiedMax.X); X++)
+                {
+                    QueueCellEntries(FIntPoint(X, Y));
+                }
+            }
+
+            const int32 Columns[2] = { MinX, MaxX };
+            for (int32 ColumnIndex = 0; ColumnIndex < NumRows; ColumnIndex++)
+            {
+                const int32 X = Columns[ColumnIndex];
+                if (Ring == 0 || X < OccupiedMin.X || X > OccupiedMax.X)
+                {
+                    continue;
+                }
+
+                for (int32 Y = FMath::Max(MinY + 1, OccupiedMin.Y); Y <= FMath::Min(MaxY - 1, OccupiedMax.Y); Y++)
+                {
+                    QueueCellEntries(FIntPoint(X, Y));
+                }
+            }
+
+            if (Ring < LastRing)
+            {
+                const double NextDistanceSquared = RingDistanceSquared(Ring + 1);
+                if (NextDistanceSquared <= MaxDistanceSquared)
+                {
+                    Queue.HeapPush({ NextDistanceSquared, Ring + 1, FNearestQueueItem::EType::Node });
+                }
+            }
+        }
+    }
+}
+
+// ---------- Private Methods ---------
+FIntPoint FSplineHashGrid::GetCellCoord(const FVector2D& Point) const
+{
+    return FIntPoint(
+        FMath::FloorToInt32(FMath::Clamp(Point.X * InvCellSize, -MaxCellCoord, MaxCellCoord)),
+        FMath::FloorToInt32(FMath::Clamp(Point.Y * InvCellSize, -MaxCellCoord, MaxCellCoord)));
+}
+
+FBox2D FSplineHashGrid::GetCellBounds(const FIntPoint& Coord) const
+{
+    const FVector2D Min(Coord.X * CellSize, Coord.Y * CellSize);
+    return FBox2D(Min, Min + FVector2D(CellSize));
+}
+
+bool FSplineHashGrid::HasOccupiedCells() const
+{
+    return OccupiedMin.X <= OccupiedMax.X;
+}
+
+int32 FSplineHashGrid::AllocateEntry(USplineComponent* SplineComponent, const FBox& SplineBounds)
+{
+    const FBox2D Bounds2D(FVector2D(SplineBounds.Min.X, SplineBounds.Min.Y), FVector2D(SplineBounds.Max.X, SplineBounds.Max.Y));
+    const FSplineZRange ZRange(SplineBounds.Min.Z, SplineBounds.Max.Z);
+
+    int32 EntryId;
+    if (FreeEntries.Num() > 0)
+    {
+        EntryId = FreeEntries.Pop(EAllowShrinking::No);
+        EntrySplines[EntryId] = SplineComponent;
+        EntryBounds[EntryId] = Bounds2D;
+        EntryZRanges[EntryId] = ZRange;
+    }
+    else
+    {
+        EntryId = EntrySplines.Add(SplineComponent);
+        EntryBounds.Add(Bounds2D);
+        EntryZRanges.Add(ZRange);
+        EntryCells.AddDefaulted();
+    }
+
+    SplineToEntry.Add(SplineComponent, EntryId);
+    return EntryId;
+}
+
+void FSplineHashGrid::ReleaseEntry(int32 EntryId)
+{
+    EntrySplines[EntryId] = nullptr;
+    EntryBounds[EntryId] = FBox2D(ForceInit);
+    EntryCells[EntryId].Reset();
+    FreeEntries.Add(EntryId);
+}
+
+void FSplineHashGrid::AddEntryToCells(int32 EntryId)
+{
+    const FIntPoint MinCoord = GetCellCoord(EntryBounds[EntryId].Min);
+    const FIntPoint MaxCoord = GetCellCoord(EntryBounds[EntryId].Max);
+
+    const int64 NumCoveredCells = static_cast<int64>(MaxCoord.X - MinCoord.X + 1) * (MaxCoord.Y - MinCoord.Y + 1);
+    if (NumCoveredCells > MaxCellsPerEntry)
+    {
+        OversizedEntries.Add(EntryId);
+        return;
+    }
+
+    for (int32 Y = MinCoord.Y; Y <= MaxCoord.Y; Y++)
+    {
+        for (int32 X = MinCoord.X; X <= MaxCoord.X; X++)
+        {
+            const FIntPoint Coord(X, Y);
+
+            int32 CellIndex;
+            if (const int32* ExistingCell = CoordToCell.Find(Coord))
+            {
+                CellIndex = *ExistingCell;
+            }
+            else
+            {
+                CellIndex = FreeCells.Num() > 0 ? FreeCells.Pop(EAllowShrinking::No) : Cells.AddDefaulted();
+                Cells[CellIndex].Coord = Coord;
+                CoordToCell.Add(Coord, CellIndex);
+
+                OccupiedMin = OccupiedMin.ComponentMin(Coord);
+                OccupiedMax = OccupiedMax.ComponentMax(Coord);
+            }
+
+            Cells[CellIndex].EntryIds.Add(EntryId);
+            EntryCells[EntryId].Add(CellIndex);
+        }
+    }
+}
+
+void FSplineHashGrid::RemoveEntryFromCells(int32 EntryId)
+{
+    if (EntryCells[EntryId].Num() == 0)
+    {
+        OversizedEntries.RemoveSingleSwap(EntryId, EAllowShrinking::No);
+        return;
+    }
+
+    for (int32 CellIndex : EntryCells[EntryId])
+    {
+        FSplineHashGridCell& Cell = Cells[CellIndex];
+        Cell.EntryIds.RemoveSingleSwap(EntryId, EAllowShrinking::No);
+
+        // Release cells that became empty so queries don't visit them
+        if (Cell.EntryIds.Num() == 0)
+        {
+            CoordToCell.Remove(Cell.Coord);
+            FreeCells.Add(CellIndex);
+        }
+    }
+
+    EntryCells[EntryId].Reset();
+}
+
+uint32 FSplineHashGrid::BeginQuery() const
+{
+    if (EntryQueryStamps.Num() < EntrySplines.Num())
+    {
+        EntryQueryStamps.SetNumZeroed(EntrySplines.Num());
+    }
+
+    // Stamps only need clearing when the epoch wraps around
+    if (++QueryEpoch == 0)
+    {
+        FMemory::Memzero(EntryQueryStamps.GetData(), EntryQueryStamps.Num() * sizeof(uint32));
+        QueryEpoch = 1;
+    }
+
+    return QueryEpoch;
+}
+
+template <typename ShapeType>
+bool FSplineHashGrid::VisitSplinesInShape(const ShapeType& Shape, const FSplineZRange& ZRange, FSplineVisitorFunction Visitor) const
+{
+    const uint32 Epoch = BeginQuery();
+
+    // Returns false once the visitor asks to stop
+    auto VisitEntry = [&](int32 EntryId)
+        {
+            if (EntryQueryStamps[EntryId] == Epoch || !Shape.Intersects(EntryBounds[EntryId]))
+            {
+                return true;
+            }
+
+            EntryQueryStamps[EntryId] = Epoch;
+            if (!EntryZRanges[EntryId].Overlaps(ZRange))
+            {
+                return true;
+            }
+
+            return Visitor(EntrySplines[EntryId]);
+        };
+
+    auto VisitCell = [&](int32 CellIndex)
+        {
+            const FSplineHashGridCell& Cell = Cells[CellIndex];
+            if (!Shape.Intersects(GetCellBounds(Cell.Coord)))
+            {
+                return true;
+            }
+
+            for (int32 EntryId : Cell.EntryIds)
+            {
+                if (!VisitEntry(EntryId))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+    if (HasOccupiedCells())
+    {
+        const FBox2D ShapeBounds = Shape.GetBounds();
+        const FIntPoint MinCoord = GetCellCoord(ShapeBounds.Min).ComponentMax(OccupiedMin);
+        const FIntPoint MaxCoord = GetCellCoord(ShapeBounds.Max).ComponentMin(OccupiedMax);
+
+        if (MinCoord.X <= MaxCoord.X && MinCoord.Y <= MaxCoord.Y)
+        {
+            const int64 NumCoveredCells = static_cast<int64>(MaxCoord.X - MinCoord.X + 1) * (MaxCoord.Y - MinCoord.Y + 1);
+            if (NumCoveredCells > CoordToCell.Num())
+            {
+                // A query covering more coordinates than there are occupied cells walks the cells instead
+                for (const TPair<FIntPoint, int32>& Pair : CoordToCell)
+                {
+                    const FIntPoint& Coord = Pair.Key;
+                    if (Coord.X >= MinCoord.X && Coord.X <= MaxCoord.X && Coord.Y >= MinCoord.Y && Coord.Y <= MaxCoord.Y && !VisitCell(Pair.Value))
+                    {
+                        return false;
+                    }
+                }
+            }
+            else
+            {
+                for (int32 Y = MinCoord.Y; Y <= MaxCoord.Y; Y++)
+                {
+                    for (int32 X = MinCoord.X; X <= MaxCoord.X; X++)
+                    {
+                        const int32* CellIndex = CoordToCell.Find(FIntPoint(X, Y));
+                        if (CellIndex && !VisitCell(*CellIndex))
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (int32 EntryId : OversizedEntries)
+    {
+        if (!VisitEntry(EntryId))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,316 @@
+#include "SplineNearestRaster.h"
+#include "Async/ParallelFor.h"
+
+// ---------- Constructor ---------
+FSplineNearestRaster::FSplineNearestRaster(float InCellSize, float InMaxDistance)
+    : CellSize(FMath::Max(1.0f, InCellSize)), MaxDistance(FMath::Max(InCellSize, InMaxDistance)), Origin(FVector2D::ZeroVector),
+    NumCellsX(0), NumCellsY(0), DirtyArea(ForceInit)
+{
+}
+
+// ---------- Baking ---------
+void FSplineNearestRaster::Build(const FSplineSegmentBVH& SegmentBVH, const FBox2D& Area)
+{
+    Clear();
+
+    if (!Area.bIsValid)
+    {
+        return;
+    }
+
+    // Coarsen the cells until the raster fits the budget
+    const FVector2D AreaSize = Area.GetSize();
+    while (FMath::CeilToDouble(AreaSize.X / CellSize) * FMath::CeilToDouble(AreaSize.Y / CellSize) > MaxCells)
+    {
+        CellSize *= 2.0f;
+        UE_LOG(LogTemp, Warning, TEXT("Nearest road raster exceeds %d cells, increasing the cell size to %.0f."), MaxCells, CellSize);
+    }
+
+    Origin = Area.Min;
+    NumCellsX = FMath::Max(1, FMath::CeilToInt32(AreaSize.X / CellSize));
+    NumCellsY = FMath::Max(1, FMath::CeilToInt32(AreaSize.Y / CellSize));
+    CellSplineIds.Init(INDEX_NONE, NumCellsX * NumCellsY);
+    CellInputKeys.Init(0.0f, NumCellsX * NumCellsY);
+
+    SplineBounds.Init(FBox2D(ForceInit), SegmentBVH.GetNumSplineIds());
+    for (int32 SplineId = 0; SplineId < SplineBounds.Num(); SplineId++)
+    {
+        UpdateSplineBounds(SegmentBVH, SplineId);
+    }
+
+    BakeRegion(SegmentBVH, FIntRect(0, 0, NumCellsX, NumCellsY));
+}
+
+void FSplineNearestRaster::Clear()
+{
+    NumCellsX = 0;
+    NumCellsY = 0;
+    CellSplineIds.Reset();
+    CellInputKeys.Reset();
+    SplineBounds.Reset();
+    DirtySplineIds.Reset();
+    DirtyArea = FBox2D(ForceInit);
+}
+
+void FSplineNearestRaster::MarkSplineDirty(int32 SplineId)
+{
+    if (SplineId == INDEX_NONE)
+    {
+        return;
+    }
+
+    // The cells around the old shape have to be re-baked as well as those around the new one
+    if (SplineBounds.IsValidIndex(SplineId) && SplineBounds[SplineId].bIsValid)
+    {
+        DirtyArea += SplineBounds[SplineId];
+    }
+    DirtySplineIds.AddUnique(SplineId);
+}
+
+void FSplineNearestRaster::Update(const FSplineSegmentBVH& SegmentBVH)
+{
+    if (DirtySplineIds.Num() == 0)
+    {
+        return;
+    }
+
+    FBox2D Area = DirtyArea;
+    for (int32 SplineId : DirtySplineIds)
+    {
+        while (SplineBounds.Num() <= SplineId)
+        {
+            SplineBounds.Add(FBox2D(ForceInit));
+        }
+
+        UpdateSplineBounds(SegmentBVH, SplineId);
+        if (SplineBounds[SplineId].bIsValid)
+        {
+            Area += SplineBounds[SplineId];
+        }
+    }
+
+    DirtySplineIds.Reset();
+    DirtyArea = FBox2D(ForceInit);
+
+    if (!IsBuilt() || !Area.bIsValid)
+    {
+        return;
+    }
+
+    // Only cells within MaxDistance of the changed splines can change their nearest road
+    const FIntRect BakedCells = GetCellRect(Area.ExpandBy(MaxDistance));
+    if (BakedCells.Area() > 0)
+    {
+        BakeRegion(SegmentBVH, BakedCells);
+    }
+}
+
+bool FSplineNearestRaster::IsDirty() const
+{
+    return DirtySplineIds.Num() > 0;
+}
+
+// ---------- Queries ---------
+bool FSplineNearestRaster::FindNearestPoint(const FSplineSegmentBVH& SegmentBVH, const FVector& Location, FSplineSegmentHit& OutHit) const
+{
+    OutHit = FSplineSegmentHit();
+
+    const int32 CellX = FMath::FloorToInt32((Location.X - Origin.X) / CellSize);
+    const int32 CellY = FMath::FloorToInt32((Location.Y - Origin.Y) / CellSize);
+    if (CellX < 0 || CellY < 0 || CellX >= NumCellsX || CellY >= NumCellsY)
+    {
+        return false;
+    }
+
+    const int32 CellIndex = CellY * NumCellsX + CellX;
+    const int32 SplineId = CellSplineIds[CellIndex];
+    if (SplineId == INDEX_NONE)
+    {
+        return false;
+    }
+
+    // The baked key belongs to the cell center, the location can be up to half a cell diagonal away from it
+    return SegmentBVH.FindNearestPointOnSpline(SplineId, Location, CellInputKeys[CellIndex], 2.0 * CellSize, OutHit);
+}
+
+bool FSplineNearestRaster::IsBuilt() const
+{
+    return CellSplineIds.Num() > 0;
+}
+
+float FSplineNearestRaster::GetCellSize() const
+{
+    return CellSize;
+}
+
+FIntPoint FSplineNearestRaster::GetNumCells() const
+{
+    return FIntPoint(NumCellsX, NumCellsY);
+}
+
+FBox2D FSplineNearestRaster::GetBounds() const
+{
+    return FBox2D(Origin, Origin + FVector2D(FIntPoint(NumCellsX, NumCellsY)) * CellSize);
+}
+
+// ---------- Private Methods ---------
+void FSplineNearestRaster::UpdateSplineBounds(const FSplineSegmentBVH& SegmentBVH, int32 SplineId)
+{
+    FBox2D Bounds(ForceInit);
+    if (const FSplineSampleData* Data = SegmentBVH.GetSplineSamples(SplineId))
+    {
+        for (const FVector& Point : Data->Points)
+        {
+            Bounds += FVector2D(Point.X, Point.Y);
+        }
+    }
+    SplineBounds[SplineId] = Bounds;
+}
+
+void FSplineNearestRaster::BakeRegion(const FSplineSegmentBVH& SegmentBVH, const FIntRect& BakedCells)
+{
+    // Seeds further than MaxDistance from every baked cell can't win, so the transform runs on a margin around them
+    const int32 MarginCells = FMath::CeilToInt32(MaxDistance / CellSize) + 1;
+    const FIntRect Region(
+        FIntPoint(BakedCells.Min.X - MarginCells, BakedCells.Min.Y - MarginCells).ComponentMax(FIntPoint::ZeroValue),
+        FIntPoint(BakedCells.Max.X + MarginCells, BakedCells.Max.Y + MarginCells).ComponentMin(FIntPoint(NumCellsX, NumCellsY)));
+    const int32 Width = Region.Width();
+    const int32 Height = Region.Height();
+    const FVector2D RegionOrigin = Origin + FVector2D(Region.Min) * CellSize;
+    const FBox2D RegionArea(RegionOrigin, RegionOrigin + FVector2D(FIntPoint(Width, Height)) * CellSize);
+
+    // Gather the samples of the splines reaching into the region
+    TArray<FVector2D> SeedPoints;
+    TArray<int32> SeedSplineIds;
+    TArray<float> SeedKeys;
+    for (int32 SplineId = 0; SplineId < SplineBounds.Num(); SplineId++)
+    {
+        const FSplineSampleData* Data = SegmentBVH.GetSplineSamples(SplineId);
+        if (!Data || !SplineBounds[SplineId].bIsValid || !SplineBounds[SplineId].Intersect(RegionArea))
+        {
+            continue;
+        }
+
+        for (int32 i = 0; i < Data->Points.Num(); i++)
+        {
+            const FVector2D Point(Data->Points[i].X, Data->Points[i].Y);
+            if (RegionArea.IsInside(Point))
+            {
+                SeedPoints.Add(Point);
+                SeedSplineIds.Add(SplineId);
+                SeedKeys.Add(Data->Keys[i]);
+            }
+        }
+    }
+
+    auto CellCenter = [&RegionOrigin, this](int32 X, int32 Y)
+        {
+            return RegionOrigin + FVector2D(X + 0.5, Y + 0.5) * CellSize;
+        };
+
+    // Every cell holding samples starts out with the one nearest to its center
+    TArray<int32> Seeds;
+    Seeds.Init(INDEX_NONE, Width * Height);
+    for (int32 SeedIndex = 0; SeedIndex < SeedPoints.Num(); SeedIndex++)
+    {
+        const FVector2D LocalPoint = (SeedPoints[SeedIndex] - RegionOrigin) / CellSize;
+        const int32 X = FMath::Clamp(FMath::FloorToInt32(LocalPoint.X), 0, Width - 1);
+        const int32 Y = FMath::Clamp(FMath::FloorToInt32(LocalPoint.Y), 0, Height - 1);
+        const FVector2D Center = CellCenter(X, Y);
+
+        int32& Seed = Seeds[Y * Width + X];
+        if (Seed == INDEX_NONE || FVector2D::DistSquared(SeedPoints[SeedIndex], Center) < FVector2D::DistSquared(SeedPoints[Seed], Center))
+        {
+            Seed = SeedIndex;
+        }
+    }
+
+    // Jump flooding: every pass, each cell adopts the nearest seed of its eight neighbours at the step distance.
+    // Rows are independent within a pass, and a final pass at step 1 fixes most of the remaining errors.
+    TArray<int32> Steps;
+    for (int32 Step = static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(MarginCells))); Step >= 1; Step /= 2)
+    {
+        Steps.Add(Step);
+    }
+    Steps.Add(1);
+
+    TArray<int32> NextSeeds;
+    NextSeeds.SetNumUninitialized(Width * Height);
+    for (int32 Step : Steps)
+    {
+        ParallelFor(Height, [&](int32 Y)
+            {
+                for (int32 X = 0; X < Width; X++)
+                {
+                    const FVector2D Center = CellCenter(X, Y);
+                    int32 BestSeed = Seeds[Y * Width + X];
+                    double BestDistanceSquared = BestSeed != INDEX_NONE ? FVector2D::DistSquared(SeedPoints[BestSeed], Center) : TNumericLimits<double>::Max();
+
+                    for (int32 OffsetY = -Step; OffsetY <= Step; OffsetY += Step)
+                    {
+                        const int32 NeighbourY = Y + OffsetY;
+                        if (NeighbourY < 0 || NeighbourY >= Height)
+                        {
+                            continue;
+                        }
+
+                        for (int32 OffsetX = -Step; OffsetX <= Step; OffsetX += Step)
+                        {
+                            const int32 NeighbourX = X + OffsetX;
+                            if (NeighbourX < 0 || NeighbourX >= Width)
+                            {
+                                continue;
+                            }
+
+                            const int32 Seed = Seeds[NeighbourY * Width + NeighbourX];
+                            if (Seed != INDEX_NONE && Seed != BestSeed)
+                            {
+                                const double DistanceSquared = FVector2D::DistSquared(SeedPoints[Seed], Center);
+                                if (DistanceSquared < BestDistanceSquared)
+                                {
+                                    BestDistanceSquared = DistanceSquared;
+                                    BestSeed = Seed;
+                                }
+                            }
+                        }
+                    }
+
+                    NextSeeds[Y * Width + X] = BestSeed;
+                }
+            });
+
+        Swap(Seeds, NextSeeds);
+    }
+
+    // Write back only the requested cells, the margin was context
+    const double MaxDistanceSquared = FMath::Square(static_cast<double>(MaxDistance));
+    for (int32 Y = BakedCells.Min.Y; Y < BakedCells.Max.Y; Y++)
+    {
+        for (int32 X = BakedCells.Min.X; X < BakedCells.Max.X; X++)
+        {
+            const int32 LocalX = X - Region.Min.X;
+            const int32 LocalY = Y - Region.Min.Y;
+            const int32 Seed = Seeds[LocalY * Width + LocalX];
+            const int32 CellIndex = Y * NumCellsX + X;
+
+            if (Seed != INDEX_NONE && FVector2D::DistSquared(SeedPoints[Seed], CellCenter(LocalX, LocalY)) <= MaxDistanceSquared)
+            {
+                CellSplineIds[CellIndex] = SeedSplineIds[Seed];
+                CellInputKeys[CellIndex] = SeedKeys[Seed];
+            }
+            else
+            {
+                CellSplineIds[CellIndex] = INDEX_NONE;
+            }
+        }
+    }
+}
+
+FIntRect FSplineNearestRaster::GetCellRect(const FBox2D& Area) const
+{
+    const FIntPoint Min(FMath::FloorToInt32((Area.Min.X - Origin.X) / CellSize), FMath::FloorToInt32((Area.Min.Y - Origin.Y) / CellSize));
+    const FIntPoint Max(FMath::FloorToInt32((Area.Max.X - Origin.X) / CellSize) + 1, FMath::FloorToInt32((Area.Max.Y - Origin.Y) / CellSize) + 1);
+    const FIntPoint NumCells(NumCellsX, NumCellsY);
+
+    return FIntRect(Min.ComponentMax(FIntPoint::ZeroValue).ComponentMin(NumCells), Max.ComponentMax(FIntPoint::ZeroValue).ComponentMin(NumCells));
+}
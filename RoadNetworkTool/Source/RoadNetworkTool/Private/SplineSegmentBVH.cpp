@@ -0,0 +1,431 @@
+#include "SplineSegmentBVH.h"
+#include "Algo/BinarySearch.h"
+
+// ---------- Constructor ---------
+FSplineSegmentBVH::FSplineSegmentBVH(float InSampleSpacing, int32 InMaxSegmentsPerLeaf)
+    : SampleSpacing(FMath::Max(1.0f, InSampleSpacing)), MaxSegmentsPerLeaf(FMath::Max(1, InMaxSegmentsPerLeaf)), bDirty(false)
+{
+}
+
+// ---------- Spline management ---------
+void FSplineSegmentBVH::Build(const TArray<USplineComponent*>& SplineComponents)
+{
+    Splines.Reset();
+    FreeSplineIds.Reset();
+    SplineToId.Reset();
+
+    for (USplineComponent* SplineComponent : SplineComponents)
+    {
+        AddOrUpdateSpline(SplineComponent);
+    }
+
+    Rebuild();
+}
+
+void FSplineSegmentBVH::AddOrUpdateSpline(USplineComponent* SplineComponent)
+{
+    if (!SplineComponent)
+    {
+        return;
+    }
+
+    int32 SplineId;
+    if (const int32* ExistingId = SplineToId.Find(SplineComponent))
+    {
+        SplineId = *ExistingId;
+    }
+    else if (FreeSplineIds.Num() > 0)
+    {
+        SplineId = FreeSplineIds.Pop(EAllowShrinking::No);
+        SplineToId.Add(SplineComponent, SplineId);
+    }
+    else
+    {
+        SplineId = Splines.AddDefaulted();
+        SplineToId.Add(SplineComponent, SplineId);
+    }
+
+    FSplineSampleData& Data = Splines[SplineId];
+    Data.SplineComponent = SplineComponent;
+    SampleSpline(Data);
+
+    bDirty = true;
+}
+
+void FSplineSegmentBVH::RemoveSpline(USplineComponent* SplineComponent)
+{
+    int32 SplineId = INDEX_NONE;
+    if (SplineToId.RemoveAndCopyValue(SplineComponent, SplineId))
+    {
+        Splines[SplineId] = FSplineSampleData();
+        FreeSplineIds.Add(SplineId);
+        bDirty = true;
+    }
+}
+
+void FSplineSegmentBVH::Rebuild()
+{
+    SegmentStarts.Reset();
+    SegmentEnds.Reset();
+    SegmentSplineIds.Reset();
+    SegmentStartKeys.Reset();
+    SegmentEndKeys.Reset();
+    Nodes.Reset();
+    bDirty = false;
+
+    // Gather the segments of every sampled spline
+    TArray<FVector> Starts, Ends, Centroids;
+    TArray<int32> SplineIds;
+    TArray<float> StartKeys, EndKeys;
+
+    for (int32 SplineId = 0; SplineId < Splines.Num(); SplineId++)
+    {
+        const FSplineSampleData& Data = Splines[SplineId];
+        for (int32 i = 0; i + 1 < Data.Points.Num(); i++)
+        {
+            Starts.Add(Data.Points[i]);
+            Ends.Add(Data.Points[i + 1]);
+            Centroids.Add((Data.Points[i] + Data.Points[i + 1]) * 0.5);
+            SplineIds.Add(SplineId);
+            StartKeys.Add(Data.Keys[i]);
+            EndKeys.Add(Data.Keys[i + 1]);
+        }
+    }
+
+    const int32 NumSegments = Starts.Num();
+    if (NumSegments == 0)
+    {
+        return;
+    }
+
+    TArray<int32> Order;
+    Order.SetNumUninitialized(NumSegments);
+    for (int32 i = 0; i < NumSegments; i++)
+    {
+        Order[i] = i;
+    }
+
+    // Temporarily expose the unsorted segments so BuildRange can compute bounds
+    SegmentStarts = MoveTemp(Starts);
+    SegmentEnds = MoveTemp(Ends);
+    Nodes.Reserve(2 * NumSegments / MaxSegmentsPerLeaf + 1);
+    BuildRange(Order, Centroids, 0, NumSegments);
+
+    // Reorder the segments so every leaf references a contiguous range
+    TArray<FVector> SortedStarts, SortedEnds;
+    SortedStarts.SetNumUninitialized(NumSegments);
+    SortedEnds.SetNumUninitialized(NumSegments);
+    SegmentSplineIds.SetNumUninitialized(NumSegments);
+    SegmentStartKeys.SetNumUninitialized(NumSegments);
+    SegmentEndKeys.SetNumUninitialized(NumSegments);
+
+    for (int32 i = 0; i < NumSegments; i++)
+    {
+        const int32 Source = Order[i];
+        SortedStarts[i] = SegmentStarts[Source];
+        SortedEnds[i] = SegmentEnds[Source];
+        SegmentSplineIds[i] = SplineIds[Source];
+        SegmentStartKeys[i] = StartKeys[Source];
+        SegmentEndKeys[i] = EndKeys[Source];
+    }
+
+    SegmentStarts = MoveTemp(SortedStarts);
+    SegmentEnds = MoveTemp(SortedEnds);
+}
+
+bool FSplineSegmentBVH::IsDirty() const
+{
+    return bDirty;
+}
+
+// ---------- Queries ---------
+bool FSplineSegmentBVH::FindNearestPoint(const FVector& Location, FSplineSegmentHit& OutHit, double MaxDistance) const
+{
+    OutHit = FSplineSegmentHit();
+
+    if (Nodes.Num() == 0)
+    {
+        return false;
+    }
+
+    double BestDistanceSquared = MaxDistance < TNumericLimits<double>::Max() ? FMath::Square(MaxDistance) : TNumericLimits<double>::Max();
+    int32 BestSegment = INDEX_NONE;
+    double BestAlpha = 0.0;
+
+    TArray<int32, TInlineAllocator<64>> Stack;
+    Stack.Add(0);
+
+    while (Stack.Num() > 0)
+    {
+        const FSplineSegmentBVHNode& Node = Nodes[Stack.Pop(EAllowShrinking::No)];
+        if (Node.Bounds.ComputeSquaredDistanceToPoint(Location) > BestDistanceSquared)
+        {
+            continue;
+        }
+
+        if (Node.IsLeafNode())
+        {
+            const int32 End = Node.FirstIndex + Node.Count;
+            for (int32 i = Node.FirstIndex; i < End; i++)
+            {
+                const FVector Direction = SegmentEnds[i] - SegmentStarts[i];
+                const double LengthSquared = Direction.SizeSquared();
+                const double Alpha = LengthSquared > UE_SMALL_NUMBER
+                    ? FMath::Clamp(FVector::DotProduct(Location - SegmentStarts[i], Direction) / LengthSquared, 0.0, 1.0)
+                    : 0.0;
+
+                const double DistanceSquared = FVector::DistSquared(Location, SegmentStarts[i] + Direction * Alpha);
+                if (DistanceSquared < BestDistanceSquared)
+                {
+                    BestDistanceSquared = DistanceSquared;
+                    BestSegment = i;
+                    BestAlpha = Alpha;
+                }
+            }
+        }
+        else
+        {
+            // Visit the nearer child first so the bound tightens early
+            const int32 LeftChild = static_cast<int32>(&Node - Nodes.GetData()) + 1;
+            const int32 RightChild = Node.FirstIndex;
+            const double LeftDistance = Nodes[LeftChild].Bounds.ComputeSquaredDistanceToPoint(Location);
+            const double RightDistance = Nodes[RightChild].Bounds.ComputeSquaredDistanceToPoint(Location);
+
+            if (LeftDistance < RightDistance)
+            {
+                Stack.Add(RightChild);
+                Stack.Add(LeftChild);
+            }
+            else
+            {
+                Stack.Add(LeftChild);
+                Stack.Add(RightChild);
+            }
+        }
+    }
+
+    if (BestSegment == INDEX_NONE)
+    {
+        return false;
+    }
+
+    RefineHit(SegmentSplineIds[BestSegment], Location, SegmentStarts[BestSegment], SegmentEnds[BestSegment],
+        SegmentStartKeys[BestSegment], SegmentEndKeys[BestSegment], BestAlpha, BestDistanceSquared, OutHit);
+    return true;
+}
+
+bool FSplineSegmentBVH::FindNearestPointOnSpline(int32 SplineId, const FVector& Location, float NearInputKey, double SearchDistance, FSplineSegmentHit& OutHit) const
+{
+    OutHit = FSplineSegmentHit();
+
+    const FSplineSampleData* Data = GetSplineSamples(SplineId);
+    if (!Data || Data->Points.Num() < 2)
+    {
+        return false;
+    }
+
+    // Start from the sampled segment holding the key and widen by whole segments in both directions
+    const int32 NumSegments = Data->Points.Num() - 1;
+    const int32 CenterSegment = FMath::Clamp(Algo::UpperBound(Data->Keys, NearInputKey) - 1, 0, NumSegments - 1);
+    const int32 SegmentRadius = FMath::Max(1, FMath::CeilToInt32(SearchDistance / SampleSpacing));
+    const int32 FirstSegment = FMath::Max(0, CenterSegment - SegmentRadius);
+    const int32 LastSegment = FMath::Min(NumSegments - 1, CenterSegment + SegmentRadius);
+
+    double BestDistanceSquared = TNumericLimits<double>::Max();
+    int32 BestSegment = INDEX_NONE;
+    double BestAlpha = 0.0;
+
+    for (int32 i = FirstSegment; i <= LastSegment; i++)
+    {
+        const FVector Direction = Data->Points[i + 1] - Data->Points[i];
+        const double LengthSquared = Direction.SizeSquared();
+        const double Alpha = LengthSquared > UE_SMALL_NUMBER
+            ? FMath::Clamp(FVector::DotProduct(Location - Data->Points[i], Direction) / LengthSquared, 0.0, 1.0)
+            : 0.0;
+
+        const double DistanceSquared = FVector::DistSquared(Location, Data->Points[i] + Direction * Alpha);
+        if (DistanceSquared < BestDistanceSquared)
+        {
+            BestDistanceSquared = DistanceSquared;
+            BestSegment = i;
+            BestAlpha = Alpha;
+        }
+    }
+
+    RefineHit(SplineId, Location, Data->Points[BestSegment], Data->Points[BestSegment + 1],
+        Data->Keys[BestSegment], Data->Keys[BestSegment + 1], BestAlpha, BestDistanceSquared, OutHit);
+    return true;
+}
+
+USplineComponent* FSplineSegmentBVH::GetSplineComponent(int32 SplineId) const
+{
+    return Splines.IsValidIndex(SplineId) ? Splines[SplineId].SplineComponent : nullptr;
+}
+
+int32 FSplineSegmentBVH::GetSplineId(const USplineComponent* SplineComponent) const
+{
+    const int32* SplineId = SplineToId.Find(const_cast<USplineComponent*>(SplineComponent));
+    return SplineId ? *SplineId : INDEX_NONE;
+}
+
+int32 FSplineSegmentBVH::GetNumSegments() const
+{
+    return SegmentStarts.Num();
+}
+
+int32 FSplineSegmentBVH::GetNumSplineIds() const
+{
+    return Splines.Num();
+}
+
+const FSplineSampleData* FSplineSegmentBVH::GetSplineSamples(int32 SplineId) const
+{
+    return Splines.IsValidIndex(SplineId) ? &Splines[SplineId] : nullptr;
+}
+
+float FSplineSegmentBVH::GetSampleSpacing() const
+{
+    return SampleSpacing;
+}
+
+// ---------- Private Methods ---------
+void FSplineSegmentBVH::SampleSpline(FSplineSampleData& Data) const
+{
+    USplineComponent* SplineComponent = Data.SplineComponent;
+
+    Data.Position = SplineComponent->GetSplinePointsPosition();
+    Data.Transform = SplineComponent->GetComponentTransform();
+    Data.Points.Reset();
+    Data.Keys.Reset();
+
+    // Only the keys the road graph covers, from the first to the last point, so hits always map onto a graph edge.
+    // The closing segment of a loop is not part of any edge and is left out.
+    const int32 NumPoints = SplineComponent->GetNumberOfSplinePoints();
+    const int32 NumCurveSegments = NumPoints - 1;
+    if (NumCurveSegments < 1)
+    {
+        return;
+    }
+
+    // Subdivide each curve segment so no sampled segment is much longer than SampleSpacing
+    for (int32 PointIndex = 0; PointIndex < NumCurveSegments; PointIndex++)
+    {
+        const float SegmentStartDistance = SplineComponent->GetDistanceAlongSplineAtSplinePoint(PointIndex);
+        const float SegmentEndDistance = SplineComponent->GetDistanceAlongSplineAtSplinePoint(PointIndex + 1);
+        const int32 NumSteps = FMath::Max(1, FMath::CeilToInt((SegmentEndDistance - SegmentStartDistance) / SampleSpacing));
+
+        for (int32 Step = 0; Step < NumSteps; Step++)
+        {
+            const float Key = PointIndex + static_cast<float>(Step) / NumSteps;
+            Data.Points.Add(SplineComponent->GetLocationAtSplineInputKey(Key, ESplineCoordinateSpace::World));
+            Data.Keys.Add(Key);
+        }
+    }
+
+    Data.MaxInputKey = static_cast<float>(NumCurveSegments);
+    Data.Points.Add(SplineComponent->GetLocationAtSplineInputKey(Data.MaxInputKey, ESplineCoordinateSpace::World));
+    Data.Keys.Add(Data.MaxInputKey);
+}
+
+int32 FSplineSegmentBVH::BuildRange(TArray<int32>& Order, const TArray<FVector>& Centroids, int32 Begin, int32 End)
+{
+    const int32 NodeIndex = Nodes.AddDefaulted();
+
+    FBox Bounds(ForceInit);
+    FBox CentroidBounds(ForceInit);
+    for (int32 i = Begin; i < End; i++)
+    {
+        Bounds += SegmentStarts[Order[i]];
+        Bounds += SegmentEnds[Order[i]];
+        CentroidBounds += Centroids[Order[i]];
+    }
+    Nodes[NodeIndex].Bounds = Bounds;
+
+    const int32 Count = End - Begin;
+    if (Count <= MaxSegmentsPerLeaf)
+    {
+        Nodes[NodeIndex].FirstIndex = Begin;
+        Nodes[NodeIndex].Count = Count;
+        return NodeIndex;
+    }
+
+    // Median split along the widest axis of the segment centroids
+    const FVector Extent = CentroidBounds.GetSize();
+    const int32 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+    MakeArrayView(Order.GetData() + Begin, Count).Sort([&Centroids, Axis](int32 A, int32 B)
+        {
+            return Centroids[A][Axis] < Centroids[B][Axis];
+        });
+
+    const int32 Mid = Begin + Count / 2;
+    BuildRange(Order, Centroids, Begin, Mid);
+    const int32 RightChild = BuildRange(Order, Centroids, Mid, End);
+
+    Nodes[NodeIndex].FirstIndex = RightChild;
+    Nodes[NodeIndex].Count = 0;
+    return NodeIndex;
+}
+
+float FSplineSegmentBVH::RefineInputKey(const FSplineSampleData& Data, const FVector& Location, float MinKey, float MaxKey) const
+{
+    const FVector LocalLocation = Data.Transform.InverseTransformPosition(Location);
+
+    auto DistanceAtKey = [&Data, &LocalLocation](float Key)
+        {
+            return FVector::DistSquared(Data.Position.Eval(Key, FVector::ZeroVector), LocalLocation);
+        };
+
+    // Golden-section search, the bracket only spans the neighbourhood of one sampled segment
+    const float InvPhi = 0.618034f;
+    float A = MinKey;
+    float B = MaxKey;
+    float C = B - (B - A) * InvPhi;
+    float D = A + (B - A) * InvPhi;
+    double DistanceC = DistanceAtKey(C);
+    double DistanceD = DistanceAtKey(D);
+
+    for (int32 Iteration = 0; Iteration < 16; Iteration++)
+    {
+        if (DistanceC < DistanceD)
+        {
+            B = D;
+            D = C;
+            DistanceD = DistanceC;
+            C = B - (B - A) * InvPhi;
+            DistanceC = DistanceAtKey(C);
+        }
+        else
+        {
+            A = C;
+            C = D;
+            DistanceC = DistanceD;
+            D = A + (B - A) * InvPhi;
+            DistanceD = DistanceAtKey(D);
+        }
+    }
+
+    return (A + B) * 0.5f;
+}
+
+void FSplineSegmentBVH::RefineHit(int32 SplineId, const FVector& Location, const FVector& SegmentStart, const FVector& SegmentEnd, float StartKey, float EndKey,
+    double Alpha, double PolylineDistanceSquared, FSplineSegmentHit& OutHit) const
+{
+    // Refine on the cached curve around the winning segment to get the exact closest point
+    const FSplineSampleData& Data = Splines[SplineId];
+    const float HalfSpan = (EndKey - StartKey) * 0.5f;
+    const float InputKey = RefineInputKey(Data, Location, FMath::Max(0.0f, StartKey - HalfSpan), FMath::Min(Data.MaxInputKey, EndKey + HalfSpan));
+
+    OutHit.SplineComponent = Data.SplineComponent;
+    OutHit.SplineId = SplineId;
+    OutHit.InputKey = InputKey;
+    OutHit.Location = Data.Transform.TransformPosition(Data.Position.Eval(InputKey, FVector::ZeroVector));
+    OutHit.DistanceSquared = FVector::DistSquared(Location, OutHit.Location);
+
+    // The refined point can only be closer than the polyline unless the curve is degenerate
+    if (OutHit.DistanceSquared > PolylineDistanceSquared)
+    {
+        OutHit.InputKey = FMath::Lerp(StartKey, EndKey, static_cast<float>(Alpha));
+        OutHit.Location = FMath::Lerp(SegmentStart, SegmentEnd, Alpha);
+        OutHit.DistanceSquared = PolylineDistanceSquared;
+    }
+}
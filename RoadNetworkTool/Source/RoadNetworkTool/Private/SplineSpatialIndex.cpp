@@ -0,0 +1,223 @@
+#include "SplineSpatialIndex.h"
+#include "Quadtree.h"
+#include "SplineHashGrid.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Relative costs used by the backend selection, in units of one exact entry bounds test
+    constexpr double CellLookupCost = 2.0; // Hashing a cell coordinate and probing the map
+    constexpr double NodeVisitCost = 1.0; // Testing and pushing one quadtree node
+    constexpr double GridEntryTestCost = 1.0;
+    constexpr double QuadtreeEntryTestCost = 0.5; // Leaf entries go through the packed four-wide prefilter
+
+    constexpr int32 MaxSampledSplines = 4096;
+    constexpr int32 AutoMaxSplinesPerNode = 8; // Two packed blocks per leaf
+
+    // Expected number of entries near a query, given the density around roads (queries are issued on or near them)
+    double EstimateGridQueryCost(double CellSize, double QueryRadius, double LocalDensity, double MedianExtent)
+    {
+        const double CellsVisited = FMath::Square((2.0 * QueryRadius + CellSize) / CellSize);
+        const double EntriesPerCell = LocalDensity * FMath::Square(CellSize + MedianExtent);
+        return CellsVisited * (CellLookupCost + EntriesPerCell * GridEntryTestCost);
+    }
+
+    double EstimateQuadtreeQueryCost(double WorldSize, int32 MaxDepth, double QueryRadius, double LocalDensity, double MedianExtent)
+    {
+        // Leaves split until they hold about half of MaxSplinesPerNode, unless they reach the depth limit first
+        const double MinLeafSize = WorldSize / FMath::Pow(2.0, static_cast<double>(MaxDepth));
+        const double LeafSize = FMath::Max(FMath::Sqrt(AutoMaxSplinesPerNode * 0.5 / FMath::Max(LocalDensity, UE_DOUBLE_SMALL_NUMBER)), MinLeafSize);
+
+        const double LeavesVisited = FMath::Square((2.0 * QueryRadius + LeafSize) / LeafSize);
+        const double EntriesPerLeaf = LocalDensity * FMath::Square(LeafSize + MedianExtent);
+        const double LeafDepth = FMath::Max(FMath::Log2(WorldSize / LeafSize), 0.0);
+        const double NodesVisited = LeavesVisited * 4.0 / 3.0 + 4.0 * LeafDepth;
+
+        return NodesVisited * NodeVisitCost + LeavesVisited * EntriesPerLeaf * QuadtreeEntryTestCost;
+    }
+}
+
+FString FSplineSpatialIndexConfig::ToString() const
+{
+    if (Type == ESplineSpatialIndexType::HashGrid)
+    {
+        return FString::Printf(TEXT("HashGrid (CellSize %.0f, estimated query cost %.1f)"), CellSize, EstimatedQueryCost);
+    }
+
+    return FString::Printf(TEXT("Quadtree (MaxSplinesPerNode %d, MaxDepth %d, estimated query cost %.1f)"), MaxSplinesPerNode, MaxDepth, EstimatedQueryCost);
+}
+
+// ---------- Queries ---------
+void ISplineSpatialIndex::QuerySplinesInArea(const FBox2D& Area, TArray<USplineComponent*>& OutSplines, const FSplineZRange& ZRange) const
+{
+    VisitSplinesInArea(Area, [&OutSplines](USplineComponent* SplineComponent)
+        {
+            OutSplines.Add(SplineComponent);
+            return true;
+        }, ZRange);
+}
+
+void ISplineSpatialIndex::QuerySplinesInCircle(const FVector2D& Center, double Radius, TArray<USplineComponent*>& OutSplines, const FSplineZRange& ZRange) const
+{
+    VisitSplinesInCircle(Center, Radius, [&OutSplines](USplineComponent* SplineComponent)
+        {
+            OutSplines.Add(SplineComponent);
+            return true;
+        }, ZRange);
+}
+
+void ISplineSpatialIndex::QuerySplinesInCapsule(const FVector2D& Start, const FVector2D& End, double Radius, TArray<USplineComponent*>& OutSplines, const FSplineZRange& ZRange) const
+{
+    VisitSplinesInCapsule(Start, End, Radius, [&OutSplines](USplineComponent* SplineComponent)
+        {
+            OutSplines.Add(SplineComponent);
+            return true;
+        }, ZRange);
+}
+
+USplineComponent* ISplineSpatialIndex::FindNearestSpline(const FVector2D& Point, FSplineDistanceSquaredFunction DistanceSquaredFn) const
+{
+    return FindNearestSplineWithin(Point, TNumericLimits<double>::Max(), DistanceSquaredFn);
+}
+
+USplineComponent* ISplineSpatialIndex::FindNearestSplineWithin(const FVector2D& Point, double MaxDistance, FSplineDistanceSquaredFunction DistanceSquaredFn) const
+{
+    TArray<USplineComponent*, TInlineAllocator<1>> Result;
+    FindNearestSplines(Point, 1, MaxDistance, Result, DistanceSquaredFn);
+    return Result.Num() > 0 ? Result[0] : nullptr;
+}
+
+void ISplineSpatialIndex::FindKNearestSplines(const FVector2D& Point, int32 K, TArray<USplineComponent*>& OutSplines, FSplineDistanceSquaredFunction DistanceSquaredFn) const
+{
+    FindNearestSplines(Point, K, TNumericLimits<double>::Max(), OutSplines, DistanceSquaredFn);
+}
+
+// ---------- Static Helpers ---------
+FBox ISplineSpatialIndex::CalcSplineBounds(const USplineComponent* SplineComponent)
+{
+    // Calculate the bounds of the spline in world space
+    return SplineComponent->CalcBounds(SplineComponent->GetComponentTransform()).GetBox();
+}
+
+FBox2D ISplineSpatialIndex::CalcSplineBounds2D(const USplineComponent* SplineComponent)
+{
+    const FBox SplineBox = CalcSplineBounds(SplineComponent);
+
+    return FBox2D(FVector2D(SplineBox.Min.X, SplineBox.Min.Y), FVector2D(SplineBox.Max.X, SplineBox.Max.Y));
+}
+
+FSplineSpatialIndexConfig ISplineSpatialIndex::ChooseConfig(const TArray<USplineComponent*>& SplineComponents, double QueryRadius)
+{
+    FSplineSpatialIndexConfig Config;
+    Config.MaxSplinesPerNode = AutoMaxSplinesPerNode;
+
+    TArray<USplineComponent*> ValidSplines;
+    ValidSplines.Reserve(SplineComponents.Num());
+    for (USplineComponent* SplineComponent : SplineComponents)
+    {
+        if (SplineComponent)
+        {
+            ValidSplines.Add(SplineComponent);
+        }
+    }
+
+    const int32 NumSplines = ValidSplines.Num();
+    if (NumSplines == 0)
+    {
+        return Config;
+    }
+
+    // Sample an evenly strided subset, large networks don't need every spline to estimate the distribution
+    const int32 Stride = FMath::Max(1, NumSplines / MaxSampledSplines);
+    const int32 NumSamples = (NumSplines + Stride - 1) / Stride;
+    const double SampleScale = static_cast<double>(NumSplines) / NumSamples;
+
+    TArray<FBox2D> SampleBounds;
+    SampleBounds.SetNumUninitialized(NumSamples);
+    ParallelFor(NumSamples, [&](int32 SampleIndex)
+        {
+            SampleBounds[SampleIndex] = CalcSplineBounds2D(ValidSplines[SampleIndex * Stride]);
+        });
+
+    FBox2D WorldBounds(ForceInit);
+    TArray<double> Extents;
+    Extents.Reserve(NumSamples);
+    for (const FBox2D& Bounds : SampleBounds)
+    {
+        WorldBounds += Bounds;
+        Extents.Add(Bounds.GetSize().GetMax());
+    }
+    Extents.Sort();
+
+    const double MedianExtent = FMath::Max(Extents[NumSamples / 2], 1.0);
+    const double WorldSize = FMath::Max(WorldBounds.GetSize().GetMax(), MedianExtent);
+
+    // Density around the roads themselves: bin the sample centers and weight each bin by its own count,
+    // so clustered networks report the crowded areas queries actually land in rather than the average
+    const double BinSize = FMath::Max(MedianExtent, WorldSize / 256.0);
+    TMap<FIntPoint, int32> BinCounts;
+    for (const FBox2D& Bounds : SampleBounds)
+    {
+        const FVector2D Center = (Bounds.GetCenter() - WorldBounds.Min) / BinSize;
+        BinCounts.FindOrAdd(FIntPoint(FMath::FloorToInt32(Center.X), FMath::FloorToInt32(Center.Y)))++;
+    }
+
+    double SumCounts = 0.0;
+    double SumSquaredCounts = 0.0;
+    for (const TPair<FIntPoint, int32>& Pair : BinCounts)
+    {
+        SumCounts += Pair.Value;
+        SumSquaredCounts += FMath::Square(static_cast<double>(Pair.Value));
+    }
+    const double LocalDensity = (SumSquaredCounts / SumCounts) * SampleScale / FMath::Square(BinSize);
+
+    // Deeper leaves than a typical spline only duplicate entries across more leaves
+    Config.MaxDepth = FMath::Clamp(FMath::CeilToInt32(FMath::Log2(WorldSize / MedianExtent)), 1, 16);
+    const double QuadtreeCost = EstimateQuadtreeQueryCost(WorldSize, Config.MaxDepth, QueryRadius, LocalDensity, MedianExtent);
+
+    double BestCellSize = MedianExtent;
+    double BestGridCost = TNumericLimits<double>::Max();
+    const double CandidateCellSizes[] = { MedianExtent, 2.0 * MedianExtent, 4.0 * MedianExtent, 8.0 * MedianExtent, 0.5 * QueryRadius, QueryRadius };
+    for (double CandidateCellSize : CandidateCellSizes)
+    {
+        if (CandidateCellSize < 1.0)
+        {
+            continue;
+        }
+
+        const double Cost = EstimateGridQueryCost(CandidateCellSize, QueryRadius, LocalDensity, MedianExtent);
+        if (Cost < BestGridCost)
+        {
+            BestGridCost = Cost;
+            BestCellSize = CandidateCellSize;
+        }
+    }
+
+    // The quadtree adapts to uneven density, so the grid has to be clearly cheaper to be picked
+    if (BestGridCost < QuadtreeCost * 0.9)
+    {
+        Config.Type = ESplineSpatialIndexType::HashGrid;
+        Config.CellSize = BestCellSize;
+        Config.EstimatedQueryCost = BestGridCost;
+    }
+    else
+    {
+        Config.Type = ESplineSpatialIndexType::Quadtree;
+        Config.EstimatedQueryCost = QuadtreeCost;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Spatial index statistics: %d splines (%d sampled), median extent %.0f, world size %.0f, local density %.3g per square unit. Quadtree cost %.1f, grid cost %.1f."),
+        NumSplines, NumSamples, MedianExtent, WorldSize, LocalDensity, QuadtreeCost, BestGridCost);
+
+    return Config;
+}
+
+TSharedPtr<ISplineSpatialIndex> ISplineSpatialIndex::Create(const FSplineSpatialIndexConfig& Config, const FBox2D& WorldBounds)
+{
+    if (Config.Type == ESplineSpatialIndexType::HashGrid)
+    {
+        return MakeShared<FSplineHashGrid>(WorldBounds, Config.CellSize);
+    }
+
+    return MakeShared<FQuadtree>(WorldBounds, Config.MaxSplinesPerNode, Config.MaxDepth);
+}
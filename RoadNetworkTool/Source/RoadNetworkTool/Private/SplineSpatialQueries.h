@@ -0,0 +1,152 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace SplineSpatialQueries
+{
+    inline double BoxDistanceSquared(const FBox2D& Box, const FVector2D& Point)
+    {
+        const double DX = FMath::Max3(Box.Min.X - Point.X, 0.0, Point.X - Box.Max.X);
+        const double DY = FMath::Max3(Box.Min.Y - Point.Y, 0.0, Point.Y - Box.Max.Y);
+        return DX * DX + DY * DY;
+    }
+
+    // Exact 2D segment against box test, using the slab method with inclusive bounds
+    inline bool SegmentIntersectsBox(const FVector2D& Start, const FVector2D& End, const FBox2D& Box)
+    {
+        const FVector2D Direction = End - Start;
+        double TMin = 0.0;
+        double TMax = 1.0;
+
+        for (int32 Axis = 0; Axis < 2; Axis++)
+        {
+            if (FMath::Abs(Direction[Axis]) < UE_SMALL_NUMBER)
+            {
+                if (Start[Axis] < Box.Min[Axis] || Start[Axis] > Box.Max[Axis])
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            const double InvDirection = 1.0 / Direction[Axis];
+            double T0 = (Box.Min[Axis] - Start[Axis]) * InvDirection;
+            double T1 = (Box.Max[Axis] - Start[Axis]) * InvDirection;
+            if (T0 > T1)
+            {
+                Swap(T0, T1);
+            }
+
+            TMin = FMath::Max(TMin, T0);
+            TMax = FMath::Min(TMax, T1);
+            if (TMin > TMax)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Query shapes shared by the spatial indices, each tests a node, cell or entry box exactly
+    // and provides its own bounds for coarse culling
+    struct FBoxQueryShape
+    {
+        FBox2D Area;
+
+        bool Intersects(const FBox2D& Bounds) const
+        {
+            return Area.Intersect(Bounds);
+        }
+
+        FBox2D GetBounds() const
+        {
+            return Area;
+        }
+    };
+
+    struct FCircleQueryShape
+    {
+        FVector2D Center;
+        double RadiusSquared;
+
+        bool Intersects(const FBox2D& Bounds) const
+        {
+            return BoxDistanceSquared(Bounds, Center) <= RadiusSquared;
+        }
+
+        FBox2D GetBounds() const
+        {
+            const double Radius = FMath::Sqrt(RadiusSquared);
+            return FBox2D(Center - FVector2D(Radius), Center + FVector2D(Radius));
+        }
+    };
+
+    struct FCapsuleQueryShape
+    {
+        FVector2D Start;
+        FVector2D End;
+        double RadiusSquared;
+        FBox2D SweptBounds;
+
+        FCapsuleQueryShape(const FVector2D& InStart, const FVector2D& InEnd, double Radius)
+            : Start(InStart), End(InEnd), RadiusSquared(Radius * Radius),
+            SweptBounds(FVector2D::Min(InStart, InEnd) - FVector2D(Radius), FVector2D::Max(InStart, InEnd) + FVector2D(Radius)) {}
+
+        bool Intersects(const FBox2D& Bounds) const
+        {
+            if (!SweptBounds.Intersect(Bounds))
+            {
+                return false;
+            }
+
+            if (SegmentIntersectsBox(Start, End, Bounds))
+            {
+                return true;
+            }
+
+            if (RadiusSquared <= 0.0)
+            {
+                return false;
+            }
+
+            // Disjoint convex shapes are closest at a vertex of one of them
+            if (BoxDistanceSquared(Bounds, Start) <= RadiusSquared || BoxDistanceSquared(Bounds, End) <= RadiusSquared)
+            {
+                return true;
+            }
+
+            const FVector2D Corners[4] = { Bounds.Min, FVector2D(Bounds.Max.X, Bounds.Min.Y), FVector2D(Bounds.Min.X, Bounds.Max.Y), Bounds.Max };
+            for (const FVector2D& Corner : Corners)
+            {
+                if (FVector2D::DistSquared(Corner, FMath::ClosestPointOnSegment2D(Corner, Start, End)) <= RadiusSquared)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        FBox2D GetBounds() const
+        {
+            return SweptBounds;
+        }
+    };
+
+    // Queue item of the best-first nearest traversals, ordered by its lower bound distance.
+    // Node items are tree nodes or grid rings depending on the index.
+    struct FNearestQueueItem
+    {
+        enum class EType : uint8 { Node, Entry, Exact };
+
+        double DistanceSquared;
+        int32 Index;
+        EType Type;
+
+        bool operator<(const FNearestQueueItem& Other) const
+        {
+            return DistanceSquared < Other.DistanceSquared;
+        }
+    };
+}
@@ -33,6 +33,9 @@ namespace SplineUtilities
     // Function to get all spline points between two specified locations along the spline at the specified interval
     TArray<FVector> GetSplinePointsBetweenLocations(USplineComponent* SplineComponent, float DistanceBetweenPoints, const FVector& StartLocation, const FVector& EndLocation);
 
+    // Function to get all spline points between two input keys at the specified interval, ordered from StartKey to EndKey
+    TArray<FVector> GetSplinePointsBetweenInputKeys(USplineComponent* SplineComponent, float DistanceBetweenPoints, float StartKey, float EndKey);
+
     // Function to generate evenly spaced points along a straight line between the given start and end locations
     TArray<FVector> GetPointsBetweenLocations(const FVector& StartLocation, const FVector& EndLocation, float DistanceBetweenPoints);
 };
@@ -2,52 +2,106 @@
 
 #include "CoreMinimal.h"
 #include "Components/SplineComponent.h"
+#include "SplineSpatialIndex.h"
 
 // Structure Definitions
 struct FQuadtreeNode
 {
     FBox2D Bounds; // 2D bounds of the node
-    TArray<USplineComponent*> SplineComponents; // Spline components in this node
-    TSharedPtr<FQuadtreeNode> Children[4]; // Pointers to child nodes (subdivisions)
+    int32 Parent; // Index of the parent node in the node pool
+    int32 FirstChild; // Index of the first of four contiguous children (Z-order), INDEX_NONE for leaves
+    int32 Depth; // Depth below the initial root, a root grown outwards gets negative depths
 
-    FQuadtreeNode(const FBox2D& InBounds) : Bounds(InBounds) {}
+    // Leaf contents kept as parallel arrays so a leaf scan only touches the cached bounds
+    TArray<int32> EntryIds;
+    TArray<FBox2D> EntryBounds;
+
+    // Entry bounds rounded outwards to float, in blocks of four lanes: MinX[4], MinY[4], MaxX[4], MaxY[4]
+    TArray<float> PackedBounds;
+
+    FQuadtreeNode() : Bounds(ForceInit), Parent(INDEX_NONE), FirstChild(INDEX_NONE), Depth(0) {}
+    FQuadtreeNode(const FBox2D& InBounds, int32 InParent, int32 InDepth)
+        : Bounds(InBounds), Parent(InParent), FirstChild(INDEX_NONE), Depth(InDepth) {}
 
     bool IsLeafNode() const
     {
-        return Children[0] == nullptr;
+        return FirstChild == INDEX_NONE;
     }
 };
 
 // Class Definitions
-class FQuadtree
+class FQuadtree : public ISplineSpatialIndex
 {
 private:
-    TSharedPtr<FQuadtreeNode> RootNode;
+    // Node pool, the root is always at index 0 and children are allocated in blocks of four
+    TArray<FQuadtreeNode> Nodes;
+    TArray<int32> FreeChildBlocks;
+
+    // Entry data in struct-of-arrays layout, indexed by entry id
+    TArray<USplineComponent*> EntrySplines;
+    TArray<FBox2D> EntryBounds;
+    TArray<FSplineZRange> EntryZRanges;
+    TArray<TArray<int32, TInlineAllocator<4>>> EntryLeaves; // Reverse index: leaves that hold each entry
+    TArray<int32> FreeEntries;
+    TMap<USplineComponent*, int32> SplineToEntry;
+
+    // Per entry stamp of the last query that reported it, so each spline is reported once
+    mutable TArray<uint32> EntryQueryStamps;
+    mutable uint32 QueryEpoch;
+
     int32 MaxSplinesPerNode;
     int32 MaxDepth;
     bool bVisualizeQuadtree;
+    bool bUseVectorLeafScan;
 
 public:
+    static constexpr int32 RootIndex = 0;
+
     // Constructor
     FQuadtree(const FBox2D& WorldBounds, int32 InMaxSplinesPerNode, int32 InMaxDepth);
 
     // Public Methods
-    void InsertSplineComponent(USplineComponent* SplineComponent);
-    void RemoveSplineComponent(USplineComponent* SplineComponent);
-    void UpdateSplineComponent(USplineComponent* SplineComponent);
-    void QuerySplinesInArea(const FBox2D& Area, TArray<USplineComponent*>& OutSplines) const;
-    void Clear();
-    void GetAllSplines(TArray<USplineComponent*>& OutSplines) const;
+    virtual void InsertSplineComponent(USplineComponent* SplineComponent) override;
+    virtual void BulkLoad(const TArray<USplineComponent*>& SplineComponents) override;
+    virtual void RemoveSplineComponent(USplineComponent* SplineComponent) override;
+    virtual void UpdateSplineComponent(USplineComponent* SplineComponent) override;
+    virtual void Clear() override;
+    virtual void GetAllSplines(TArray<USplineComponent*>& OutSplines) const override;
+    virtual FBox2D GetBounds() const override;
+    virtual int32 GetNumNodes() const override;
+    virtual ESplineSpatialIndexType GetType() const override;
     void SetVisualizeQuadtree(bool bValue);
-    FBox2D GetBounds() const;
+    void SetUseVectorLeafScan(bool bValue);
+
+    // Exact shape queries against node and entry bounds
+    virtual bool VisitSplinesInArea(const FBox2D& Area, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const override;
+    virtual bool VisitSplinesInCircle(const FVector2D& Center, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const override;
+    virtual bool VisitSplinesInCapsule(const FVector2D& Start, const FVector2D& End, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const override;
+
+    // Wraps the root in new parents, doubling outwards, until the area fits. Existing subtrees are kept as they are.
+    virtual int32 GrowToContain(const FBox2D& Area) override;
+
+    // Best-first nearest neighbour search over nodes and entries
+    virtual void FindNearestSplines(const FVector2D& Point, int32 K, double MaxDistance, TArray<USplineComponent*>& OutSplines, FSplineDistanceSquaredFunction DistanceSquaredFn) const override;
 
 private:
     // Private Methods
-    void SubdivideNode(TSharedPtr<FQuadtreeNode> Node, int32 CurrentDepth);
-    void InsertSplineIntoNode(TSharedPtr<FQuadtreeNode> Node, USplineComponent* SplineComponent, int32 CurrentDepth);
-    void RemoveSplineFromNode(TSharedPtr<FQuadtreeNode> Node, USplineComponent* SplineComponent);
-    void QueryNodeSplinesInArea(TSharedPtr<FQuadtreeNode> Node, const FBox2D& Area, TArray<USplineComponent*>& OutSplines) const;
-    void ClearNode(TSharedPtr<FQuadtreeNode> Node);
-    void CollectSplines(const TSharedPtr<FQuadtreeNode>& Node, TArray<USplineComponent*>& OutSplines) const;
-    void DrawDebugBoxForNode(TSharedPtr<FQuadtreeNode> Node, UWorld* World);
+    int32 AllocateEntry(USplineComponent* SplineComponent, const FBox& Bounds);
+    void ReleaseEntry(int32 EntryId);
+    bool IsNodeInUse(int32 NodeIndex) const;
+    int32 AllocateChildBlock();
+    void ReleaseChildBlock(int32 FirstChild);
+    void SubdivideNode(int32 NodeIndex);
+    void InitializeChildBlock(int32 NodeIndex, int32 FirstChild);
+    void BuildNode(int32 NodeIndex, const TArray<int32>& NodeEntries, int32& OutNumOverfullLeaves);
+    bool TryMergeChildren(int32 NodeIndex);
+    void InsertEntryIntoNode(int32 NodeIndex, int32 EntryId);
+    void AddEntryToLeaf(int32 NodeIndex, int32 EntryId);
+    void RemoveEntryFromLeaf(int32 NodeIndex, int32 EntryId);
+    void RemoveEntryFromNodes(int32 EntryId);
+    void DrawDebugBoxForNode(int32 NodeIndex, UWorld* World) const;
+    uint32 BeginQuery() const;
+
+    template <typename ShapeType>
+    bool VisitSplinesInShape(const ShapeType& Shape, const FSplineZRange& ZRange, FSplineVisitorFunction Visitor) const;
 };
@@ -6,8 +6,15 @@
 #include "ProceduralMeshComponent.h"
 #include "RoadPathfindingComponent.h"
 #include "Quadtree.h"
+#include "SplineSegmentBVH.h"
+#include "SplineNearestRaster.h"
+#include "RoadGraph.h"
+#include "RoadPathCache.h"
+#include "RoadPathRequest.h"
 #include "RoadActor.generated.h"
 
+struct FRoadAsyncPathRequest;
+
 UCLASS()
 class ROADNETWORKTOOL_API ARoadActor : public AActor
 {
@@ -36,6 +43,28 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Quadtree")
 	int32 MaxDepth = 5;
 
+	// Auto picks the backend and its parameters from the spline distribution, ignoring the settings above
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spatial Index")
+	ESplineSpatialIndexType SpatialIndexType = ESplineSpatialIndexType::Auto;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spatial Index")
+	float HashGridCellSize = 5000.0f;
+
+	// Bakes the nearest road of every cell so nearest road lookups become a single cell read
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Nearest Road Raster")
+	bool bUseNearestRoadRaster = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Nearest Road Raster", meta = (EditCondition = "bUseNearestRoadRaster", ClampMin = "10.0"))
+	float NearestRoadRasterCellSize = 200.0f;
+
+	// Cells further than this from every road stay empty and are answered by the segment BVH
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Nearest Road Raster", meta = (EditCondition = "bUseNearestRoadRaster", ClampMin = "10.0"))
+	float NearestRoadRasterMaxDistance = 5000.0f;
+
+	// Refined routes kept for repeated requests between the same spots, 0 disables the cache. Changes apply to the next request.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding|Cache", meta = (ClampMin = "0"))
+	int32 PathCacheSize = 64;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Road Properties")
 	float RoadWidth;
 
@@ -61,24 +90,85 @@ public:
 	void AddSplineComponent(USplineComponent* SplineComponent);
 	void UpdateSplineComponent(USplineComponent* SplineComponent);
 	void AddOrUpdateSplineComponent(USplineComponent* SplineComponent, bool bIsUpdate);
+	void RemoveSplineComponent(USplineComponent* SplineComponent);
 	const TArray<USplineComponent*>& GetSplineComponents() const;
 
 	// Quadtree management
 	FBox2D CalculateSquareBounds(float PaddingPercentage);
 	void InitializeQuadtree();
 
+	// Builds the contraction hierarchy for the current network and saves it with the level, so loading it skips the build
+	UFUNCTION(CallInEditor, Category = "Pathfinding")
+	void BakeContractionHierarchy();
+
+	// Junctions and dead ends of the splines, rebuilt on the first call after the network version changed
+	const FRoadNetworkTopology& GetRoadTopology();
+
 	// Pathfinding-related functions
 	UFUNCTION(BlueprintCallable, Category = "Pathfinding")
-	TArray<FVector> FindPathRoadNetwork(FVector StartLocation, FVector TargetLocation, bool bRightOffset);
+	TArray<FVector> FindPathRoadNetwork(FVector StartLocation, FVector TargetLocation, bool bRightOffset, ERoadPathSearchMode SearchMode = ERoadPathSearchMode::Auto);
+
+	// Runs the requests on worker threads and returns the paths in request order
+	UFUNCTION(BlueprintCallable, Category = "Pathfinding")
+	TArray<FRoadPathResult> FindPathsRoadNetworkBatch(const TArray<FRoadPathRequest>& Requests);
+
+	// Routes to a destination shared by many agents, the first request builds a flow field towards it and every
+	// further one just follows its next hops
+	UFUNCTION(BlueprintCallable, Category = "Pathfinding|Flow Fields")
+	TArray<FVector> FindPathToSharedDestination(FVector StartLocation, FVector TargetLocation, bool bRightOffset);
+
+	// Field towards the node routes to the target end at, for agents that step along the graph themselves
+	TSharedPtr<const FRoadFlowField> GetDestinationFlowField(const FVector& TargetLocation);
+
+	// Searches on the thread pool and calls back on the game thread with the same path FindPathRoadNetwork returns.
+	// Spline edits during the search start it over a few times, after that it completes on the network it ran on.
+	UFUNCTION(BlueprintCallable, Category = "Pathfinding|Async")
+	FRoadPathRequestHandle RequestPathAsync(const FRoadPathRequest& Request, FRoadPathRequestCompleted OnCompleted);
+
+	FRoadPathRequestHandle RequestPathAsyncWithCallback(const FRoadPathRequest& Request, FRoadPathRequestCallback OnCompleted);
+
+	// Returns false if the request has already completed or was cancelled before
+	UFUNCTION(BlueprintCallable, Category = "Pathfinding|Async")
+	bool CancelPathRequest(FRoadPathRequestHandle Handle);
+
+	UFUNCTION(BlueprintPure, Category = "Pathfinding|Async")
+	bool IsPathRequestPending(FRoadPathRequestHandle Handle) const;
+
+	void CancelAllPathRequests();
+
+	// Graph search of one route on a snapshot, touches neither the actor nor the splines. The end nodes come from
+	// FindNearestNodeWithSpline on the snapshot graph, callers look them up once for the cache key and the search.
+	static bool FindRoadPathSpans(const FRoadPathSearchSnapshot& Snapshot, int32 StartNodeId, int32 EndNodeId, const FSplineSegmentHit& StartHit,
+		const FSplineSegmentHit& EndHit, ERoadPathSearchMode SearchMode, FRoadPathSearchContext& SearchContext, TArray<FRoadPathSpan>& OutSpans);
+
+	// Spans followed by the refinement, only reads the graph
+	static bool ComputeRoadPath(const FRoadPathSearchSnapshot& Snapshot, int32 StartNodeId, int32 EndNodeId, const FSplineSegmentHit& StartHit,
+		const FSplineSegmentHit& EndHit, ERoadPathSearchMode SearchMode, int32 Lane, FRoadPathSearchContext& SearchContext, TArray<FVector>& OutPath);
 
-	TArray<FVector> RefinePathWithSplinePoints(TArray<TSharedPtr<FPathNode>>& PathNodes, USplineComponent* StartSpline, USplineComponent* EndSpline);
+	// End points, added to every path after the cache
+	void FinishRoadPath(TArray<FVector>& Path, const FVector& StartLocation, const FVector& TargetLocation);
+
+	// Copies the spans out of the lane polylines of the graph, Lane INDEX_NONE follows the centre line
+	static TArray<FVector> RefinePathWithSplinePoints(const FRoadGraph& Graph, const TArray<FRoadPathSpan>& Spans, int32 Lane = INDEX_NONE);
 	TArray<FVector> AddPathWithStartAndEndPoints(TArray<FVector>& PathLocations, FVector StartLocation, FVector TargetLocation);
-	void AdjustSplineNodes(TArray<TSharedPtr<FPathNode>>& PathNodes, FVector StartLocation, FVector TargetLocation, USplineComponent*& OutStartSpline, USplineComponent*& OutEndSpline);
-	void ApplyRightOffsetToPathNodes(TArray<FVector>& Path, float Width);
+	static void AdjustPathEnds(const FRoadGraph& Graph, const FRoadGraphPath& GraphPath, const FSplineSegmentHit& StartHit, const FSplineSegmentHit& EndHit, TArray<FRoadPathSpan>& OutSpans);
+
+	// Path cache statistics
+	UFUNCTION(BlueprintPure, Category = "Pathfinding|Cache")
+	int64 GetPathCacheHits() const;
+
+	UFUNCTION(BlueprintPure, Category = "Pathfinding|Cache")
+	int64 GetPathCacheMisses() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Pathfinding|Cache")
+	void ResetPathCacheStats();
 
 	// Node management functions
-	TArray<TSharedPtr<FPathNode>> CreateDeepCopyOfPathNodes(const TArray<TSharedPtr<FPathNode>>& OriginalPathNodes);
-	TSharedPtr<FPathNode> FindNearestNodeWithSpline(const FVector& Location);
+	static int32 FindNearestNodeWithSpline(const FRoadGraph& Graph, const FVector& Location, const FSplineSegmentHit& NearestHit);
+
+	// Location of the nearest junction or road end for every input, inputs are returned unchanged while there is no road graph
+	UFUNCTION(BlueprintCallable, Category = "Pathfinding")
+	TArray<FVector> SnapToRoadNodes(const TArray<FVector>& Locations) const;
 
 	// Debug functions
 	UFUNCTION(BlueprintCallable, Category = "Pathfinding")
@@ -96,18 +186,55 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Pending path requests are cancelled, searches already running finish without calling back
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
-	// Spline quadtree
-	TSharedPtr<FQuadtree> SplineQuadtree;
+	// Spline spatial index, a quadtree or a hash grid
+	TSharedPtr<ISplineSpatialIndex> SplineSpatialIndex;
 
-private:
-	// Path nodes data
-	TArray<TSharedPtr<FPathNode>> AllPathNodes;
+	// Segment BVH for nearest point queries
+	TSharedPtr<FSplineSegmentBVH> SplineSegmentBVH;
+
+	// Optional baked nearest road raster, refined on the BVH samples
+	TSharedPtr<FSplineNearestRaster> NearestRoadRaster;
+
+	// Road graph searched by the pathfinding, rebuilt with the spatial index
+	TSharedPtr<const FRoadGraph> RoadGraph;
 
+	// Bumped by every change to the splines or the structures built from them, cached paths of older versions are dropped
+	uint32 NetworkVersion = 0;
+
+private:
 	// Debug-related variables
 	bool bDebugSelectedPoint;
 	FVector SelectedPoint;
+
+	FRoadPathCache PathCache;
+
+	TSharedPtr<FRoadNetworkTopology> RoadTopology;
+	uint32 RoadTopologyVersion = 0;
+
+	// Applies one spline edit to the road graph, to a copy while searches or builds in flight still read it
+	void EditRoadGraph(TFunctionRef<bool(FRoadGraph&, FRoadGraphEdit&)> Edit);
+
+	// The right lane runs a quarter of the road width off the centre line, a changed width samples the lanes again on a copy of the graph
+	TArray<float> GetRoadLaneOffsets() const;
+	void UpdateRoadLanes();
+
+	// One search context per batch task, kept so batches don't reallocate the search buffers
+	TArray<FRoadPathSearchContext> BatchSearchContexts;
+
+	// Searches of asynchronous requests, released when the search completes or is cancelled
+	void StartPathRequest(int32 RequestId, const TSharedRef<FRoadAsyncPathRequest>& AsyncRequest);
+	void CompletePathRequest(int32 RequestId, const TSharedRef<FRoadAsyncPathRequest>& AsyncRequest);
+
+	TMap<int32, TSharedRef<FRoadAsyncPathRequest>> PendingPathRequests;
+	int32 LastPathRequestId = 0;
+
+	// Shared with the running searches, which may finish after the actor is gone
+	TSharedRef<FRoadPathSearchContextPool> AsyncSearchContexts = MakeShared<FRoadPathSearchContextPool>();
 };
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RoadGraph.h"
+#include "RoadPathSearch.h"
+
+// Two level abstraction of a road graph for hierarchical A* (HPA*). Nodes are partitioned by a fixed grid of
+// square clusters, border nodes are the ones with an edge into another cluster. Every cluster keeps the shortest
+// distances between its border nodes without leaving the cluster, so a query searches the border nodes only and
+// then refines each hop it took inside its cluster. All border nodes are kept, so the paths are as short as A*'s.
+//
+// Node ids survive graph edits, so Update compares nodes with what it saw last and only recomputes the tables
+// of the clusters whose nodes were added, removed or connected differently. Given the edit, only the nodes it
+// touched are compared.
+class FRoadClusterHierarchy
+{
+public:
+    FRoadClusterHierarchy();
+
+    // Cluster edge length for about NodesPerCluster nodes per cluster if they were spread evenly
+    static double ChooseClusterSize(const FRoadGraph& Graph, int32 NodesPerCluster = 64);
+
+    // Partitions the nodes and computes the tables of all clusters in parallel
+    void Build(const FRoadGraph& Graph, double InClusterSize);
+
+    // Brings the hierarchy in line with an edited graph, returns the number of clusters recomputed
+    int32 Update(const FRoadGraph& Graph);
+
+    // Same for a hierarchy in line with the graph right before Edit, which only looks at the touched nodes
+    int32 Update(const FRoadGraph& Graph, const FRoadGraphEdit& Edit);
+
+    // The tables only fit the graph revision they were built or last updated for
+    bool IsBuiltFor(const FRoadGraph& Graph) const;
+    uint32 GetGraphRevision() const;
+
+    // A* over the border nodes in the forward scratch of the context followed by the refinement
+    bool FindPath(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadPathSearchContext& Context, FRoadGraphPath& OutPath) const;
+
+    double GetClusterSize() const;
+    int32 GetNumClusters() const;
+    int32 GetNumBorderNodes() const;
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    struct FCluster
+    {
+        TArray<int32> Nodes;
+        TArray<int32> BorderNodes;
+
+        // Row major, BorderDistances[From * BorderNodes.Num() + To], unreachable pairs hold the largest float
+        TArray<float> BorderDistances;
+    };
+
+    FIntPoint GetCell(const FVector& Location) const;
+    int32 FindOrAddCluster(const FVector& Location);
+    void AddNode(int32 NodeId, int32 ClusterIndex);
+    void RemoveNode(int32 NodeId);
+
+    // Compares the given nodes with what the hierarchy saw last and recomputes the clusters that changed
+    int32 UpdateNodes(const FRoadGraph& Graph, TConstArrayView<int32> NodeIds);
+
+    // Order independent hash of the node location and its edges, changes whenever an edit touched the node
+    static uint32 HashNode(const FRoadGraph& Graph, int32 NodeId);
+
+    // Finds the border nodes of the cluster and fills its distance table
+    void BuildCluster(const FRoadGraph& Graph, int32 ClusterIndex);
+
+    // Dijkstra search from one node that never leaves its cluster. Search is indexed like FCluster::Nodes and
+    // holds the parent edges, it stops early once TargetNodeId is settled, INDEX_NONE searches the whole cluster.
+    void SearchCluster(const FRoadGraph& Graph, int32 SourceNodeId, int32 TargetNodeId, FPathSearchScratch& Search) const;
+
+    // Appends the edges of one hop of the abstract path
+    bool RefineHop(const FRoadGraph& Graph, int32 FromNodeId, int32 ToNodeId, FPathSearchScratch& Search, TArray<int32>& OutEdges) const;
+
+    double ClusterSize;
+    int32 NumNodes;
+    uint32 GraphRevision;
+
+    TArray<FCluster> Clusters;
+    TMap<FIntPoint, int32> ClusterIndices;
+
+    // Per graph node, inactive nodes belong to no cluster
+    TArray<int32> NodeClusters;
+    TArray<int32> NodeLocalIndices;
+    TArray<int32> NodeBorderIndices;
+    TArray<uint32> NodeHashes;
+};
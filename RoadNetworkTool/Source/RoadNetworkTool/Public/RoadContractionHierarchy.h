@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RoadGraph.h"
+#include "RoadPathSearch.h"
+#include "RoadContractionHierarchy.generated.h"
+
+// Contraction hierarchy over a road graph. Nodes are contracted one by one in order of importance and
+// shortcuts keep the distances between the remaining nodes, so a query only has to search upward from
+// both ends and meets near the most important node of the path. Every arc is either an original graph
+// edge or a shortcut over two child arcs, so found paths unpack to exactly the edges A* would return.
+// All data is stored in UPROPERTY arrays so the preprocessing is saved with the level.
+USTRUCT()
+struct ROADNETWORKTOOL_API FRoadContractionHierarchy
+{
+    GENERATED_BODY()
+
+public:
+    // Orders and contracts all nodes, the priorities are evaluated on worker threads
+    void Build(const FRoadGraph& Graph);
+    void Reset();
+
+    // A hierarchy loaded with the level only fits the graph it was built from
+    bool IsBuiltFor(const FRoadGraph& Graph) const;
+
+    // Bidirectional Dijkstra search over upward arcs, the scratch parents hold arc ids
+    bool FindPath(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FPathSearchScratch& ForwardScratch, FPathSearchScratch& BackwardScratch, FRoadGraphPath& OutPath) const;
+
+    int32 GetNumShortcuts() const;
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    // Appends the original edges of an arc travelled from FromNodeId
+    void UnpackArc(const FRoadGraph& Graph, int32 ArcId, int32 FromNodeId, TArray<int32>& OutEdges) const;
+
+    int32 GetOtherArcNode(int32 ArcId, int32 NodeId) const;
+
+    friend class FRoadContractionBuilder;
+
+    UPROPERTY()
+    int32 NumNodes = 0;
+
+    UPROPERTY()
+    int32 NumEdges = 0;
+
+    UPROPERTY()
+    uint32 GraphChecksum = 0;
+
+    // Upward arcs of each node in compressed sparse row layout, they lead to nodes contracted later
+    UPROPERTY()
+    TArray<int32> UpOffsets;
+
+    UPROPERTY()
+    TArray<int32> UpTargets;
+
+    UPROPERTY()
+    TArray<float> UpWeights;
+
+    UPROPERTY()
+    TArray<int32> UpArcs;
+
+    // Undirected arcs between ArcNodesA and ArcNodesB. Original arcs keep the graph edge from A to B,
+    // shortcuts keep the contracted middle node and the arcs A-Middle and Middle-B.
+    UPROPERTY()
+    TArray<int32> ArcNodesA;
+
+    UPROPERTY()
+    TArray<int32> ArcNodesB;
+
+    UPROPERTY()
+    TArray<int32> ArcEdges;
+
+    UPROPERTY()
+    TArray<int32> ArcMiddles;
+
+    UPROPERTY()
+    TArray<int32> ArcChildrenA;
+
+    UPROPERTY()
+    TArray<int32> ArcChildrenB;
+};
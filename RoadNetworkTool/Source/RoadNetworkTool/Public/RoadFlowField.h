@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "RoadGraph.h"
+#include "RoadPathSearch.h"
+
+// Next hop and remaining distance of every node towards one destination. One Dijkstra search from the goal
+// fills the table, after that any number of agents heading there read their route by following the next hops.
+// Hops are stored as node ids, which survive graph edits, so a table stays valid until an edit changes its tree.
+class FRoadFlowField
+{
+public:
+    // Distance of nodes that can't reach the goal
+    static constexpr float Unreachable = TNumericLimits<float>::Max();
+
+    FRoadFlowField();
+
+    // Edges exist in both directions, so the search runs outwards from the goal and every node steps to its parent
+    void Build(const FRoadGraph& Graph, int32 InGoalNodeId, FPathSearchScratch& Scratch);
+
+    // Whether the edit can have changed a distance or a next hop: it removed a connection the tree runs over,
+    // added one that shortens a route, or took the goal node away. Graph is the edited graph.
+    bool IsAffectedBy(const FRoadGraph& Graph, const FRoadGraphEdit& Edit) const;
+
+    int32 GetGoalNode() const;
+    bool IsReachable(int32 NodeId) const;
+    float GetDistanceToGoal(int32 NodeId) const;
+
+    // Neighbour one step closer to the goal, INDEX_NONE at the goal and at unreachable nodes
+    int32 GetNextNode(int32 NodeId) const;
+
+    // Follows the next hops from the start over the shortest edge of each, the result has the same shape as a
+    // search result. Fails if a hop has no edge in Graph, which only happens on a graph the table doesn't fit.
+    bool ExtractPath(const FRoadGraph& Graph, int32 StartNodeId, FRoadGraphPath& OutPath) const;
+
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    int32 NumNodes;
+    int32 GoalNodeId;
+
+    // A freed goal id may be handed out again somewhere else
+    FVector GoalLocation;
+
+    // 8 bytes per node
+    TArray<int32> NextNodes;
+    TArray<float> Distances;
+};
+
+// Least recently used flow fields by goal node. Callers hold on to the shared pointer they get, so evicting
+// an entry only drops the cache's reference and agents still following the field are unaffected. Edits passed
+// to ApplyEdit only drop the fields they affect, a graph revision the cache didn't see an edit for empties it.
+class FRoadFlowFieldCache
+{
+public:
+    explicit FRoadFlowFieldCache(int32 InCapacity = 0);
+
+    // Capacity 0 disables the cache, every request then builds a new field. Changing it drops all entries.
+    void SetCapacity(int32 InCapacity);
+    int32 GetCapacity() const;
+    int32 Num() const;
+    void Empty();
+
+    // Returns the cached field towards the goal, building it if it is missing
+    TSharedPtr<const FRoadFlowField> FindOrBuild(const TSharedPtr<const FRoadGraph>& Graph, int32 GoalNodeId);
+
+    // Drops the fields Edit affects, Graph is the result of the edit and PreviousRevision its revision before it.
+    // The other fields carry over to the edited graph, unless the cache wasn't in line with the graph before the edit.
+    void ApplyEdit(const FRoadGraph& Graph, uint32 PreviousRevision, const FRoadGraphEdit& Edit);
+
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    TLruCache<int32, TSharedPtr<const FRoadFlowField>> Entries;
+    int32 Capacity;
+
+    // Revision of the graph the entries fit
+    uint32 GraphRevision;
+
+    // Reused by every build, the fields are built one at a time on the game thread
+    FPathSearchScratch Scratch;
+};
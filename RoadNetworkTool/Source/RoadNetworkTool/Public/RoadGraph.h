@@ -0,0 +1,207 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SplineComponent.h"
+#include "RoadNetworkTopology.h"
+#include "RoadNodeIndex.h"
+#include "RoadSplineLanes.h"
+
+// Result of a graph search, Edges[i] leads from Nodes[i] to Nodes[i + 1]
+struct FRoadGraphPath
+{
+    TArray<int32> Nodes;
+    TArray<int32> Edges;
+    float Length = 0.0f;
+
+    bool IsValid() const
+    {
+        return Nodes.Num() > 0;
+    }
+
+    void Reset()
+    {
+        Nodes.Reset();
+        Edges.Reset();
+        Length = 0.0f;
+    }
+};
+
+// Stretch of one spline travelled by a path, the keys run in travel direction
+struct FRoadPathSpan
+{
+    int32 SplineIndex;
+    float StartKey;
+    float EndKey;
+};
+
+// Connections one incremental edit removed and added, and the nodes it touched. Data derived from the graph
+// uses it to update only what the edit can have changed.
+struct FRoadGraphEdit
+{
+    // Spline between two nodes, traversable both ways with the same length
+    struct FConnection
+    {
+        int32 NodeA;
+        int32 NodeB;
+        float Length;
+    };
+
+    // Ends of every edited spline before and after the edit, may repeat
+    TArray<int32> Nodes;
+    TArray<FConnection> RemovedConnections;
+    TArray<FConnection> AddedConnections;
+
+    void Reset()
+    {
+        Nodes.Reset();
+        RemovedConnections.Reset();
+        AddedConnections.Reset();
+    }
+};
+
+// Road graph in compressed sparse row layout. Nodes are the welded spline ends of the network topology, every
+// spline adds an edge in both directions with its arc length, so searches never have to look at the spline components.
+//
+// Single splines can be added, removed or updated without reading the others. Node ids and spline indices
+// stay the same across these edits, ids freed by an edit are handed out again to later ones. Every node keeps
+// a little spare room after its edges, so an edit only rewrites the edges of the nodes it touches and a node
+// that runs out of room moves its edges to the end of the arrays. Edge ids of touched nodes change with every
+// edit and all of them change when the moved blocks are compacted, so only keep them for the graph revision
+// they came from.
+class FRoadGraph
+{
+public:
+    FRoadGraph();
+
+    // Node ids are the topology's node ids, incremental edits weld with the same tolerance
+    void Build(const FRoadNetworkTopology& Topology);
+    void Build(const TArray<USplineComponent*>& SplineComponents);
+    void Reset();
+
+    // Incremental edits, they return false if nothing changed. Update re-reads the end points and the
+    // length of the spline, so it also covers moving an end point onto another node or away from it.
+    // The changes are appended to OutEdit if one is passed.
+    bool AddSpline(USplineComponent* SplineComponent, FRoadGraphEdit* OutEdit = nullptr);
+    bool RemoveSpline(const USplineComponent* SplineComponent, FRoadGraphEdit* OutEdit = nullptr);
+    bool UpdateSpline(USplineComponent* SplineComponent, FRoadGraphEdit* OutEdit = nullptr);
+
+    // Unique per state of the network: every build and edit takes a new one, copies share it until they are
+    // edited. Lane offsets don't change it.
+    uint32 GetRevision() const;
+
+    // Nodes, ids of removed nodes stay in range but are inactive until they are reused
+    int32 GetNumNodes() const;
+    FVector GetNodeLocation(int32 NodeId) const;
+    bool IsNodeActive(int32 NodeId) const;
+
+    // Nearest node lookups on a grid index kept in sync with the edits, INDEX_NONE if no node is within MaxDistance
+    int32 FindNearestNode(const FVector& Location, double MaxDistance = TNumericLimits<double>::Max()) const;
+    void FindNearestNodes(const FVector& Location, int32 K, double MaxDistance, TArray<int32>& OutNodeIds) const;
+    void FindNodesInRadius(const FVector& Location, double Radius, TArray<int32>& OutNodeIds) const;
+
+    // Nearest node of every location, looked up in parallel for large batches
+    void FindNearestNodesBatch(TConstArrayView<FVector> Locations, TArray<int32>& OutNodeIds) const;
+
+    // Outgoing edges of a node are the contiguous range [GetFirstEdge, GetEndEdge). Edge ids are below
+    // GetNumEdges, which also counts the spare and abandoned slots, GetNumActiveEdges counts the edges.
+    int32 GetNumEdges() const;
+    int32 GetNumActiveEdges() const;
+    int32 GetFirstEdge(int32 NodeId) const;
+    int32 GetEndEdge(int32 NodeId) const;
+    int32 GetEdgeSource(int32 EdgeId) const;
+    int32 GetEdgeTarget(int32 EdgeId) const;
+    int32 GetEdgeSpline(int32 EdgeId) const;
+    float GetEdgeStartKey(int32 EdgeId) const;
+    float GetEdgeEndKey(int32 EdgeId) const;
+    float GetEdgeLength(int32 EdgeId) const;
+
+    // The edge created from the same spline in the opposite direction
+    int32 GetReverseEdge(int32 EdgeId) const;
+
+    // Hash of the edge layout and lengths, used to tell whether precomputed data still matches the graph
+    uint32 ComputeChecksum() const;
+
+    // Splines, indexed in the order they were added. Indices of removed splines return no component.
+    int32 GetNumSplines() const;
+    USplineComponent* GetSplineComponent(int32 SplineIndex) const;
+    int32 FindSplineIndex(const USplineComponent* SplineComponent) const;
+    int32 GetSplineStartNode(int32 SplineIndex) const;
+    int32 GetSplineEndNode(int32 SplineIndex) const;
+
+    // Input key of the spline end point at the node, the spline must end at it
+    float GetSplineKeyAtNode(int32 SplineIndex, int32 NodeId) const;
+
+    // Centre line and lane polylines, sampled whenever a spline is built, added or updated. Copies of the graph
+    // share the polylines of splines they didn't edit. Changing the offsets samples every spline again.
+    void SetLaneOffsets(TConstArrayView<float> InLaneOffsets);
+    const TArray<float>& GetLaneOffsets() const;
+    const FRoadSplineLanes* GetSplineLanes(int32 SplineIndex) const;
+
+private:
+    // Reads the end points and length of the spline into its slot, the nodes are looked up or added
+    bool AddSplineRecord(USplineComponent* SplineComponent);
+    void ReadSplineEnds(int32 SplineIndex);
+    void BuildSplineLanes(int32 SplineIndex);
+
+    int32 AcquireNode(const FVector& Location);
+    void ReleaseNode(int32 NodeId);
+
+    // Lays out the edges of all splines again with spare room at every node, linear in nodes and edges without
+    // touching any spline component
+    void BuildEdges();
+
+    // Edges of one spline in both directions, patched into the blocks of its two end nodes
+    void AddSplineEdges(int32 SplineIndex, FRoadGraphEdit* OutEdit);
+    void RemoveSplineEdges(int32 SplineIndex, FRoadGraphEdit* OutEdit);
+    int32 AddEdgeSlot(int32 NodeId);
+    void RemoveEdgeSlot(int32 EdgeId);
+    void MoveEdge(int32 FromEdgeId, int32 ToEdgeId);
+    void RelocateEdges(int32 NodeId, int32 NewCapacity);
+
+    // Lays the edges out again once the blocks abandoned by RelocateEdges outnumber the edges
+    void CompactEdgesIfNeeded();
+
+    // Takes a fresh revision, called by every build and edit
+    void BumpRevision();
+
+    // Node positions in struct-of-arrays layout
+    TArray<double> NodeX;
+    TArray<double> NodeY;
+    TArray<double> NodeZ;
+
+    // Spline ends at every node, nodes without any are free and removed from NodeHash
+    TArray<int32> NodeSplineCounts;
+    TArray<int32> FreeNodes;
+    FRoadEndpointHash NodeHash;
+    FRoadNodeIndex NodeIndex;
+
+    // Block of edge slots per node, the first EdgeCounts slots hold its edges
+    TArray<int32> EdgeOffsets;
+    TArray<int32> EdgeCounts;
+    TArray<int32> EdgeCapacities;
+    int32 NumActiveEdges;
+    int32 NumAbandonedSlots;
+
+    TArray<int32> EdgeSources;
+    TArray<int32> EdgeTargets;
+    TArray<int32> EdgeSplines;
+    TArray<float> EdgeStartKeys;
+    TArray<float> EdgeEndKeys;
+    TArray<float> EdgeLengths;
+    TArray<int32> EdgeReverses;
+
+    uint32 Revision;
+
+    // Per spline data
+    TArray<USplineComponent*> Splines;
+    TArray<int32> SplineStartNodes;
+    TArray<int32> SplineEndNodes;
+    TArray<float> SplineEndKeys;
+    TArray<float> SplineLengths;
+    TArray<TSharedPtr<const FRoadSplineLanes>> SplineLanes;
+    TArray<int32> FreeSplineIndices;
+    TMap<const USplineComponent*, int32> SplineIndices;
+
+    // Kept across Reset, they configure the graph rather than describe the network
+    TArray<float> LaneOffsets;
+};
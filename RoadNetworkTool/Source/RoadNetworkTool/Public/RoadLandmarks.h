@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RoadGraph.h"
+
+// Distance tables from a few landmark nodes to every node of a road graph. By the triangle inequality,
+// |d(L, Goal) - d(L, Node)| never overestimates the distance from Node to Goal, which gives A* a much
+// tighter heuristic than the straight line on winding roads.
+class FRoadLandmarks
+{
+public:
+    // Distance of nodes the landmark can't reach
+    static constexpr float Unreachable = TNumericLimits<float>::Max();
+
+    FRoadLandmarks();
+
+    // Largest landmark count whose tables fit the memory budget
+    static int32 GetMaxLandmarksForMemory(int32 NumNodes, float MaxMemoryMB);
+
+    // Picks landmarks spread over the network and runs one Dijkstra search per landmark in parallel
+    void Build(const FRoadGraph& Graph, int32 InNumLandmarks);
+
+    // The tables only fit the graph revision they were built from
+    bool IsBuiltFor(const FRoadGraph& Graph) const;
+
+    int32 GetNumLandmarks() const;
+    const TArray<int32>& GetLandmarkNodes() const;
+    SIZE_T GetAllocatedSize() const;
+
+    // Distances of one node to every landmark, contiguous so one heuristic evaluation reads a single row
+    const float* GetNodeDistances(int32 NodeId) const;
+
+    // Largest triangle inequality bound over all landmarks that reach both nodes
+    float GetLowerBound(int32 NodeId, const float* GoalDistances) const;
+
+private:
+    void SelectLandmarks(const FRoadGraph& Graph, int32 Count);
+
+    int32 NumNodes;
+    uint32 GraphRevision;
+    int32 NumLandmarks;
+    TArray<int32> LandmarkNodes;
+
+    // Node-major table, Distances[NodeId * NumLandmarks + LandmarkIndex]
+    TArray<float> Distances;
+};
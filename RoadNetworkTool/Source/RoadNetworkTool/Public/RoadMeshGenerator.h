@@ -60,9 +60,9 @@ public:
 	// Sets default values for this actor's properties
 	FRoadMeshGenerator();
 
-	// Intersection and NonIntersection Detection
-	TArray<FIntersectionNode> FindSplineIntersectionNodes(const TArray<USplineComponent*>& SplineComponents) const;
-	TArray<FNonIntersectionNode> FindSplineNonIntersectionNodes(const TArray<USplineComponent*>& SplineComponents) const;
+	// Intersection and NonIntersection Detection, read from the welded network topology
+	TArray<FIntersectionNode> FindSplineIntersectionNodes(const FRoadNetworkTopology& Topology) const;
+	TArray<FNonIntersectionNode> FindSplineNonIntersectionNodes(const FRoadNetworkTopology& Topology) const;
 	
 	// Road Mesh Generation
 	void GenerateRoadMesh(ARoadActor* RoadActor);
@@ -89,4 +89,4 @@ public:
 	FColor GetNextDebugColor();
 	void DrawDebugCurvedRoad(ARoadActor* RoadActor);
 	static bool IsDegenerateTriangle(const FVector& A, const FVector& B, const FVector& C);
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SplineComponent.h"
+
+// Points hashed into a grid of tolerance-sized cells. A point within the tolerance of a stored one lies in
+// one of the 27 cells around its own, so welding a point costs a constant number of cell lookups.
+class FRoadEndpointHash
+{
+public:
+    explicit FRoadEndpointHash(float InTolerance);
+
+    float GetTolerance() const;
+    void Reset();
+
+    // Id of the closest stored point within the tolerance, INDEX_NONE if there is none
+    int32 Find(const FVector& Location) const;
+    void Add(const FVector& Location, int32 Id);
+    void Remove(const FVector& Location, int32 Id);
+
+private:
+    struct FEntry
+    {
+        FVector Location;
+        int32 Id;
+    };
+
+    FIntVector GetCell(const FVector& Location) const;
+
+    float Tolerance;
+    TMap<FIntVector, TArray<FEntry, TInlineAllocator<2>>> Cells;
+};
+
+// Node where spline ends meet, at the location of the first end welded into it
+struct FRoadTopologyNode
+{
+    FVector Location = FVector::ZeroVector;
+
+    // Every spline ending here once, even if both of its ends do
+    TArray<USplineComponent*, TInlineAllocator<4>> Splines;
+
+    // Spline ends at the node, a spline that starts and ends here counts twice
+    int32 Degree = 0;
+
+    // Different splines meet at junctions, a single spline end is a dead end
+    bool IsJunction() const
+    {
+        return Splines.Num() > 1;
+    }
+
+    bool IsDeadEnd() const
+    {
+        return Degree == 1;
+    }
+};
+
+// Spline with the nodes at its ends and the data read from it, so consumers don't need to touch it again
+struct FRoadTopologySpline
+{
+    USplineComponent* SplineComponent = nullptr;
+    int32 StartNode = INDEX_NONE;
+    int32 EndNode = INDEX_NONE;
+    float EndKey = 0.0f;
+    float Length = 0.0f;
+};
+
+// Junctions and dead ends of a road network, found in one pass that welds spline ends closer than the
+// tolerance. The road graph and the mesh generator both build on it, so they agree on where roads meet.
+class FRoadNetworkTopology
+{
+public:
+    // Spline ends closer than this are one node
+    static constexpr float DefaultWeldTolerance = 10.0f;
+
+    explicit FRoadNetworkTopology(float InWeldTolerance = DefaultWeldTolerance);
+
+    // Splines without points and duplicates are skipped
+    void Build(const TArray<USplineComponent*>& SplineComponents);
+
+    float GetWeldTolerance() const;
+
+    int32 GetNumNodes() const;
+    const FRoadTopologyNode& GetNode(int32 NodeId) const;
+    int32 FindNode(const FVector& Location) const;
+
+    // Splines in build order
+    int32 GetNumSplines() const;
+    const FRoadTopologySpline& GetSpline(int32 SplineIndex) const;
+    int32 FindSplineIndex(const USplineComponent* SplineComponent) const;
+
+private:
+    TArray<FRoadTopologyNode> Nodes;
+    TArray<FRoadTopologySpline> Splines;
+    TMap<const USplineComponent*, int32> SplineIndices;
+    FRoadEndpointHash NodeHash;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Uniform grid over the road graph nodes in the XY plane. Nodes are added and removed one at a time, so the
+// index follows incremental graph edits without a rebuild. Distances are measured in 3D, which is never
+// shorter than the planar distance the grid bounds the search with.
+class FRoadNodeIndex
+{
+public:
+    explicit FRoadNodeIndex(double InCellSize = 5000.0);
+
+    // Cell size for about four nodes per cell when they are spread evenly over the bounds
+    static double ChooseCellSize(const FBox2D& Bounds, int32 NumNodes);
+
+    void Reset(double InCellSize);
+    double GetCellSize() const;
+    int32 Num() const;
+
+    void Add(int32 NodeId, const FVector& Location);
+    void Remove(int32 NodeId, const FVector& Location);
+
+    // INDEX_NONE if no node lies within MaxDistance
+    int32 FindNearest(const FVector& Location, double MaxDistance = TNumericLimits<double>::Max()) const;
+
+    // Up to K nodes within MaxDistance, nearest first
+    void FindNearest(const FVector& Location, int32 K, double MaxDistance, TArray<int32>& OutNodeIds) const;
+
+    // All nodes within the radius, in no particular order
+    void FindInRadius(const FVector& Location, double Radius, TArray<int32>& OutNodeIds) const;
+
+private:
+    struct FEntry
+    {
+        FVector Location;
+        int32 NodeId;
+    };
+
+    // Squared distance and node id, kept sorted by distance
+    using FNearestList = TArray<TPair<double, int32>, TInlineAllocator<8>>;
+
+    FIntPoint GetCell(const FVector& Location) const;
+    void FindNearestEntries(const FVector& Location, int32 K, double MaxDistance, FNearestList& OutNearest) const;
+
+    // Cells at Chebyshev distance Ring from Center that lie within the occupied cells
+    void VisitRing(const FIntPoint& Center, int32 Ring, TFunctionRef<void(const FEntry&)> Visitor) const;
+
+    double CellSize;
+    int32 NumEntries;
+    TMap<FIntPoint, TArray<FEntry, TInlineAllocator<4>>> Cells;
+
+    // Bounds of every cell that ever held a node, they only grow
+    FIntPoint MinCell;
+    FIntPoint MaxCell;
+};
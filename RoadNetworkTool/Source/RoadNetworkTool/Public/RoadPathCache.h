@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "SplineSegmentBVH.h"
+
+// Identifies a route by the splines and input keys its ends snapped to, the graph nodes the search started
+// and ended at and the lane it follows. The keys are quantized so repeated requests from the same spot map
+// to the same entry. The end nodes are picked from the raw request locations, so two requests snapping to
+// the same keys can still search between different nodes and are kept apart.
+struct FRoadPathCacheKey
+{
+    const USplineComponent* StartSpline = nullptr;
+    const USplineComponent* GoalSpline = nullptr;
+    int32 StartKey = 0;
+    int32 GoalKey = 0;
+    int32 StartNode = INDEX_NONE;
+    int32 GoalNode = INDEX_NONE;
+
+    // INDEX_NONE for the centre line
+    int32 Lane = INDEX_NONE;
+
+    // Steps per spline segment
+    static constexpr float KeyResolution = 1024.0f;
+
+    FRoadPathCacheKey() = default;
+    FRoadPathCacheKey(const FSplineSegmentHit& StartHit, const FSplineSegmentHit& GoalHit, int32 InStartNode, int32 InGoalNode, int32 InLane = INDEX_NONE);
+
+    FRoadPathCacheKey GetReversed() const;
+
+    bool operator==(const FRoadPathCacheKey& Other) const
+    {
+        return StartSpline == Other.StartSpline && GoalSpline == Other.GoalSpline && StartKey == Other.StartKey && GoalKey == Other.GoalKey
+            && StartNode == Other.StartNode && GoalNode == Other.GoalNode && Lane == Other.Lane;
+    }
+
+    friend uint32 GetTypeHash(const FRoadPathCacheKey& Key)
+    {
+        uint32 Hash = HashCombineFast(GetTypeHash(Key.StartSpline), GetTypeHash(Key.GoalSpline));
+        Hash = HashCombineFast(Hash, GetTypeHash(Key.StartKey));
+        Hash = HashCombineFast(Hash, GetTypeHash(Key.GoalKey));
+        Hash = HashCombineFast(Hash, GetTypeHash(Key.StartNode));
+        Hash = HashCombineFast(Hash, GetTypeHash(Key.GoalNode));
+        return HashCombineFast(Hash, GetTypeHash(Key.Lane));
+    }
+};
+
+// Bounded least recently used cache of refined road paths. Entries are tagged with the network version
+// they were computed for and all of them are dropped as soon as a lookup sees a newer version. Roads can
+// be driven both ways, so a centre line route is also served reversed for the opposite request. Lanes
+// keep to the right of the travel direction, so the reversed lane route lies on the other side of the road.
+class FRoadPathCache
+{
+public:
+    explicit FRoadPathCache(int32 InCapacity = 0);
+
+    // Capacity 0 disables the cache, changing it drops all entries
+    void SetCapacity(int32 InCapacity);
+    int32 GetCapacity() const;
+    int32 Num() const;
+    void Empty();
+
+    // Copies the cached path in request direction into OutPoints
+    bool Find(const FRoadPathCacheKey& Key, uint32 NetworkVersion, TArray<FVector>& OutPoints);
+    void Add(const FRoadPathCacheKey& Key, uint32 NetworkVersion, const TArray<FVector>& Points);
+
+    int64 GetNumHits() const;
+    int64 GetNumMisses() const;
+    void ResetStats();
+
+private:
+    // Points relative to the first one in single precision, half the size of world space vectors
+    struct FCachedPath
+    {
+        FVector Origin;
+        TArray<FVector3f> Points;
+    };
+
+    void SyncVersion(uint32 NetworkVersion);
+
+    TLruCache<FRoadPathCacheKey, FCachedPath> Entries;
+    int32 Capacity;
+    uint32 Version;
+    int64 NumHits;
+    int64 NumMisses;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RoadPathfindingComponent.h"
+#include "RoadPathRequest.generated.h"
+
+// One route of a batched path query, same parameters as FindPathRoadNetwork
+USTRUCT(BlueprintType)
+struct ROADNETWORKTOOL_API FRoadPathRequest
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding")
+    FVector StartLocation = FVector::ZeroVector;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding")
+    FVector TargetLocation = FVector::ZeroVector;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding")
+    bool bRightOffset = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding")
+    ERoadPathSearchMode SearchMode = ERoadPathSearchMode::Auto;
+};
+
+USTRUCT(BlueprintType)
+struct ROADNETWORKTOOL_API FRoadPathResult
+{
+    GENERATED_BODY()
+
+    // Empty when no route was found
+    UPROPERTY(BlueprintReadOnly, Category = "Pathfinding")
+    TArray<FVector> Path;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Pathfinding")
+    bool bFound = false;
+};
+
+// Identifies an asynchronous path request, 0 is never handed out
+USTRUCT(BlueprintType)
+struct ROADNETWORKTOOL_API FRoadPathRequestHandle
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Pathfinding")
+    int32 Id = 0;
+
+    bool IsValid() const
+    {
+        return Id != 0;
+    }
+
+    bool operator==(const FRoadPathRequestHandle& Other) const
+    {
+        return Id == Other.Id;
+    }
+
+    friend uint32 GetTypeHash(const FRoadPathRequestHandle& Handle)
+    {
+        return GetTypeHash(Handle.Id);
+    }
+};
+
+// Called on the game thread once an asynchronous request has finished, cancelled requests never call it
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FRoadPathRequestCompleted, FRoadPathRequestHandle, Handle, const FRoadPathResult&, Result);
+
+using FRoadPathRequestCallback = TFunction<void(FRoadPathRequestHandle Handle, const FRoadPathResult& Result)>;
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeLock.h"
+
+// Open list entry, kept next to its priority so sifting doesn't touch the per node arrays
+struct FPathHeapItem
+{
+    int32 NodeId;
+    float Priority;
+};
+
+// Per query state of a best-first search over dense node ids. Nodes are stamped with the generation
+// of the search that last touched them, so starting a search costs nothing per node.
+class FPathSearchScratch
+{
+public:
+    FPathSearchScratch();
+
+    // Starts a new search, growing the arrays only when the graph has more nodes than before
+    void BeginSearch(int32 NumNodes);
+
+    // Scores and parents of nodes not touched by the current search read as unreached
+    float GetGScore(int32 NodeId) const;
+    int32 GetParent(int32 NodeId) const;
+    bool IsClosed(int32 NodeId) const;
+
+    // Records a better path to the node and pushes it, or decreases its key if it is already open
+    void SetPath(int32 NodeId, float GScore, int32 Parent, float Priority);
+
+    // Removes the open node with the lowest priority and closes it
+    int32 PopAndClose();
+    bool HasOpenNodes() const;
+    float GetMinPriority() const;
+
+    // Number of nodes closed by the current search
+    int32 GetNumExpanded() const;
+
+private:
+    static constexpr int32 NotQueued = -1;
+    static constexpr int32 Closed = -2;
+
+    void Touch(int32 NodeId);
+    void SiftUp(int32 HeapPosition);
+    void SiftDown(int32 HeapPosition);
+    void Place(int32 HeapPosition, const FPathHeapItem& Item);
+
+    uint32 Generation;
+    int32 NumExpanded;
+
+    // Per node state, only valid where NodeGenerations matches Generation
+    TArray<uint32> NodeGenerations;
+    TArray<float> GScores;
+    TArray<int32> Parents;
+    TArray<int32> HeapPositions; // Position in OpenHeap, NotQueued or Closed
+
+    TArray<FPathHeapItem> OpenHeap;
+};
+
+// Search buffers of one thread, forward and backward scratch for bidirectional searches
+struct FRoadPathSearchContext
+{
+    FPathSearchScratch ForwardScratch;
+    FPathSearchScratch BackwardScratch;
+
+    // Searches of the cluster hierarchy that stay inside one cluster, indexed by the node's position in
+    // its cluster. The parent of a node is the edge it was reached through.
+    FPathSearchScratch StartClusterScratch;
+    FPathSearchScratch GoalClusterScratch;
+
+    // Nodes expanded by the last search, both directions summed up
+    int32 NumExpanded = 0;
+};
+
+// Search contexts shared by requests that run on the thread pool. A request takes a context for the
+// duration of its search and returns it, so the buffers are only allocated for the peak concurrency.
+class FRoadPathSearchContextPool
+{
+public:
+    TUniquePtr<FRoadPathSearchContext> Acquire();
+    void Release(TUniquePtr<FRoadPathSearchContext> Context);
+
+private:
+    FCriticalSection Lock;
+    TArray<TUniquePtr<FRoadPathSearchContext>> FreeContexts;
+};
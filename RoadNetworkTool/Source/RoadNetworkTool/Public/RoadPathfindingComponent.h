@@ -3,30 +3,37 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "Components/SplineComponent.h"
+#include "SplineSegmentBVH.h"
+#include "SplineSpatialIndex.h"
+#include "RoadPathSearch.h"
+#include "RoadGraph.h"
+#include "RoadLandmarks.h"
+#include "RoadContractionHierarchy.h"
+#include "RoadClusterHierarchy.h"
+#include "RoadFlowField.h"
 #include "RoadPathfindingComponent.generated.h"
 
-
-USTRUCT()
-struct FPathNode {
-    GENERATED_BODY()
-
-    FVector Location;
-    TArray<TSharedPtr<FPathNode>> Neighbors;
-
-    FPathNode() : Location(FVector::ZeroVector) {}
-    FPathNode(FVector InLocation) : Location(InLocation) {}
-
-    bool operator==(const FPathNode& Other) const
-    {
-        return Location.Equals(Other.Location);
-    }
-
-    bool operator!=(const FPathNode& Other) const
-    {
-        return !(*this == Other);
-    }
+UENUM(BlueprintType)
+enum class ERoadPathSearchMode : uint8
+{
+    // Contraction hierarchy when it is ready, then the cluster hierarchy when it fits the graph, A* otherwise
+    Auto,
+    AStar,
+    // A* from both ends at once, expands far fewer nodes when start and goal are far apart
+    Bidirectional,
+    // A* over the border nodes of the cluster hierarchy, falls back to A* while there is none for the graph
+    Hierarchical
 };
 
+// Search data captured for searches that finish after the game thread has moved on. The graph and the
+// preprocessing are only edited in place while nothing else holds them, so the snapshot stays consistent.
+struct FRoadPathSearchSnapshot
+{
+    TSharedPtr<const FRoadGraph> Graph;
+    TSharedPtr<const FRoadLandmarks> Landmarks;
+    TSharedPtr<const FRoadContractionHierarchy> ContractionHierarchy;
+    TSharedPtr<const FRoadClusterHierarchy> ClusterHierarchy;
+};
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class ROADNETWORKTOOL_API URoadPathfindingComponent : public UActorComponent
@@ -41,20 +48,97 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding")
     float DefaultSearchRadius = 2500.0f;
 
+    // Vertical distance searched above and below a location, roads stacked further apart are ignored
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding")
+    float VerticalSearchRadius = 500.0f;
+
+    // Landmarks for the ALT heuristic, 0 skips the preprocessing and A* uses the straight-line distance
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding|Landmarks", meta = (ClampMin = "0", ClampMax = "64"))
+    int32 NumLandmarks = 0;
+
+    // Budget for the landmark distance tables (4 bytes per node and landmark), fewer landmarks are used if it is exceeded
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding|Landmarks", meta = (ClampMin = "1.0"))
+    float MaxLandmarkMemoryMB = 64.0f;
+
+    // Contracts the road graph on worker threads once, queries then run a bidirectional upward search
+    // instead of A*. Until the hierarchy is ready, queries keep using A*.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding|Contraction Hierarchy")
+    bool bUseContractionHierarchy = false;
+
+    // Saved copy of the hierarchy, reused on load as long as it matches the road graph
+    UPROPERTY()
+    FRoadContractionHierarchy ContractionHierarchy;
+
+    // Groups the nodes into grid clusters and keeps the distances between their border nodes, searches then
+    // only expand border nodes. Edits recompute just the clusters they touched.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding|Cluster Hierarchy")
+    bool bUseClusterHierarchy = false;
+
+    // Edge length of the square clusters, 0 picks it from the node density
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding|Cluster Hierarchy", meta = (EditCondition = "bUseClusterHierarchy", ClampMin = "0.0"))
+    float ClusterSize = 0.0f;
+
+    // Destinations whose flow fields are kept (8 bytes per node each), 0 builds a new field for every request
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pathfinding|Flow Fields", meta = (ClampMin = "0"))
+    int32 FlowFieldCacheSize = 8;
+
     // Public Methods
-    TArray<TSharedPtr<FPathNode>> FindAllNodes(const TArray<USplineComponent*>& SplineComponents);
+    bool AStarPathfinding(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath);
+
+    // Forward and backward A* with averaged potentials, returns the same shortest paths as AStarPathfinding
+    bool BidirectionalPathfinding(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath);
+
+    // Runs the search selected by Mode, Auto prefers the contraction hierarchy, then the cluster hierarchy and A* last
+    bool FindGraphPath(const FRoadGraph& Graph, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, ERoadPathSearchMode Mode = ERoadPathSearchMode::Auto);
+
+    // Searches on explicit data and a caller owned context don't touch the component, worker threads can run them concurrently
+    static bool AStarPathfinding(const FRoadGraph& Graph, const FRoadLandmarks* ActiveLandmarks, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, FRoadPathSearchContext& Context);
+    static bool BidirectionalPathfinding(const FRoadGraph& Graph, const FRoadLandmarks* ActiveLandmarks, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, FRoadPathSearchContext& Context);
+    static bool FindGraphPath(const FRoadPathSearchSnapshot& Snapshot, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, ERoadPathSearchMode Mode, FRoadPathSearchContext& Context);
+
+    // Captures the graph with the landmarks and the hierarchies that currently fit it
+    FRoadPathSearchSnapshot CreateSearchSnapshot(TSharedPtr<const FRoadGraph> Graph) const;
+
+    // Context of the searches run on the game thread
+    FRoadPathSearchContext& GetSearchContext();
 
-    TArray<TSharedPtr<FPathNode>> AStarPathfinding(TSharedPtr<FPathNode> StartNode, TSharedPtr<FPathNode> GoalNode, const TArray<TSharedPtr<FPathNode>>& AllNodes);
+    // Nodes expanded by the last search, both directions summed up for bidirectional searches
+    int32 GetLastNumExpanded() const;
 
-    TSharedPtr<FPathNode> FindNearestNodeByLocation(const FVector& Location, const TArray<TSharedPtr<FPathNode>>& AllNodes);
+    // Keeps the saved contraction hierarchy if it still fits the graph, otherwise rebuilds it on a worker thread.
+    // bSaveToLevel also stores the result in the saved copy and dirties the level, only in editor worlds.
+    void BuildContractionHierarchy(TSharedPtr<const FRoadGraph> Graph, bool bSaveToLevel = false);
 
-    TArray<FVector> GetLocationsFromPathNodes(const TArray<TSharedPtr<FPathNode>>& PathNodes);
+    bool IsContractionHierarchyReady() const;
 
-    USplineComponent* FindSplineContainingNodes(TSharedPtr<FPathNode> NodeA, TSharedPtr<FPathNode> NodeB) const;
+    // Next hop table towards the goal node, built by one reverse Dijkstra search and cached per destination
+    TSharedPtr<const FRoadFlowField> GetFlowField(const TSharedPtr<const FRoadGraph>& Graph, int32 GoalNodeId);
+
+    // Rebuilds the landmark tables for the graph, or releases them when NumLandmarks is 0
+    void BuildLandmarks(const FRoadGraph& Graph);
+
+    // Same on a worker thread, searches fall back to the straight line distance until the tables are ready.
+    // Requests made while a build runs are coalesced, only the latest graph is built next.
+    void BuildLandmarksAsync(TSharedPtr<const FRoadGraph> Graph);
+
+    // Updates the cluster hierarchy for an edited graph, or builds it from scratch when there is none or the
+    // cluster size changed. Releases it when bUseClusterHierarchy is off.
+    void BuildClusterHierarchy(const FRoadGraph& Graph);
+
+    // Brings the derived data in line with a graph Edit took from PreviousRevision to its current revision. The
+    // cluster hierarchy only looks at the touched nodes, landmarks and the contraction hierarchy rebuild on worker
+    // threads and only the flow fields the edit affects are dropped.
+    void OnRoadGraphEdited(const TSharedPtr<const FRoadGraph>& Graph, uint32 PreviousRevision, const FRoadGraphEdit& Edit);
 
     void FindSplinesInArea(const FVector& Location, float SearchRadius, TArray<USplineComponent*>& OutSplines) const;
 
-    USplineComponent* FindNearestSplineComponent(const FVector& Location);
+    USplineComponent* FindNearestSplineComponent(const FVector& Location, double MaxDistance = TNumericLimits<double>::Max());
+
+    FSplineSegmentHit FindNearestSplineHit(const FVector& Location, double MaxDistance = TNumericLimits<double>::Max()) const;
+
+    // Applies pending spline changes to the segment BVH and the nearest road raster. Nearest spline lookups
+    // do this lazily, call it before running them on worker threads so the workers only read.
+    void UpdateDirtySpatialData() const;
 
     void DrawSplineAndBoxDebug(const TArray<USplineComponent*>& SplineComponents, const FVector BoxCenter, const FVector BoxExtent) const;
 
@@ -64,4 +148,52 @@ public:
     bool AreSplineConnected(USplineComponent* SplineA, USplineComponent* SplineB, float Tolerance = KINDA_SMALL_NUMBER);
 
     void FindSplinesInLineArea(const FVector& LineStart, const FVector& LineEnd, TArray<USplineComponent*>& OutSplines) const;
+
+    bool VisitSplinesAlongLine(const FVector& LineStart, const FVector& LineEnd, float Radius, FSplineVisitorFunction Visitor) const;
+
+private:
+    // Reused by every search on the game thread, so a query only pays for the nodes it reaches
+    FRoadPathSearchContext SearchContext;
+
+    const FRoadLandmarks* GetActiveLandmarks(const FRoadGraph& Graph) const;
+
+    const FRoadClusterHierarchy* GetActiveClusterHierarchy(const FRoadGraph& Graph) const;
+
+    // Copies a baked hierarchy into the saved property
+    void SaveContractionHierarchy(const FRoadContractionHierarchy& Hierarchy);
+
+    void StartContractionHierarchyBuild(TSharedPtr<const FRoadGraph> Graph, bool bSaveResult);
+
+    // Landmark count for the graph, limited by the memory budget
+    int32 GetLandmarkCount(int32 NumNodes) const;
+
+    void StartLandmarkBuild(TSharedPtr<const FRoadGraph> Graph);
+
+    // Edit only limits the update to its touched nodes, it must be the last edit of the graph the hierarchy is in line with
+    void UpdateClusterHierarchy(const FRoadGraph& Graph, const FRoadGraphEdit* Edit);
+
+    static bool FindGraphPath(const FRoadGraph& Graph, const FRoadLandmarks* ActiveLandmarks, const FRoadContractionHierarchy* ActiveHierarchy,
+        const FRoadClusterHierarchy* ActiveClusterHierarchy, int32 StartNodeId, int32 GoalNodeId, FRoadGraphPath& OutPath, ERoadPathSearchMode Mode, FRoadPathSearchContext& Context);
+
+    // Hierarchy used by the searches, null until one fits the current graph
+    TSharedPtr<const FRoadContractionHierarchy> ActiveContractionHierarchy;
+
+    // Incremented by every build request, results of outdated builds are dropped
+    uint32 ContractionHierarchyBuildId = 0;
+
+    // Only one build runs at a time, the latest graph requested meanwhile is built once it is done
+    bool bContractionHierarchyBuildRunning = false;
+    TWeakPtr<const FRoadGraph> PendingContractionHierarchyGraph;
+    bool bSavePendingContractionHierarchy = false;
+
+    TSharedPtr<const FRoadLandmarks> Landmarks;
+
+    // Same scheme as the contraction hierarchy builds
+    uint32 LandmarkBuildId = 0;
+    bool bLandmarkBuildRunning = false;
+    TWeakPtr<const FRoadGraph> PendingLandmarkGraph;
+
+    TSharedPtr<const FRoadClusterHierarchy> ClusterHierarchy;
+
+    FRoadFlowFieldCache FlowFieldCache;
 };
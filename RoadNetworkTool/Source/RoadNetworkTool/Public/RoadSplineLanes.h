@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SplineComponent.h"
+
+// Centre line and lane polylines of one spline, sampled once at a fixed spacing along its length. Every lane is
+// stored on both sides of the centre line, offset along the right vector of the spline tangent, so a path takes
+// the side of its travel direction without any geometry per query.
+class FRoadSplineLanes
+{
+public:
+    // Same spacing the paths were refined with when they still sampled the splines per query
+    static constexpr float DefaultSampleSpacing = 400.0f;
+
+    // Distance samples per spline segment for mapping input keys, distance isn't linear in the key within a segment
+    static constexpr int32 KeyStepsPerSegment = 16;
+
+    // Lane i runs LaneOffsets[i] right of the centre line in the direction of travel
+    void Build(const USplineComponent* SplineComponent, TConstArrayView<float> LaneOffsets, float InSampleSpacing = DefaultSampleSpacing);
+
+    int32 GetNumLanes() const;
+    int32 GetNumSamples() const;
+    SIZE_T GetAllocatedSize() const;
+
+    // Appends the points from StartKey to EndKey in travel direction, Lane INDEX_NONE is the centre line.
+    // Points repeating the last one in OutPoints are skipped, such as the node shared by two spans.
+    void AppendPoints(float StartKey, float EndKey, int32 Lane, TArray<FVector>& OutPoints) const;
+
+private:
+    // Interpolates between the distances sampled at KeyStepsPerSegment keys per segment
+    float GetDistanceAtKey(float InputKey) const;
+    FVector GetPointAtDistance(const TArray<FVector>& Points, float Distance) const;
+
+    float SampleSpacing = DefaultSampleSpacing;
+
+    // Distance along the spline at input keys 0, 1 / KeyStepsPerSegment, ... up to the last spline point
+    TArray<float> KeyDistances;
+
+    // Samples at multiples of the spacing, followed by one at the spline end
+    TArray<float> SampleDistances;
+    TArray<FVector> CenterPoints;
+
+    // Two polylines per lane, first the one right of the spline direction, then the one right of the opposite direction
+    TArray<TArray<FVector>> LanePoints;
+};
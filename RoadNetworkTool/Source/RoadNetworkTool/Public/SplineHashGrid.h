@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SplineComponent.h"
+#include "SplineSpatialIndex.h"
+
+// Occupied cell of the hash grid, empty cells are released
+struct FSplineHashGridCell
+{
+    FIntPoint Coord;
+    TArray<int32> EntryIds;
+
+    FSplineHashGridCell() : Coord(FIntPoint::ZeroValue) {}
+};
+
+// Uniform grid of square cells hashed by their integer coordinates. Cheaper than the quadtree
+// when splines have a similar size and are spread evenly, as a query only touches the cells it covers.
+class FSplineHashGrid : public ISplineSpatialIndex
+{
+private:
+    double CellSize;
+    double InvCellSize;
+    FBox2D Bounds;
+
+    // Cell pool and the hash from cell coordinates into it
+    TArray<FSplineHashGridCell> Cells;
+    TArray<int32> FreeCells;
+    TMap<FIntPoint, int32> CoordToCell;
+
+    // Range of cell coordinates that have held entries, it only grows
+    FIntPoint OccupiedMin;
+    FIntPoint OccupiedMax;
+
+    // Entry data in struct-of-arrays layout, indexed by entry id
+    TArray<USplineComponent*> EntrySplines;
+    TArray<FBox2D> EntryBounds;
+    TArray<FSplineZRange> EntryZRanges;
+    TArray<TArray<int32, TInlineAllocator<4>>> EntryCells; // Reverse index: cells that hold each entry
+    TArray<int32> OversizedEntries; // Entries covering too many cells, tested by every query instead
+    TArray<int32> FreeEntries;
+    TMap<USplineComponent*, int32> SplineToEntry;
+
+    // Per entry stamp of the last query that reported it, so each spline is reported once
+    mutable TArray<uint32> EntryQueryStamps;
+    mutable uint32 QueryEpoch;
+
+public:
+    // Entries that would be stored in more cells than this go to the oversized list
+    static constexpr int32 MaxCellsPerEntry = 64;
+
+    // Constructor
+    FSplineHashGrid(const FBox2D& WorldBounds, double InCellSize);
+
+    // Public Methods
+    virtual void InsertSplineComponent(USplineComponent* SplineComponent) override;
+    virtual void BulkLoad(const TArray<USplineComponent*>& SplineComponents) override;
+    virtual void RemoveSplineComponent(USplineComponent* SplineComponent) override;
+    virtual void UpdateSplineComponent(USplineComponent* SplineComponent) override;
+    virtual void Clear() override;
+    virtual void GetAllSplines(TArray<USplineComponent*>& OutSplines) const override;
+    virtual FBox2D GetBounds() const override;
+    virtual int32 GrowToContain(const FBox2D& Area) override;
+    virtual int32 GetNumNodes() const override;
+    virtual ESplineSpatialIndexType GetType() const override;
+    double GetCellSize() const;
+
+    // Shape queries over the covered cells, plus the oversized entries
+    virtual bool VisitSplinesInArea(const FBox2D& Area, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const override;
+    virtual bool VisitSplinesInCircle(const FVector2D& Center, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const override;
+    virtual bool VisitSplinesInCapsule(const FVector2D& Start, const FVector2D& End, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const override;
+
+    // Best-first nearest neighbour search, expanding one ring of cells at a time
+    virtual void FindNearestSplines(const FVector2D& Point, int32 K, double MaxDistance, TArray<USplineComponent*>& OutSplines, FSplineDistanceSquaredFunction DistanceSquaredFn) const override;
+
+private:
+    // Private Methods
+    FIntPoint GetCellCoord(const FVector2D& Point) const;
+    FBox2D GetCellBounds(const FIntPoint& Coord) const;
+    bool HasOccupiedCells() const;
+    int32 AllocateEntry(USplineComponent* SplineComponent, const FBox& SplineBounds);
+    void ReleaseEntry(int32 EntryId);
+    void AddEntryToCells(int32 EntryId);
+    void RemoveEntryFromCells(int32 EntryId);
+    uint32 BeginQuery() const;
+
+    template <typename ShapeType>
+    bool VisitSplinesInShape(const ShapeType& Shape, const FSplineZRange& ZRange, FSplineVisitorFunction Visitor) const;
+};
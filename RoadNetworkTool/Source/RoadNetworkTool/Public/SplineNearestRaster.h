@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SplineSegmentBVH.h"
+
+// Baked 2D raster holding, for every cell, the spline nearest to the cell center and a coarse input key on it.
+// Cells further than MaxDistance from every road are left empty, which also bounds the region an edit re-bakes.
+class FSplineNearestRaster
+{
+public:
+    // Rasters above this many cells are built with a larger cell size instead
+    static constexpr int32 MaxCells = 4096 * 1024;
+
+    FSplineNearestRaster(float InCellSize = 200.0f, float InMaxDistance = 5000.0f);
+
+    // Bakes every cell over Area from the samples of the segment BVH
+    void Build(const FSplineSegmentBVH& SegmentBVH, const FBox2D& Area);
+    void Clear();
+
+    // Edits are batched, mark a spline once its samples have changed and Update re-bakes only the cells it can affect
+    void MarkSplineDirty(int32 SplineId);
+    void Update(const FSplineSegmentBVH& SegmentBVH);
+    bool IsDirty() const;
+
+    // One cell read plus a local refinement on the baked spline. Returns false outside the raster and in empty cells.
+    // Near the border between two roads the baked spline may be up to a cell diagonal further than the true nearest one.
+    bool FindNearestPoint(const FSplineSegmentBVH& SegmentBVH, const FVector& Location, FSplineSegmentHit& OutHit) const;
+
+    bool IsBuilt() const;
+    float GetCellSize() const;
+    FIntPoint GetNumCells() const;
+    FBox2D GetBounds() const;
+
+private:
+    void UpdateSplineBounds(const FSplineSegmentBVH& SegmentBVH, int32 SplineId);
+    void BakeRegion(const FSplineSegmentBVH& SegmentBVH, const FIntRect& BakedCells);
+    FIntRect GetCellRect(const FBox2D& Area) const;
+
+    float CellSize;
+    float MaxDistance;
+    FVector2D Origin;
+    int32 NumCellsX;
+    int32 NumCellsY;
+
+    // Per cell nearest spline id, INDEX_NONE when no road is within MaxDistance, and the key of the nearest sample
+    TArray<int32> CellSplineIds;
+    TArray<float> CellInputKeys;
+
+    // 2D bounds of every spline as it was last baked, indexed by BVH spline id
+    TArray<FBox2D> SplineBounds;
+    TArray<int32> DirtySplineIds;
+    FBox2D DirtyArea;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SplineComponent.h"
+
+// Result of a nearest-point query against the segment BVH
+struct FSplineSegmentHit
+{
+    USplineComponent* SplineComponent = nullptr;
+    int32 SplineId = INDEX_NONE;
+    float InputKey = 0.0f;
+    FVector Location = FVector::ZeroVector;
+    double DistanceSquared = TNumericLimits<double>::Max();
+
+    bool IsValid() const
+    {
+        return SplineComponent != nullptr;
+    }
+};
+
+// Flattened BVH node, the left child of an interior node always directly follows it
+struct FSplineSegmentBVHNode
+{
+    FBox Bounds;
+    int32 FirstIndex; // First segment for leaves, right child index for interior nodes
+    int32 Count; // Number of segments for leaves, 0 for interior nodes
+
+    FSplineSegmentBVHNode() : Bounds(ForceInit), FirstIndex(INDEX_NONE), Count(0) {}
+
+    bool IsLeafNode() const
+    {
+        return Count > 0;
+    }
+};
+
+// Sampled copy of one spline, the curve is kept so queries can refine without touching the component
+struct FSplineSampleData
+{
+    USplineComponent* SplineComponent = nullptr;
+    FInterpCurveVector Position;
+    FTransform Transform;
+    float MaxInputKey = 0.0f;
+    TArray<FVector> Points;
+    TArray<float> Keys;
+};
+
+// Bounding-volume hierarchy over short sampled segments of every road spline
+class FSplineSegmentBVH
+{
+public:
+    FSplineSegmentBVH(float InSampleSpacing = 100.0f, int32 InMaxSegmentsPerLeaf = 4);
+
+    // Spline management, changes are batched until the next Rebuild
+    void Build(const TArray<USplineComponent*>& SplineComponents);
+    void AddOrUpdateSpline(USplineComponent* SplineComponent);
+    void RemoveSpline(USplineComponent* SplineComponent);
+    void Rebuild();
+    bool IsDirty() const;
+
+    // Queries
+    bool FindNearestPoint(const FVector& Location, FSplineSegmentHit& OutHit, double MaxDistance = TNumericLimits<double>::Max()) const;
+    USplineComponent* GetSplineComponent(int32 SplineId) const;
+    int32 GetSplineId(const USplineComponent* SplineComponent) const;
+    int32 GetNumSegments() const;
+
+    // Nearest point on one spline, only searching the samples within about SearchDistance along the spline of NearInputKey.
+    // The samples are current even while the BVH itself is dirty.
+    bool FindNearestPointOnSpline(int32 SplineId, const FVector& Location, float NearInputKey, double SearchDistance, FSplineSegmentHit& OutHit) const;
+
+    // Sampled splines by id, freed ids hold empty samples
+    int32 GetNumSplineIds() const;
+    const FSplineSampleData* GetSplineSamples(int32 SplineId) const;
+    float GetSampleSpacing() const;
+
+private:
+    void SampleSpline(FSplineSampleData& Data) const;
+    int32 BuildRange(TArray<int32>& Order, const TArray<FVector>& Centroids, int32 Begin, int32 End);
+    float RefineInputKey(const FSplineSampleData& Data, const FVector& Location, float MinKey, float MaxKey) const;
+    void RefineHit(int32 SplineId, const FVector& Location, const FVector& SegmentStart, const FVector& SegmentEnd, float StartKey, float EndKey,
+        double Alpha, double PolylineDistanceSquared, FSplineSegmentHit& OutHit) const;
+
+    float SampleSpacing;
+    int32 MaxSegmentsPerLeaf;
+    bool bDirty;
+
+    // Per spline samples, indexed by spline id
+    TArray<FSplineSampleData> Splines;
+    TArray<int32> FreeSplineIds;
+    TMap<USplineComponent*, int32> SplineToId;
+
+    // Segments in struct-of-arrays layout, ordered so each leaf covers a contiguous range
+    TArray<FVector> SegmentStarts;
+    TArray<FVector> SegmentEnds;
+    TArray<int32> SegmentSplineIds;
+    TArray<float> SegmentStartKeys;
+    TArray<float> SegmentEndKeys;
+
+    TArray<FSplineSegmentBVHNode> Nodes;
+};
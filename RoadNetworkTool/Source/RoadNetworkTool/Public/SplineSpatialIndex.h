@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SplineComponent.h"
+#include "Templates/Function.h"
+#include "SplineSpatialIndex.generated.h"
+
+UENUM(BlueprintType)
+enum class ESplineSpatialIndexType : uint8
+{
+    Auto UMETA(DisplayName = "Auto"),
+    Quadtree UMETA(DisplayName = "Quadtree"),
+    HashGrid UMETA(DisplayName = "Hash Grid")
+};
+
+// Vertical extent of an entry or a query, so stacked roads on bridges and ramps can be told apart.
+// The default range is unbounded and matches every entry.
+struct FSplineZRange
+{
+    double Min;
+    double Max;
+
+    FSplineZRange() : Min(-TNumericLimits<double>::Max()), Max(TNumericLimits<double>::Max()) {}
+    FSplineZRange(double InMin, double InMax) : Min(InMin), Max(InMax) {}
+
+    bool Overlaps(const FSplineZRange& Other) const
+    {
+        return Min <= Other.Max && Other.Min <= Max;
+    }
+};
+
+// Refines a nearest-neighbour candidate to its exact squared distance from the query point.
+// The value must not be smaller than the squared 2D distance to the spline's bounds.
+using FSplineDistanceSquaredFunction = TFunctionRef<double(USplineComponent*)>;
+
+// Receives each spline found by a shape query, return false to stop the query early
+using FSplineVisitorFunction = TFunctionRef<bool(USplineComponent*)>;
+
+// Backend and parameters of a spatial index, either set by hand or picked from the spline distribution
+struct FSplineSpatialIndexConfig
+{
+    ESplineSpatialIndexType Type = ESplineSpatialIndexType::Quadtree;
+    int32 MaxSplinesPerNode = 5;
+    int32 MaxDepth = 5;
+    double CellSize = 0.0;
+
+    // Estimated relative cost of one area query of the radius the config was chosen for, in entry tests
+    double EstimatedQueryCost = 0.0;
+
+    FString ToString() const;
+};
+
+// Common interface of the spline spatial indices. Every query reports each spline at most once,
+// and a visitor must not start another query on the same index.
+class ISplineSpatialIndex
+{
+public:
+    virtual ~ISplineSpatialIndex() = default;
+
+    // Spline management
+    virtual void InsertSplineComponent(USplineComponent* SplineComponent) = 0;
+    virtual void BulkLoad(const TArray<USplineComponent*>& SplineComponents) = 0;
+    virtual void RemoveSplineComponent(USplineComponent* SplineComponent) = 0;
+    virtual void UpdateSplineComponent(USplineComponent* SplineComponent) = 0;
+    virtual void Clear() = 0;
+    virtual void GetAllSplines(TArray<USplineComponent*>& OutSplines) const = 0;
+
+    // Area covered by the index, and a way to extend it without rebuilding
+    virtual FBox2D GetBounds() const = 0;
+    virtual int32 GrowToContain(const FBox2D& Area) = 0;
+
+    // Number of tree nodes or grid cells in use, for logging
+    virtual int32 GetNumNodes() const = 0;
+    virtual ESplineSpatialIndexType GetType() const = 0;
+
+    // Shape queries, a capsule with zero radius is a plain segment.
+    // Entries whose vertical extent misses ZRange are skipped before they are reported.
+    virtual bool VisitSplinesInArea(const FBox2D& Area, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const = 0;
+    virtual bool VisitSplinesInCircle(const FVector2D& Center, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const = 0;
+    virtual bool VisitSplinesInCapsule(const FVector2D& Start, const FVector2D& End, double Radius, FSplineVisitorFunction Visitor, const FSplineZRange& ZRange = FSplineZRange()) const = 0;
+
+    void QuerySplinesInArea(const FBox2D& Area, TArray<USplineComponent*>& OutSplines, const FSplineZRange& ZRange = FSplineZRange()) const;
+    void QuerySplinesInCircle(const FVector2D& Center, double Radius, TArray<USplineComponent*>& OutSplines, const FSplineZRange& ZRange = FSplineZRange()) const;
+    void QuerySplinesInCapsule(const FVector2D& Start, const FVector2D& End, double Radius, TArray<USplineComponent*>& OutSplines, const FSplineZRange& ZRange = FSplineZRange()) const;
+
+    // Nearest neighbour queries, they expand outwards only as far as needed
+    virtual void FindNearestSplines(const FVector2D& Point, int32 K, double MaxDistance, TArray<USplineComponent*>& OutSplines, FSplineDistanceSquaredFunction DistanceSquaredFn) const = 0;
+
+    USplineComponent* FindNearestSpline(const FVector2D& Point, FSplineDistanceSquaredFunction DistanceSquaredFn) const;
+    USplineComponent* FindNearestSplineWithin(const FVector2D& Point, double MaxDistance, FSplineDistanceSquaredFunction DistanceSquaredFn) const;
+    void FindKNearestSplines(const FVector2D& Point, int32 K, TArray<USplineComponent*>& OutSplines, FSplineDistanceSquaredFunction DistanceSquaredFn) const;
+
+    // Computes the world bounds of a spline, the only place an index reads from the component
+    static FBox CalcSplineBounds(const USplineComponent* SplineComponent);
+    static FBox2D CalcSplineBounds2D(const USplineComponent* SplineComponent);
+
+    // Samples the size and density of the splines and picks the backend with the lowest estimated cost
+    // for area queries of the given radius
+    static FSplineSpatialIndexConfig ChooseConfig(const TArray<USplineComponent*>& SplineComponents, double QueryRadius);
+
+    static TSharedPtr<ISplineSpatialIndex> Create(const FSplineSpatialIndexConfig& Config, const FBox2D& WorldBounds);
+};
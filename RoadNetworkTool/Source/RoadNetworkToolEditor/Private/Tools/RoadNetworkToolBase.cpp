@@ -72,8 +72,8 @@ bool URoadNetworkToolBase::GetNearSplinePoint(const FVector& Location, FVector&
 	FVector NearestSplinePoint;
 	bIsSplineNodeLocation = false;
 
-	// Find the nearest spline component
-	USplineComponent* NearSplineComponent = SplineActor->PathfindingComponent->FindNearestSplineComponent(Location);
+	// Find the nearest spline component, only splines within the threshold can hold a point to snap to
+	USplineComponent* NearSplineComponent = SplineActor->PathfindingComponent->FindNearestSplineComponent(Location, Threshold);
 
 	// Check if a valid spline component was found
 	if (!NearSplineComponent || NearSplineComponent->GetNumberOfSplinePoints() < 2)
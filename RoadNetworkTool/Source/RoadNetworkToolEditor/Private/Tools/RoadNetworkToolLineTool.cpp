@@ -365,39 +365,41 @@ bool URoadNetworkToolLineTool::IsLineIntersectingSpline(const FVector& LineStart
 		return false;
 	}
 
-	TArray<USplineComponent*> NearbySplines;
-
-	SplineActor->PathfindingComponent->FindSplinesInLineArea(LineStart, LineEnd, NearbySplines);
-
-	for (USplineComponent* SplineComponent : NearbySplines)
-	{
-		int32 NumSplinePoints = SplineComponent->GetNumberOfSplinePoints();
-		if (NumSplinePoints < 2)
-		{
-			continue; // Skip if the spline doesn't have at least two points
-		}
+	bool bIntersects = false;
 
-		// Check intersection for each segment of the spline
-		for (int32 PointIndex = 0; PointIndex < NumSplinePoints - 1; ++PointIndex)
+	// Only splines whose bounds the line actually crosses are tested, stopping at the first intersection
+	SplineActor->PathfindingComponent->VisitSplinesAlongLine(LineStart, LineEnd, 0.0f, [&](USplineComponent* SplineComponent)
 		{
-			// Get the start and end points of the current spline segment
-			FVector SplineStart = SplineComponent->GetLocationAtSplinePoint(PointIndex, ESplineCoordinateSpace::World);
-			FVector SplineEnd = SplineComponent->GetLocationAtSplinePoint(PointIndex + 1, ESplineCoordinateSpace::World);
+			int32 NumSplinePoints = SplineComponent->GetNumberOfSplinePoints();
+			if (NumSplinePoints < 2)
+			{
+				return true; // Skip if the spline doesn't have at least two points
+			}
 
-			// Check for intersection between the lines in the XY plane
-			if (DoLinesIntersect(LineStart, LineEnd, SplineStart, SplineEnd))
+			// Check intersection for each segment of the spline
+			for (int32 PointIndex = 0; PointIndex < NumSplinePoints - 1; ++PointIndex)
 			{
-				// Ensure the intersection is not at the endpoints of the line
-				if (!LineStart.Equals(SplineStart, 1.0f) && !LineStart.Equals(SplineEnd, 1.0f) &&
-					!LineEnd.Equals(SplineStart, 1.0f) && !LineEnd.Equals(SplineEnd, 1.0f))
+				// Get the start and end points of the current spline segment
+				FVector SplineStart = SplineComponent->GetLocationAtSplinePoint(PointIndex, ESplineCoordinateSpace::World);
+				FVector SplineEnd = SplineComponent->GetLocationAtSplinePoint(PointIndex + 1, ESplineCoordinateSpace::World);
+
+				// Check for intersection between the lines in the XY plane
+				if (DoLinesIntersect(LineStart, LineEnd, SplineStart, SplineEnd))
 				{
-					return true;
+					// Ensure the intersection is not at the endpoints of the line
+					if (!LineStart.Equals(SplineStart, 1.0f) && !LineStart.Equals(SplineEnd, 1.0f) &&
+						!LineEnd.Equals(SplineStart, 1.0f) && !LineEnd.Equals(SplineEnd, 1.0f))
+					{
+						bIntersects = true;
+						return false;
+					}
 				}
 			}
-		}
-	}
 
-	return false;
+			return true;
+		});
+
+	return bIntersects;
 }
 
 bool URoadNetworkToolLineTool::DoLinesIntersect(const FVector& A1, const FVector& A2, const FVector& B1, const FVector& B2)